@@ -0,0 +1,34 @@
+# shellcheck shell=bash
+if [ -n "$__perf_window_warmup_sh__" ]; then return; fi
+__perf_window_warmup_sh__=$(date)
+
+__perf_window_warmup_sh__include_path="$(cd "$(dirname "${BASH_SOURCE[0]}")" && cd ../../include && pwd)"
+
+# Scrapes a #define from a runtime header, falling back to a default if it is missing
+# $1 the header, relative to runtime/include
+# $2 the name of the define
+# $3 the default
+__perf_window_warmup_sh__scrape() {
+	local -r header="$__perf_window_warmup_sh__include_path/$1"
+	local value
+	value=$(grep "#define $2 " < "$header" 2> /dev/null | awk '{print $3}')
+	if [[ ! "$value" =~ ^[0-9]+$ ]]; then
+		printf "Failed to scrape %s from %s. Defaulting to %s\n" "$2" "$1" "$3" 1>&2
+		value="$3"
+	fi
+	echo "$value"
+}
+
+# Prints the number of executions of a module the runtime needs to learn its expected execution time
+get_perf_window_warmup_count() {
+	__perf_window_warmup_sh__scrape perf_window_t.h PERF_WINDOW_WARMUP_COUNT 16
+}
+
+# Waits until the perf window aggregator has merged the executions of the warm-up into the estimates
+wait_for_perf_window_merge() {
+	local -i interval_us
+	interval_us=$(__perf_window_warmup_sh__scrape perf_window_aggregator.h PERF_WINDOW_AGGREGATOR_INTERVAL_US 1000)
+
+	# Two intervals, as the warm-up may complete just after a merge began
+	sleep "$(awk -v us="$interval_us" 'BEGIN { printf "%f", 2 * us / 1000000 }')"
+}
@@ -0,0 +1,190 @@
+#!/bin/bash
+# This experiment is intended to document how the cache flush backend influences latency as preemptions increase, and
+# the direct and warm-up costs of its flushes
+
+# Add bash_libraries directory to path
+__run_sh__base_path="$(dirname "$(realpath --logical "${BASH_SOURCE[0]}")")"
+__run_sh__bash_libraries_relative_path="../bash_libraries"
+__run_sh__bash_libraries_absolute_path=$(cd "$__run_sh__base_path" && cd "$__run_sh__bash_libraries_relative_path" && pwd)
+export PATH="$__run_sh__bash_libraries_absolute_path:$PATH"
+
+# Source libraries from bash_libraries directory
+source path_join.sh || exit 1
+source framework.sh || exit 1
+source get_result_count.sh || exit 1
+source generate_gnuplots.sh || exit 1
+source percentiles_table.sh || exit 1
+
+if ! command -v hey > /dev/null; then
+	echo "hey is not present."
+	exit 1
+fi
+
+# Experiment Globals and Setups
+declare -ar concurrency=(1 2 4 8 16 32 64)
+declare -ri iterations=2000
+# Pages touched by each request. Large enough for the working set to survive in L2 between preemptions
+declare -ri pages=16
+
+run_experiments() {
+	if (($# != 2)); then
+		panic "invalid number of arguments \"$1\""
+		return 1
+	elif [[ ! -d "$2" ]]; then
+		panic "directory \"$2\" does not exist"
+		return 1
+	fi
+
+	local hostname="$1"
+	local results_directory="$2"
+
+	# Execute the experiments
+	printf "Running Experiments:\n"
+	for conn in "${concurrency[@]}"; do
+		printf "\t%d Concurrency: " "$conn"
+		hey -disable-compression -disable-keepalive -disable-redirects -n "$iterations" -c "$conn" -cpus 2 -o csv -m GET -d "$pages" "http://$hostname:10000" > "$results_directory/con$conn.csv" 2> /dev/null || {
+			printf "[ERR]\n"
+			panic "concurrency $conn experiment failed"
+			return 1
+		}
+		get_result_count "$results_directory/con$conn.csv" || {
+			printf "[ERR]\n"
+			panic "con$conn.csv unexpectedly has zero requests"
+			return 1
+		}
+		printf "[OK]\n"
+	done
+
+	return 0
+}
+
+process_results() {
+	if (($# != 1)); then
+		panic "invalid number of arguments ($#, expected 1)"
+		return 1
+	elif ! [[ -d "$1" ]]; then
+		panic "directory $1 does not exist"
+		return 1
+	fi
+
+	local -r results_directory="$1"
+
+	printf "Processing Results: "
+
+	percentiles_table_header "$results_directory/latency.csv" "Con"
+
+	for conn in "${concurrency[@]}"; do
+		# Filter on 200s, convert from s to ms, and sort
+		awk -F, '$7 == 200 {print ($1 * 1000)}' < "$results_directory/con$conn.csv" \
+			| sort -g > "$results_directory/con$conn-response.csv"
+
+		# Get Number of 200s
+		oks=$(wc -l < "$results_directory/con$conn-response.csv")
+		((oks == 0)) && continue # If all errors, skip line
+
+		# Generate Latency Data for csv
+		percentiles_table_row "$results_directory/con$conn-response.csv" "$results_directory/latency.csv" "$conn"
+
+		# Delete scratch file used for sorting/counting
+		rm -rf "$results_directory/con$conn-response.csv"
+	done
+
+	# Transform csvs to dat files for gnuplot
+	printf "#" > "$results_directory/latency.dat"
+	tr ',' ' ' < "$results_directory/latency.csv" | column -t >> "$results_directory/latency.dat"
+
+	# Generate gnuplots
+	generate_gnuplots "$results_directory" "$__run_sh__base_path" || {
+		printf "[ERR]\n"
+		panic "failed to generate gnuplots"
+	}
+
+	printf "[OK]\n"
+	return 0
+}
+
+# Sums the per-worker "Cache Protection" stats that sledgert prints at exit
+process_server_results() {
+	if (($# != 1)); then
+		panic "invalid number of arguments ($#, expected 1)"
+		return 1
+	elif ! [[ -f "$1/log.txt" ]]; then
+		panic "file $1/log.txt does not exist"
+		return 1
+	fi
+
+	local -r results_directory="$1"
+
+	printf "Processing Server Results: "
+
+	# Worker <i>: <n> flushes (<us> us), <n> avoided, <n> affinity picks, <us> us slack used, <n> completions (<us> us executing)
+	awk '/^Worker [0-9]+: .* completions/ {
+			gsub(/[(),]/, "")
+			flushes += $3
+			flush_us += $5
+			completions += $16
+			execution_us += $18
+		}
+		END {
+			if (completions == 0) exit 1
+			printf "Flushes,Flush_us,Mean_Flush_us,Completions,Mean_Execution_us,Flushes_per_Request\n"
+			printf "%d,%d,%.3f,%d,%.3f,%.3f\n", flushes, flush_us, (flushes > 0 ? flush_us / flushes : 0),
+				completions, execution_us / completions, flushes / completions
+		}' < "$results_directory/log.txt" > "$results_directory/cache.csv" || {
+		printf "[ERR]\n"
+		panic "log.txt has no cache protection stats"
+		return 1
+	}
+
+	printf "[OK]\n"
+	return 0
+}
+
+# Compares each backend against the run without flushing. The direct cost of flushing is the time spent in the
+# backend. The warm-up cost is the additional execution time of sandboxes refilling the caches after a flush
+compare_backends() {
+	local -r experiment_directory="$1"
+	local -r baseline="$experiment_directory/none/cache.csv"
+
+	# The variants run in alphabetical order, so the comparison is complete once the baseline has run
+	[[ -f "$baseline" ]] || return 0
+
+	local -r baseline_execution_us=$(awk -F, 'NR == 2 {print $5}' < "$baseline")
+
+	printf "Backend,Flushes_per_Request,Mean_Flush_us,Direct_per_Request_us,Warmup_per_Request_us,Warmup_per_Flush_us\n" \
+		> "$experiment_directory/backends.csv"
+	for cache_csv in "$experiment_directory"/*/cache.csv; do
+		local backend
+		backend="$(basename "$(dirname "$cache_csv")")"
+		[[ "$backend" == "none" ]] && continue
+
+		awk -F, -v backend="$backend" -v baseline="$baseline_execution_us" 'NR == 2 {
+			warmup = $5 - baseline
+			printf "%s,%.3f,%.3f,%.3f,%.3f,%.3f\n", backend, $6, $3, $2 / $4, warmup, ($6 > 0 ? warmup / $6 : 0)
+		}' < "$cache_csv" >> "$experiment_directory/backends.csv"
+	done
+}
+
+# Expected Symbol used by the framework
+experiment_server_post() {
+	local -r results_directory="$1"
+
+	# The stats are printed as sledgert exits, which may be after pkill returns
+	while pgrep -x sledgert > /dev/null; do sleep 0.1; done
+
+	process_server_results "$results_directory" || return 1
+	compare_backends "$(dirname "$results_directory")"
+}
+
+# Expected Symbol used by the framework
+experiment_client() {
+	local -r target_hostname="$1"
+	local -r results_directory="$2"
+
+	run_experiments "$target_hostname" "$results_directory" || return 1
+	process_results "$results_directory" || return 1
+
+	return 0
+}
+
+framework_init "$@"
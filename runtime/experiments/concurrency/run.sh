@@ -15,6 +15,7 @@ source get_result_count.sh || exit 1
 source panic.sh || exit 1
 source percentiles_table.sh || exit 1
 source path_join.sh || exit 1
+source perf_window_warmup.sh || exit 1
 
 if ! command -v hey > /dev/null; then
 	echo "hey is not present."
@@ -35,25 +36,20 @@ run_samples() {
 
 	local hostname="$1"
 
-	# Scrape the perf window size from the source if possible
-	# TODO: Make a util function
-	local -r perf_window_path="$(path_join "$__run_sh__base_path" ../../include/perf_window_t.h)"
-	local -i perf_window_buffer_size
-	if ! perf_window_buffer_size=$(grep "#define PERF_WINDOW_BUFFER_SIZE" < "$perf_window_path" | cut -d\  -f3); then
-		printf "Failed to scrape PERF_WINDOW_BUFFER_SIZE from ../../include/perf_window.h\n"
-		printf "Defaulting to 16\n"
-		perf_window_buffer_size=16
-	fi
-	local -ir perf_window_buffer_size
+	local -i perf_window_warmup_count
+	perf_window_warmup_count=$(get_perf_window_warmup_count)
+	local -ir perf_window_warmup_count
 
 	printf "Running Samples: "
-	hey -disable-compression -disable-keepalive -disable-redirects -n "$perf_window_buffer_size" -c "$perf_window_buffer_size" -q 200 -cpus 3 -o csv -m GET "http://${hostname}:10000" 1> /dev/null 2> /dev/null || {
+	hey -disable-compression -disable-keepalive -disable-redirects -n "$perf_window_warmup_count" -c "$perf_window_warmup_count" -q 200 -cpus 3 -o csv -m GET "http://${hostname}:10000" 1> /dev/null 2> /dev/null || {
 		printf "[ERR]\n"
 		panic "samples failed"
 		return 1
 	}
 
 	printf "[OK]\n"
+	wait_for_perf_window_merge
+
 	return 0
 }
 
@@ -0,0 +1,174 @@
+#!/bin/bash
+
+# This experiment is intended to document how contention on the global request queue influences latency and throughput as the number of concurrent requests grows well beyond the number of workers
+
+# Add bash_libraries directory to path
+__run_sh__base_path="$(dirname "$(realpath --logical "${BASH_SOURCE[0]}")")"
+__run_sh__bash_libraries_relative_path="../bash_libraries"
+__run_sh__bash_libraries_absolute_path=$(cd "$__run_sh__base_path" && cd "$__run_sh__bash_libraries_relative_path" && pwd)
+export PATH="$__run_sh__bash_libraries_absolute_path:$PATH"
+
+source csv_to_dat.sh || exit 1
+source framework.sh || exit 1
+source generate_gnuplots.sh || exit 1
+source get_result_count.sh || exit 1
+source panic.sh || exit 1
+source percentiles_table.sh || exit 1
+source path_join.sh || exit 1
+source perf_window_warmup.sh || exit 1
+
+if ! command -v hey > /dev/null; then
+	echo "hey is not present."
+	exit 1
+fi
+
+declare -gi iterations=20000
+declare -ga concurrency=(1 50 100 200 300 400)
+
+run_samples() {
+	if (($# != 1)); then
+		panic "invalid number of arguments \"$1\""
+		return 1
+	elif [[ -z "$1" ]]; then
+		panic "hostname \"$1\" was empty"
+		return 1
+	fi
+
+	local hostname="$1"
+
+	local -i perf_window_warmup_count
+	perf_window_warmup_count=$(get_perf_window_warmup_count)
+	local -ir perf_window_warmup_count
+
+	printf "Running Samples: "
+	hey -disable-compression -disable-keepalive -disable-redirects -n "$perf_window_warmup_count" -c "$perf_window_warmup_count" -q 200 -cpus 3 -o csv -m GET "http://${hostname}:10000" 1> /dev/null 2> /dev/null || {
+		printf "[ERR]\n"
+		panic "samples failed"
+		return 1
+	}
+
+	printf "[OK]\n"
+	wait_for_perf_window_merge
+
+	return 0
+}
+
+# Execute the experiments
+# $1 (hostname)
+# $2 (results_directory) - a directory where we will store our results
+run_experiments() {
+	if (($# != 2)); then
+		panic "invalid number of arguments \"$1\""
+		return 1
+	elif [[ -z "$1" ]]; then
+		panic "hostname \"$1\" was empty"
+		return 1
+	elif [[ ! -d "$2" ]]; then
+		panic "directory \"$2\" does not exist"
+		return 1
+	fi
+
+	local hostname="$1"
+	local results_directory="$2"
+
+	# Execute the experiments
+	printf "Running Experiments:\n"
+	for conn in ${concurrency[*]}; do
+		printf "\t%d Concurrency: " "$conn"
+		hey -disable-compression -disable-keepalive -disable-redirects -n "$iterations" -c "$conn" -cpus 2 -o csv -m GET "http://$hostname:10000" > "$results_directory/con$conn.csv" 2> /dev/null || {
+			printf "[ERR]\n"
+			panic "experiment failed"
+			return 1
+		}
+		get_result_count "$results_directory/con$conn.csv" || {
+			printf "[ERR]\n"
+			panic "con$conn.csv unexpectedly has zero requests"
+			return 1
+		}
+		printf "[OK]\n"
+	done
+
+	return 0
+}
+
+process_results() {
+	if (($# != 1)); then
+		panic "invalid number of arguments ($#, expected 1)"
+		return 1
+	elif ! [[ -d "$1" ]]; then
+		panic "directory $1 does not exist"
+		return 1
+	fi
+
+	local -r results_directory="$1"
+
+	printf "Processing Results: "
+
+	# Write headers to CSVs
+	printf "Concurrency,Success_Rate\n" >> "$results_directory/success.csv"
+	printf "Concurrency,Throughput\n" >> "$results_directory/throughput.csv"
+	percentiles_table_header "$results_directory/latency.csv" "Con"
+
+	for conn in ${concurrency[*]}; do
+
+		if [[ ! -f "$results_directory/con$conn.csv" ]]; then
+			printf "[ERR]\n"
+			panic "Missing $results_directory/con$conn.csv"
+			return 1
+		fi
+
+		# Calculate Success Rate for csv (percent of requests resulting in 200)
+		awk -F, '
+		$7 == 200 {ok++}
+		END{printf "'"$conn"',%3.5f\n", (ok / '"$iterations"' * 100)}
+	' < "$results_directory/con$conn.csv" >> "$results_directory/success.csv"
+
+		# Filter on 200s, convert from s to ms, and sort
+		awk -F, '$7 == 200 {print ($1 * 1000)}' < "$results_directory/con$conn.csv" \
+			| sort -g > "$results_directory/con$conn-response.csv"
+
+		# Get Number of 200s
+		oks=$(wc -l < "$results_directory/con$conn-response.csv")
+		((oks == 0)) && continue # If all errors, skip line
+
+		# We determine duration by looking at the timestamp of the last complete request
+		# TODO: Should this instead just use the client-side synthetic duration_sec value?
+		duration=$(tail -n1 "$results_directory/con$conn.csv" | cut -d, -f8)
+
+		# Throughput is calculated as the mean number of successful requests per second
+		throughput=$(echo "$oks/$duration" | bc)
+		printf "%d,%f\n" "$conn" "$throughput" >> "$results_directory/throughput.csv"
+
+		# Generate Latency Data for csv
+		percentiles_table_row "$results_directory/con$conn-response.csv" "$results_directory/latency.csv" "$conn"
+
+		# Delete scratch file used for sorting/counting
+		rm -rf "$results_directory/con$conn-response.csv"
+	done
+
+	# Transform csvs to dat files for gnuplot
+	csv_to_dat "$results_directory/success.csv" "$results_directory/throughput.csv" "$results_directory/latency.csv"
+
+	# Generate gnuplots
+	generate_gnuplots "$results_directory" "$__run_sh__base_path" || {
+		printf "[ERR]\n"
+		panic "failed to generate gnuplots"
+	}
+
+	printf "[OK]\n"
+	return 0
+}
+
+# Expected Symbol used by the framework
+experiment_client() {
+	local -r target_hostname="$1"
+	local -r results_directory="$2"
+
+	run_samples "$target_hostname" || return 1
+	run_experiments "$target_hostname" "$results_directory" || return 1
+	process_results "$results_directory" || return 1
+
+	return 0
+}
+
+framework_init "$@"
@@ -0,0 +1,12 @@
+reset
+
+set term jpeg 
+set output "success.jpg"
+
+set xlabel "Concurrency"
+set ylabel "% 2XX"
+
+set xrange [-10:410]
+set yrange [0:110]
+
+plot 'success.dat' using 1:2 title '2XX'
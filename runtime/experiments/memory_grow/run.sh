@@ -0,0 +1,115 @@
+#!/bin/bash
+# This experiment is intended to document how the number of pages grown by memory.grow influences latency
+
+# Add bash_libraries directory to path
+__run_sh__base_path="$(dirname "$(realpath --logical "${BASH_SOURCE[0]}")")"
+__run_sh__bash_libraries_relative_path="../bash_libraries"
+__run_sh__bash_libraries_absolute_path=$(cd "$__run_sh__base_path" && cd "$__run_sh__bash_libraries_relative_path" && pwd)
+export PATH="$__run_sh__bash_libraries_absolute_path:$PATH"
+
+# Source libraries from bash_libraries directory
+source path_join.sh || exit 1
+source framework.sh || exit 1
+source get_result_count.sh || exit 1
+source generate_gnuplots.sh || exit 1
+source percentiles_table.sh || exit 1
+
+if ! command -v hey > /dev/null; then
+	echo "hey is not present."
+	exit 1
+fi
+
+# Experiment Globals and Setups
+# Must be ascending. See README.md
+declare -ar page_counts=(0 1 16 64 256 1024 4096)
+declare -ri iterations=1000
+
+run_experiments() {
+	if (($# != 2)); then
+		panic "invalid number of arguments \"$1\""
+		return 1
+	elif [[ ! -d "$2" ]]; then
+		panic "directory \"$2\" does not exist"
+		return 1
+	fi
+
+	local hostname="$1"
+	local results_directory="$2"
+
+	# Execute the experiments
+	printf "Running Experiments:\n"
+	for pages in "${page_counts[@]}"; do
+		printf "\t%d Pages: " "$pages"
+		hey -disable-compression -disable-keepalive -disable-redirects -n "$iterations" -c 1 -cpus 2 -o csv -m GET -d "$pages" "http://$hostname:10000" > "$results_directory/$pages.csv" 2> /dev/null || {
+			printf "[ERR]\n"
+			panic "$pages experiment failed"
+			return 1
+		}
+		get_result_count "$results_directory/$pages.csv" || {
+			printf "[ERR]\n"
+			panic "$pages.csv unexpectedly has zero requests"
+			return 1
+		}
+		printf "[OK]\n"
+	done
+
+	return 0
+}
+
+process_results() {
+	if (($# != 1)); then
+		panic "invalid number of arguments ($#, expected 1)"
+		return 1
+	elif ! [[ -d "$1" ]]; then
+		panic "directory $1 does not exist"
+		return 1
+	fi
+
+	local -r results_directory="$1"
+
+	printf "Processing Results: "
+
+	percentiles_table_header "$results_directory/latency.csv" "Pages"
+
+	for pages in "${page_counts[@]}"; do
+		# Filter on 200s, convert from s to ms, and sort
+		awk -F, '$7 == 200 {print ($1 * 1000)}' < "$results_directory/$pages.csv" \
+			| sort -g > "$results_directory/$pages-response.csv"
+
+		# Get Number of 200s
+		oks=$(wc -l < "$results_directory/$pages-response.csv")
+		((oks == 0)) && continue # If all errors, skip line
+
+		# Generate Latency Data for csv
+		percentiles_table_row "$results_directory/$pages-response.csv" "$results_directory/latency.csv" "$pages"
+
+		# Delete scratch file used for sorting/counting
+		rm -rf "$results_directory/$pages-response.csv"
+	done
+
+	# Transform csvs to dat files for gnuplot
+	printf "#" > "$results_directory/latency.dat"
+	tr ',' ' ' < "$results_directory/latency.csv" | column -t >> "$results_directory/latency.dat"
+
+	# Generate gnuplots
+	generate_gnuplots "$results_directory" "$__run_sh__base_path" || {
+		printf "[ERR]\n"
+		panic "failed to generate gnuplots"
+	}
+
+	printf "[OK]\n"
+	return 0
+}
+
+# Expected Symbol used by the framework
+experiment_client() {
+	local -r target_hostname="$1"
+	local -r results_directory="$2"
+
+	run_experiments "$target_hostname" "$results_directory" || return 1
+	process_results "$results_directory" || return 1
+
+	return 0
+}
+
+framework_init "$@"
@@ -16,6 +16,7 @@ source framework.sh || exit 1
 source get_result_count.sh || exit 1
 source generate_gnuplots.sh || exit 1
 source percentiles_table.sh || exit 1
+source perf_window_warmup.sh || exit 1
 
 if ! command -v hey > /dev/null; then
 	echo "hey is not present."
@@ -40,21 +41,15 @@ cd "$__run_sh__base_path/body" && ./generate.sh && cd "$OLDPWD" || exit
 run_samples() {
 	local hostname="$1"
 
-	# Scrape the perf window size from the source if possible
-	local -r perf_window_path="$(path_join "$__run_sh__base_path" ../../include/perf_window_t.h)"
-	local -i perf_window_buffer_size
-	if ! perf_window_buffer_size=$(grep "#define PERF_WINDOW_BUFFER_SIZE" < "$perf_window_path" | cut -d\  -f3); then
-		printf "Failed to scrape PERF_WINDOW_BUFFER_SIZE from ../../include/perf_window.h\n"
-		printf "Defaulting to 16\n"
-		perf_window_buffer_size=16
-	fi
-	local -ir perf_window_buffer_size
+	local -i perf_window_warmup_count
+	perf_window_warmup_count=$(get_perf_window_warmup_count)
+	local -ir perf_window_warmup_count
 
 	# Execute workloads long enough for runtime to learn excepted execution time
 	printf "Running Samples:\n"
 	for payload in "${payloads[@]}"; do
 		printf "\t%d Payload: " "$payload"
-		hey -disable-compression -disable-keepalive -disable-redirects -n "$perf_window_buffer_size" -c "$perf_window_buffer_size" -q 200 -o csv -m GET -D "$__run_sh__base_path/body/$payload.txt" "http://$hostname:${ports["$payload"]}" 1> /dev/null 2> /dev/null || {
+		hey -disable-compression -disable-keepalive -disable-redirects -n "$perf_window_warmup_count" -c "$perf_window_warmup_count" -q 200 -o csv -m GET -D "$__run_sh__base_path/body/$payload.txt" "http://$hostname:${ports["$payload"]}" 1> /dev/null 2> /dev/null || {
 			printf "[ERR]\n"
 			panic "samples failed"
 			return 1
@@ -62,6 +57,8 @@ run_samples() {
 		printf "[OK]\n"
 	done
 
+	wait_for_perf_window_merge
+
 	return 0
 }
 
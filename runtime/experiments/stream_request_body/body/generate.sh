@@ -0,0 +1,15 @@
+#!/bin/bash
+# Generates payloads of 1KB, 64KB, 1MB, 16MB. All but the first exceed the 4KB request buffer of the modules
+for size in 1024 $((1024 * 64)) $((1024 * 1024)) $((1024 * 1024 * 16)); do
+	# If the file exists, but is not the right size, wipe it
+	if [[ -f "$size.txt" ]] && (("$(wc -c "$size.txt" | cut -d\  -f1)" != size)); then
+		rm -rf "$size.txt"
+	fi
+
+	# Regenerate the file if missing
+	if [[ ! -f "$size.txt" ]]; then
+		echo -n "Generating $size: "
+		head -c "$size" /dev/zero | tr '\0' 'a' > "$size.txt"
+		echo "[OK]"
+	fi
+done
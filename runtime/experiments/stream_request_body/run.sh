@@ -0,0 +1,166 @@
+#!/bin/bash
+# This experiment is intended to check that a module that sets stream-request-body receives request bodies larger
+# than its request buffer in full, and to document how latency scales with the size of a streamed body
+
+# Add bash_libraries directory to path
+__run_sh__base_path="$(dirname "$(realpath --logical "${BASH_SOURCE[0]}")")"
+__run_sh__bash_libraries_relative_path="../bash_libraries"
+__run_sh__bash_libraries_absolute_path=$(cd "$__run_sh__base_path" && cd "$__run_sh__bash_libraries_relative_path" && pwd)
+export PATH="$__run_sh__bash_libraries_absolute_path:$PATH"
+
+# Source libraries from bash_libraries directory
+source path_join.sh || exit 1
+source framework.sh || exit 1
+source get_result_count.sh || exit 1
+source generate_gnuplots.sh || exit 1
+source percentiles_table.sh || exit 1
+
+if ! command -v hey > /dev/null; then
+	echo "hey is not present."
+	exit 1
+fi
+
+if ! command -v curl > /dev/null; then
+	echo "curl is not present."
+	exit 1
+fi
+
+# Experiment Globals and Setups
+declare -ar payloads=(1024 65536 1048576 16777216)
+declare -ri iterations=100
+
+# The modules in spec.json have a 4KB request buffer
+declare -ri request_buffer_size=4096
+declare -ri streamed_port=10000
+declare -ri buffered_port=10001
+
+# If the one of the expected body files doesn't exist, trigger the generation script.
+cd "$__run_sh__base_path/body" && ./generate.sh && cd "$OLDPWD" || exit
+
+# Checks the byte count the stream workload responds with, and that the module without streaming still rejects
+# bodies larger than its request buffer
+run_checks() {
+	local hostname="$1"
+	local results_directory="$2"
+
+	printf "Running Checks:\n"
+	printf "Payload,Streamed,Buffered\n" > "$results_directory/checks.csv"
+	for payload in "${payloads[@]}"; do
+		printf "\t%d Payload: " "$payload"
+
+		local streamed
+		streamed=$(curl -s --data-binary "@$__run_sh__base_path/body/$payload.txt" "http://$hostname:$streamed_port")
+		if [[ "$streamed" != "$payload" ]]; then
+			printf "[ERR]\n"
+			panic "streamed $payload byte body, but the module read \"$streamed\""
+			return 1
+		fi
+
+		local -i expected_status=200
+		((payload > request_buffer_size)) && expected_status=413
+
+		local -i buffered_status
+		buffered_status=$(curl -s -o /dev/null -w "%{http_code}" --data-binary "@$__run_sh__base_path/body/$payload.txt" "http://$hostname:$buffered_port")
+		if ((buffered_status != expected_status)); then
+			printf "[ERR]\n"
+			panic "buffered $payload byte body returned $buffered_status, expected $expected_status"
+			return 1
+		fi
+
+		printf "%d,%s,%d\n" "$payload" "$streamed" "$buffered_status" >> "$results_directory/checks.csv"
+		printf "[OK]\n"
+	done
+
+	return 0
+}
+
+run_experiments() {
+	if (($# != 2)); then
+		panic "invalid number of arguments \"$1\""
+		return 1
+	elif [[ ! -d "$2" ]]; then
+		panic "directory \"$2\" does not exist"
+		return 1
+	fi
+
+	local hostname="$1"
+	local results_directory="$2"
+
+	# Execute the experiments
+	printf "Running Experiments:\n"
+	for payload in "${payloads[@]}"; do
+		printf "\t%d Payload: " "$payload"
+		hey -disable-compression -disable-keepalive -disable-redirects -n "$iterations" -c 1 -cpus 2 -o csv -m POST -D "$__run_sh__base_path/body/$payload.txt" "http://$hostname:$streamed_port" > "$results_directory/$payload.csv" 2> /dev/null || {
+			printf "[ERR]\n"
+			panic "$payload experiment failed"
+			return 1
+		}
+		get_result_count "$results_directory/$payload.csv" || {
+			printf "[ERR]\n"
+			panic "$payload.csv unexpectedly has zero requests"
+			return 1
+		}
+		printf "[OK]\n"
+	done
+
+	return 0
+}
+
+process_results() {
+	if (($# != 1)); then
+		panic "invalid number of arguments ($#, expected 1)"
+		return 1
+	elif ! [[ -d "$1" ]]; then
+		panic "directory $1 does not exist"
+		return 1
+	fi
+
+	local -r results_directory="$1"
+
+	printf "Processing Results: "
+
+	percentiles_table_header "$results_directory/latency.csv" "Payload"
+
+	for payload in "${payloads[@]}"; do
+		# Filter on 200s, convert from s to ms, and sort
+		awk -F, '$7 == 200 {print ($1 * 1000)}' < "$results_directory/$payload.csv" \
+			| sort -g > "$results_directory/$payload-response.csv"
+
+		# Get Number of 200s
+		oks=$(wc -l < "$results_directory/$payload-response.csv")
+		((oks == 0)) && continue # If all errors, skip line
+
+		# Generate Latency Data for csv
+		percentiles_table_row "$results_directory/$payload-response.csv" "$results_directory/latency.csv" "$payload"
+
+		# Delete scratch file used for sorting/counting
+		rm -rf "$results_directory/$payload-response.csv"
+	done
+
+	# Transform csvs to dat files for gnuplot
+	printf "#" > "$results_directory/latency.dat"
+	tr ',' ' ' < "$results_directory/latency.csv" | column -t >> "$results_directory/latency.dat"
+
+	# Generate gnuplots
+	generate_gnuplots "$results_directory" "$__run_sh__base_path" || {
+		printf "[ERR]\n"
+		panic "failed to generate gnuplots"
+	}
+
+	printf "[OK]\n"
+	return 0
+}
+
+# Expected Symbol used by the framework
+experiment_client() {
+	local -r target_hostname="$1"
+	local -r results_directory="$2"
+
+	run_checks "$target_hostname" "$results_directory" || return 1
+	run_experiments "$target_hostname" "$results_directory" || return 1
+	process_results "$results_directory" || return 1
+
+	return 0
+}
+
+framework_init "$@"
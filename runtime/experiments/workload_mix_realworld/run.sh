@@ -207,7 +207,8 @@ experiment_server_post() {
 	# Only process data if SLEDGE_SANDBOX_PERF_LOG was set when running sledgert
 	if [[ -n "$SLEDGE_SANDBOX_PERF_LOG" ]]; then
 		if [[ -f "$__run_sh__base_path/$SLEDGE_SANDBOX_PERF_LOG" ]]; then
-			mv "$__run_sh__base_path/$SLEDGE_SANDBOX_PERF_LOG" "$results_directory/perf.log"
+			mv "$__run_sh__base_path/$SLEDGE_SANDBOX_PERF_LOG" "$results_directory/perf.bin"
+			sledge_perf_log_to_csv "$results_directory/perf.bin" > "$results_directory/perf.log" || return 1
 			process_results "$results_directory" || return 1
 		else
 			echo "Perf Log was set, but perf.log not found!"
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "runtime.h"
+#include "types.h"
+
+/*
+ * Queue delay based load shedding, modeled on CoDel, used when SLEDGE_ADMISSIONS_CODEL is set
+ *
+ * Workers measure the sojourn time of each request of a module as it leaves the global request scheduler. If the
+ * minimum sojourn over an interval exceeds the target, the module has a standing queue that cannot drain in time, so
+ * for the following interval, requests whose own sojourn exceeds the target are failed with a 503 rather than
+ * executed. The minimum ignores transient bursts, which drain within an interval.
+ *
+ * The interval is the module's relative deadline, and the target is SLEDGE_ADMISSIONS_CODEL_TARGET percent of it.
+ */
+
+struct admissions_codel {
+	uint64_t         target;         /* cycles */
+	uint64_t         interval;       /* cycles */
+	_Atomic uint64_t interval_start; /* cycles */
+	_Atomic uint64_t interval_min;   /* Minimum sojourn observed in the current interval. UINT64_MAX if none */
+	_Atomic bool     is_dropping;    /* Whether the minimum sojourn of the last interval exceeded the target */
+};
+
+struct admissions_codel_stats {
+	uint64_t dequeued;
+	uint64_t shed;
+} CACHE_ALIGNED;
+
+extern struct admissions_codel_stats admissions_codel_stats[RUNTIME_MAX_WORKER_COUNT];
+
+void admissions_codel_initialize(struct admissions_codel *self, uint64_t relative_deadline);
+bool admissions_codel_should_shed(struct admissions_codel *self, uint64_t request_arrival_timestamp);
+void admissions_codel_stats_print(void);
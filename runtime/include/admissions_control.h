@@ -3,8 +3,30 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "runtime.h"
+#include "types.h"
+
 #define ADMISSIONS_CONTROL_GRANULARITY 1000000
 
+/* Adaptive overhead. See admissions_control_overhead */
+#define ADMISSIONS_CONTROL_OVERHEAD_INITIAL      0.2
+#define ADMISSIONS_CONTROL_OVERHEAD_MIN          0.05
+#define ADMISSIONS_CONTROL_OVERHEAD_MAX          0.9
+#define ADMISSIONS_CONTROL_OVERHEAD_INCREASE     0.05
+#define ADMISSIONS_CONTROL_OVERHEAD_DECREASE     0.01
+#define ADMISSIONS_CONTROL_MISS_RATE_TARGET      0.01
+#define ADMISSIONS_CONTROL_ADAPT_MIN_COMPLETIONS 100
+#define ADMISSIONS_CONTROL_ADAPT_INTERVAL_US     100000
+
+struct admissions_control_stats {
+	_Atomic uint64_t completions;
+	_Atomic uint64_t deadline_misses;
+} CACHE_ALIGNED;
+
+extern _Atomic uint64_t                admissions_control_admitted;
+extern _Atomic uint64_t                admissions_control_capacity;
+extern struct admissions_control_stats admissions_control_stats[RUNTIME_MAX_WORKER_COUNT];
+
 void     admissions_control_initialize(void);
 void     admissions_control_add(uint64_t admissions_estimate);
 void     admissions_control_subtract(uint64_t admissions_estimate);
@@ -12,3 +34,5 @@ uint64_t admissions_control_calculate_estimate(uint64_t estimated_execution, uin
 uint64_t admissions_control_calculate_estimate_us(uint32_t estimated_execution_us, uint32_t relative_deadline_us);
 void     admissions_control_log_decision(uint64_t admissions_estimate, bool admitted);
 uint64_t admissions_control_decide(uint64_t admissions_estimate);
+void     admissions_control_record_completion(bool missed_deadline);
+void     admissions_control_adapt_overhead(void);
@@ -4,12 +4,13 @@
 
 struct admissions_info {
 	struct perf_window perf_window;
-	int                percentile;        /* 50 - 99 */
-	int                control_index;     /* Precomputed Lookup index when perf_window is full */
-	uint64_t           estimate;          /* cycles */
-	uint64_t           relative_deadline; /* Relative deadline in cycles. This is duplicated state */
+	int                percentile;          /* 50 - 99 */
+	uint64_t           estimated_execution; /* pXX execution in cycles. Refreshed by the perf window aggregator */
+	uint64_t           estimate;            /* Unitless admissions estimate derived from estimated_execution */
+	uint64_t           relative_deadline;   /* Relative deadline in cycles. This is duplicated state */
 };
 
 void admissions_info_initialize(struct admissions_info *self, int percentile, uint64_t expected_execution,
                                 uint64_t relative_deadline);
 void admissions_info_update(struct admissions_info *self, uint64_t execution_duration);
+void admissions_info_refresh(struct admissions_info *self);
@@ -69,6 +69,24 @@ arch_context_restore_fast(mcontext_t *active_context, struct arch_context *sandb
 	active_context->gregs[REG_RIP] = sandbox_context->regs[UREG_IP];
 }
 
+/**
+ * Resume the base context from a signal handler, idling the worker. The base context was last saved by
+ * arch_context_switch, so it is restored like a fastpath sandbox
+ * @param active_context - the context of the current worker thread
+ */
+static inline void
+arch_context_restore_base(mcontext_t *active_context)
+{
+	assert(active_context != NULL);
+
+	/* Transitioning from Fast -> Running */
+	assert(worker_thread_base_context.variant == ARCH_CONTEXT_VARIANT_FAST);
+	worker_thread_base_context.variant = ARCH_CONTEXT_VARIANT_RUNNING;
+
+	active_context->gregs[REG_RSP] = worker_thread_base_context.regs[UREG_SP];
+	active_context->gregs[REG_RIP] = worker_thread_base_context.regs[UREG_IP];
+}
+
 /**
  * @param a - the registers and context of the thing running
  * @param b - the registers and context of what we're switching to
@@ -2,10 +2,18 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <threads.h>
 
+#include "arch/getcycles.h"
 #include "flush.h"
+#include "runtime.h"
+#include "sandbox_types.h"
+#include "trace.h"
+#include "types.h"
+#include "worker_thread.h"
 
 enum CACHE_PROTECTION
 {
@@ -15,6 +23,27 @@ enum CACHE_PROTECTION
 
 extern enum CACHE_PROTECTION cache_protection;
 
+struct cache_protection_stats {
+	uint64_t flushes;
+	uint64_t flush_cycles;     /* Time spent in the flush backend */
+	uint64_t flushes_avoided;  /* Switches to a sandbox of the domain that last ran on the worker */
+	uint64_t affinity_picks;   /* Sandboxes run ahead of an earlier deadline because they share the last domain */
+	uint64_t slack_used;       /* Cycles of deadline slack lent by the displaced sandboxes. An upper bound */
+	uint64_t completions;      /* Sandboxes that ran to completion on the worker */
+	uint64_t execution_cycles; /* Time those sandboxes ran, which includes refilling the caches after flushes */
+} CACHE_ALIGNED;
+
+extern struct cache_protection_stats cache_protection_stats[RUNTIME_MAX_WORKER_COUNT];
+
+/* Identity of the last sandbox to run on this worker. Sandboxes may be freed, so their fields are copied */
+struct cache_protection_last {
+	bool     is_valid;
+	uint64_t id;
+	int32_t  domain;
+};
+
+extern thread_local struct cache_protection_last cache_protection_last;
+
 static inline char *
 cache_protection_print(enum CACHE_PROTECTION variant)
 {
@@ -28,19 +57,25 @@ cache_protection_print(enum CACHE_PROTECTION variant)
 
 /**
  * Called during a sandbox context switch to flush the cache. 
- * Requires the 'cool' kernel module to be installed on the system.
+ * The KERNEL backend requires the 'cool' kernel module to be installed on the system.
+ * @param outgoing the sandbox that last ran, or NULL if unknown or no longer mapped
  */
 static inline void
-cache_protection_flush()
+cache_protection_flush(struct sandbox *outgoing)
 {
     switch (cache_protection) {
-        case CACHE_PROTECTION_FLUSH:
+        case CACHE_PROTECTION_FLUSH: {
 #ifdef CACHE_FLUSH_LOG
             printf("Flushing the cache!\n");
 #endif
-            btb_flush();
-            cflush();
+            uint64_t start = __getcycles();
+            flush(outgoing);
+            uint64_t end = __getcycles();
+            cache_protection_stats[worker_thread_idx].flushes++;
+            cache_protection_stats[worker_thread_idx].flush_cycles += end - start;
+            trace_cache_flush(outgoing, start, end);
             break;
+        }
         case CACHE_PROTECTION_NONE:
 #ifdef CACHE_FLUSH_LOG
             printf("Skipping cache flush!\n");
@@ -48,3 +83,47 @@ cache_protection_flush()
             break;
     }
 }
+
+/**
+ * Called when a worker with domain affinity switches to a sandbox. The caches only hold the state of sandboxes that
+ * ran since the last flush, so a flush is only needed when the next sandbox is in a different domain than the last
+ * sandbox to run, or is untrusted (domain -1) and is not the last sandbox itself. Switching to the base context
+ * defers the decision to the next sandbox.
+ * @param outgoing the sandbox that last ran, or NULL if unknown or no longer mapped
+ * @param next the sandbox about to run, or NULL if the worker is going idle
+ */
+static inline void
+cache_protection_switch_to(struct sandbox *outgoing, struct sandbox *next)
+{
+	if (next == NULL) return;
+
+	struct cache_protection_last last = cache_protection_last;
+	cache_protection_last = (struct cache_protection_last){
+		.is_valid = true,
+		.id       = next->id,
+		.domain   = next->module->domain,
+	};
+
+	if (last.is_valid && (last.id == next->id || (last.domain != -1 && last.domain == next->module->domain))) {
+		cache_protection_stats[worker_thread_idx].flushes_avoided++;
+		return;
+	}
+
+	cache_protection_flush(outgoing);
+}
+
+/**
+ * Accounts for the execution time of a sandbox that completed. Against a run without flushing, the difference in
+ * mean execution time is the cost of refilling the caches after flushes
+ * @param sandbox
+ */
+static inline void
+cache_protection_record_completion(struct sandbox *sandbox)
+{
+	struct cache_protection_stats *stats = &cache_protection_stats[worker_thread_idx];
+	stats->completions++;
+	stats->execution_cycles += sandbox->duration_of_state[SANDBOX_RUNNING_USER]
+	                           + sandbox->duration_of_state[SANDBOX_RUNNING_SYS];
+}
+
+void cache_protection_stats_print(void);
@@ -35,7 +35,7 @@ client_socket_close(int client_socket, struct sockaddr *client_address)
 /**
  * Rejects request due to admission control or error
  * @param client_socket - the client we are rejecting
- * @param status_code - either 503 or 400
+ * @param status_code - one of 400, 413, 429, 503, or 504
  */
 static inline int
 client_socket_send(int client_socket, int status_code)
@@ -47,6 +47,14 @@ client_socket_send(int client_socket, int status_code)
 		response = HTTP_RESPONSE_503_SERVICE_UNAVAILABLE;
 		http_total_increment_5XX();
 		break;
+	case 504:
+		response = HTTP_RESPONSE_504_GATEWAY_TIMEOUT;
+		http_total_increment_5XX();
+		break;
+	case 429:
+		response = HTTP_RESPONSE_429_TOO_MANY_REQUESTS;
+		http_total_increment_4XX();
+		break;
 	case 413:
 		response = HTTP_RESPONSE_413_PAYLOAD_TOO_LARGE;
 		http_total_increment_4XX();
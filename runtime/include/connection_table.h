@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include "module.h"
+#include "runtime.h"
+#include "types.h"
+
+/*
+ * Per-worker table of idle HTTP/1.1 keep-alive connections, used when SLEDGE_KEEPALIVE is set
+ *
+ * After a sandbox sends a keep-alive response, its client socket is parked here and registered on a per-worker epoll
+ * instance. When the next request arrives, the worker polling the table creates a sandbox for it directly on its
+ * local runqueue, without another accept on the listener thread. Connections idle for longer than
+ * SLEDGE_KEEPALIVE_TIMEOUT_US are closed.
+ */
+
+#define CONNECTION_TABLE_CAPACITY 1024
+
+struct connection_table_stats {
+	uint64_t reused;  /* Requests dispatched from a parked connection */
+	uint64_t expired; /* Connections closed after idling past the timeout */
+	uint64_t closed;  /* Connections closed by the client while parked */
+} CACHE_ALIGNED;
+
+extern struct connection_table_stats connection_table_stats[RUNTIME_MAX_WORKER_COUNT];
+
+void connection_table_initialize(void);
+bool connection_table_has_space(void);
+void connection_table_add(struct module *module, int socket_descriptor, struct sockaddr *client_address,
+                          uint32_t request_count);
+void connection_table_poll(void);
+void connection_table_stats_print(void);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "runtime.h"
+#include "types.h"
+
+/*
+ * Per-module limits on how long a sandbox may run, configured by the kill-after-deadline-multiple, max-cpu-us, and
+ * overrun-policy keys of the module JSON
+ *
+ * Budgets are checked when a sandbox is preempted by SIGALRM. A sandbox exceeds its budget once its execution time
+ * (the time spent in the running user and running sys states) exceeds max-cpu-us, or once the time since its request
+ * arrived exceeds kill-after-deadline-multiple times the relative deadline. The sandbox is then either aborted with a
+ * 504 Gateway Timeout, or demoted to a background class that only runs when no other sandbox on the worker can.
+ */
+
+enum execution_budget_policy
+{
+	EXECUTION_BUDGET_POLICY_KILL   = 0,
+	EXECUTION_BUDGET_POLICY_DEMOTE = 1
+};
+
+/* Added to the deadline of a demoted sandbox. This orders it after all sandboxes that are not demoted, while
+ * demoted sandboxes keep EDF order among themselves */
+#define EXECUTION_BUDGET_BACKGROUND_OFFSET (1ULL << 62)
+
+struct execution_budget {
+	uint32_t                     deadline_multiple; /* 0 is unlimited */
+	uint64_t                     max_cpu;           /* cycles. 0 is unlimited */
+	uint64_t                     max_elapsed;       /* cycles. deadline_multiple * relative deadline */
+	enum execution_budget_policy policy;
+};
+
+struct execution_budget_stats {
+	uint64_t aborts;
+	uint64_t demotions;
+} CACHE_ALIGNED;
+
+extern struct execution_budget_stats execution_budget_stats[RUNTIME_MAX_WORKER_COUNT];
+extern uint32_t                      execution_budget_module_count;
+
+void execution_budget_initialize(struct execution_budget *self, uint32_t deadline_multiple, uint32_t max_cpu_us,
+                                 enum execution_budget_policy policy, uint64_t relative_deadline);
+void execution_budget_stats_print(void);
+
+static inline bool
+execution_budget_is_enabled(struct execution_budget *self)
+{
+	return self->max_cpu != 0 || self->max_elapsed != 0;
+}
+
+/**
+ * @param self
+ * @param execution cycles the sandbox has spent running
+ * @param elapsed cycles since the request of the sandbox arrived
+ * @returns true if the sandbox has overrun the budget
+ */
+static inline bool
+execution_budget_is_exceeded(struct execution_budget *self, uint64_t execution, uint64_t elapsed)
+{
+	return (self->max_cpu != 0 && execution > self->max_cpu)
+	       || (self->max_elapsed != 0 && elapsed > self->max_elapsed);
+}
+
+static inline char *
+execution_budget_policy_print(enum execution_budget_policy policy)
+{
+	switch (policy) {
+	case EXECUTION_BUDGET_POLICY_KILL:
+		return "kill";
+	case EXECUTION_BUDGET_POLICY_DEMOTE:
+		return "demote";
+	}
+}
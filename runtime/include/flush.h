@@ -2,6 +2,32 @@
 
 #include <stdbool.h>
 
+struct sandbox;
+
+/* Implementation of the cache flush performed by CACHE_PROTECTION_FLUSH */
+enum FLUSH_BACKEND
+{
+	FLUSH_BACKEND_KERNEL    = 0, /* IBPB and a cache flush via ioctls to the 'cool' kernel module */
+	FLUSH_BACKEND_USERSPACE = 1  /* An eviction buffer sweep and clflushopt of the outgoing sandbox's memory */
+};
+
+extern enum FLUSH_BACKEND flush_backend;
+
+static inline char *
+flush_backend_print(enum FLUSH_BACKEND variant)
+{
+	switch (variant) {
+	case FLUSH_BACKEND_KERNEL:
+		return "KERNEL";
+	case FLUSH_BACKEND_USERSPACE:
+		return "USERSPACE";
+	}
+}
+
 bool flush_init();
+void flush(struct sandbox *outgoing);
 void btb_flush();
 void cflush();
+
+bool flush_userspace_initialize(void);
+void flush_userspace(struct sandbox *outgoing);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#define MAX_DOMAINS                256
+#define GANG_DOMAIN_BITMAP_WORDS   (MAX_DOMAINS / 64)
+#define GANG_DOMAIN_WEIGHT_DEFAULT 1
+#define GANG_DOMAIN_WEIGHT_MAX     64
+
+/*
+ * Registry of the security domains of modules run by the GANG scheduler
+ *
+ * Domain IDs are arbitrary non-negative integers set by the "domain" key of the module JSON. The registry maps each
+ * to a dense slot in order of registration, so per-domain state is held in arrays and bitmaps of MAX_DOMAINS entries
+ * regardless of the IDs in use. A module caches the slot of its domain in module->domain_slot.
+ *
+ * Each domain has a weight, set by the "domain-weight" key, which is the number of consecutive time slices the domain
+ * runs for when it is scheduled. Under SLEDGE_GANG_EPOCH, a domain is likewise given weight epochs in a row.
+ *
+ * Modules are loaded after the workers start, so slots are written before the count is incremented, and workers
+ * only read slots below the count.
+ */
+
+uint32_t gang_domain_register(int32_t domain, uint32_t weight);
+uint32_t gang_domain_count(void);
+int32_t  gang_domain_id(uint32_t slot);
+uint32_t gang_domain_weight(uint32_t slot);
+uint32_t gang_domain_weight_total(void);
+
+/**
+ * Finds the first set bit after a slot, wrapping around the bitmap and ending with the slot itself
+ * @param bitmap
+ * @param slot
+ * @returns the slot of the bit found, or -1 if the bitmap is empty
+ */
+static inline int32_t
+gang_domain_bitmap_next(const uint64_t bitmap[GANG_DOMAIN_BITMAP_WORDS], uint32_t slot)
+{
+	uint32_t start = (slot + 1) % MAX_DOMAINS;
+	uint32_t word  = start / 64;
+	uint64_t bits  = bitmap[word] & (~0ULL << (start % 64));
+
+	/* The final iteration revisits the first word in full to cover the bits preceding start */
+	for (uint32_t i = 0; i <= GANG_DOMAIN_BITMAP_WORDS; i++) {
+		if (bits != 0) return (int32_t)(word * 64 + __builtin_ctzll(bits));
+		word = (word + 1) % GANG_DOMAIN_BITMAP_WORDS;
+		bits = bitmap[word];
+	}
+
+	return -1;
+}
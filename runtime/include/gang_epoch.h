@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "runtime.h"
+#include "types.h"
+
+/*
+ * Synchronized gang scheduling of security domains, used when SLEDGE_GANG_EPOCH is set
+ *
+ * Time is divided into epochs of one quantum, measured from the same CLOCK_MONOTONIC origin that phases the
+ * per-thread SIGALRM timers. Each epoch names one domain per group of SLEDGE_GANG_GROUP_SIZE consecutive workers, so
+ * every worker of a group, including SMT siblings when groups follow the core topology, runs the same domain at once.
+ * Each domain is named by as many consecutive epochs as its weight in the gang domain registry.
+ * The epoch is a pure function of time, so workers agree on it without communicating. Pair with
+ * SLEDGE_SIGALRM_TIMER=THREAD, whose ticks land on epoch boundaries, so all workers switch within the same tick.
+ *
+ * A worker with no work in its group's domain idles rather than running another domain. A request from the global
+ * request scheduler that belongs to another domain is parked on the worker's runqueue until that domain's epoch.
+ */
+
+struct gang_epoch_stats {
+	uint64_t epochs;      /* Epochs observed */
+	uint64_t busy_epochs; /* Epochs in which the worker ran a sandbox */
+	uint64_t parked;      /* Requests pulled from the global request scheduler outside their domain's epoch */
+} CACHE_ALIGNED;
+
+extern struct gang_epoch_stats gang_epoch_stats[RUNTIME_MAX_WORKER_COUNT];
+
+uint32_t gang_epoch_domain(void);
+void     gang_epoch_mark_busy(void);
+void     gang_epoch_stats_print(void);
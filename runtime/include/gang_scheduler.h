@@ -1,26 +1,21 @@
-
 #pragma once
 
 #include <stdint.h>
+#include "gang_domain.h"
 #include "ps_list.h"
 
-#define MAX_DOMAINS 256
-
 // Gang runqueue implementation
-// It is a list of domain-specific runqueues
+// It is a list of domain-specific runqueues, indexed by the slot of the domain in the gang domain registry
 struct runqueue_gang {
-    // TODO: lets just say 256 max domains for now
-    //       can replace with hash-map for higher number or resize based on
-    //       max number??
     struct ps_list_head domain_lists[MAX_DOMAINS];
+    uint64_t nonempty[GANG_DOMAIN_BITMAP_WORDS]; /* Bit per slot with a non-empty list */
     uint32_t num_sandboxes;
-    uint32_t num_domains;
     uint32_t current_domain;
+    uint32_t slices_remaining; /* Time slices left before the current domain yields to the next */
 };
 
 void local_runqueue_gang_initialize();
 void local_runqueue_gang_next_domain();
 void local_runqueue_gang_rotate();
+void local_runqueue_gang_set_domain(uint32_t domain);
 uint32_t local_runqueue_gang_current_domain();
-
-
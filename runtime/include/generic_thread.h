@@ -1,11 +1,66 @@
 #pragma once
 
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <threads.h>
 
-extern thread_local uint64_t generic_thread_lock_duration;
-extern thread_local uint64_t generic_thread_lock_longest;
-extern thread_local uint64_t generic_thread_start_timestamp;
+#include "runtime.h"
+#include "types.h"
+
+/*
+ * Counters that are written on hot paths are sharded by thread. Workers use the shard at their worker index, the
+ * listener uses GENERIC_THREAD_LISTENER_IDX, and any other thread shares GENERIC_THREAD_OTHER_IDX. Shards are padded
+ * to a cache line, so a thread only ever writes lines that it owns, and readers such as the metrics endpoint sum the
+ * shards on demand.
+ */
+#define GENERIC_THREAD_LISTENER_IDX RUNTIME_MAX_WORKER_COUNT
+#define GENERIC_THREAD_OTHER_IDX    (RUNTIME_MAX_WORKER_COUNT + 1)
+#define GENERIC_THREAD_MAX_COUNT    (RUNTIME_MAX_WORKER_COUNT + 2)
+
+struct generic_thread_stats {
+	_Atomic uint64_t lock_duration; /* cycles spent acquiring locks */
+} CACHE_ALIGNED;
+
+extern thread_local int             generic_thread_idx;
+extern thread_local uint64_t        generic_thread_lock_longest;
+extern thread_local uint64_t        generic_thread_start_timestamp;
+extern struct generic_thread_stats generic_thread_stats[GENERIC_THREAD_MAX_COUNT];
 
 void generic_thread_dump_lock_overhead(void);
-void generic_thread_initialize(void);
+void generic_thread_initialize(int idx);
+
+/**
+ * Adds to a counter in the shard of the calling thread
+ * A shard has a single writer, so a relaxed load and store replace a locked read-modify-write. The exception is the
+ * shard shared by other threads, which may rarely lose an update. This is acceptable for statistics.
+ * @param counter
+ * @param value
+ */
+static inline void
+generic_thread_counter_add(_Atomic uint64_t *counter, uint64_t value)
+{
+	atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+	                      memory_order_relaxed);
+}
+
+/**
+ * Sums a counter across the shards of all threads
+ * @param shards the first shard
+ * @param stride the size of a shard in bytes
+ * @param offset the offset of the counter within a shard in bytes
+ * @returns the total
+ */
+static inline uint64_t
+generic_thread_counter_sum(const void *shards, size_t stride, size_t offset)
+{
+	uint64_t total = 0;
+	for (int i = 0; i < GENERIC_THREAD_MAX_COUNT; i++) {
+		total += atomic_load_explicit((_Atomic uint64_t *)((char *)shards + i * stride + offset),
+		                              memory_order_relaxed);
+	}
+	return total;
+}
+
+#define GENERIC_THREAD_COUNTER_SUM(shards, field) \
+	generic_thread_counter_sum((shards), sizeof((shards)[0]), offsetof(__typeof__((shards)[0]), field))
@@ -2,7 +2,9 @@
 
 #include <stdint.h>
 
+#include "generic_thread.h"
 #include "sandbox_request.h"
+#include "trace.h"
 
 /* Returns pointer back if successful, null otherwise */
 typedef struct sandbox_request *(*global_request_scheduler_add_fn_t)(void *);
@@ -17,9 +19,49 @@ struct global_request_scheduler_config {
 	global_request_scheduler_peek_fn_t              peek_fn;
 };
 
+/* Backing structure of the EDF global request scheduler */
+enum GLOBAL_QUEUE
+{
+	GLOBAL_QUEUE_MINHEAP    = 0, /* A single locked min-heap. Strict EDF */
+	GLOBAL_QUEUE_MULTIQUEUE = 1  /* Several locked min-heaps. Relaxed EDF */
+};
+
+extern enum GLOBAL_QUEUE global_queue;
+
+/* Requests added and removed, sharded by thread. Their difference across shards is the depth of the scheduler */
+struct global_request_scheduler_stats {
+	_Atomic uint64_t added;
+	_Atomic uint64_t removed;
+} CACHE_ALIGNED;
+
+extern struct global_request_scheduler_stats global_request_scheduler_stats[GENERIC_THREAD_MAX_COUNT];
+
+static inline char *
+global_queue_print(enum GLOBAL_QUEUE variant)
+{
+	switch (variant) {
+	case GLOBAL_QUEUE_MINHEAP:
+		return "MINHEAP";
+	case GLOBAL_QUEUE_MULTIQUEUE:
+		return "MULTIQUEUE";
+	}
+}
+
 
 void                    global_request_scheduler_initialize(struct global_request_scheduler_config *config);
 struct sandbox_request *global_request_scheduler_add(struct sandbox_request *);
 int                     global_request_scheduler_remove(struct sandbox_request **);
 int                     global_request_scheduler_remove_if_earlier(struct sandbox_request **, uint64_t targed_deadline);
 uint64_t                global_request_scheduler_peek(void);
+uint64_t                global_request_scheduler_depth(void);
+
+/**
+ * Records the removal of a request. Callers that bypass the generic remove functions must call this themselves
+ * @param sandbox_request the removed request
+ */
+static inline void
+global_request_scheduler_record_removal(struct sandbox_request *sandbox_request)
+{
+	generic_thread_counter_add(&global_request_scheduler_stats[generic_thread_idx].removed, 1);
+	trace_dequeue(sandbox_request);
+}
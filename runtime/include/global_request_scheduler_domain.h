@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gang_domain.h"
+#include "global_request_scheduler.h"
+#include "runtime.h"
+#include "types.h"
+
+/*
+ * Global request scheduler for the GANG scheduler, holding a deque per security domain
+ *
+ * The listener is the single producer of every deque, and workers steal from them. A worker dequeues from the deque
+ * of its current gang domain, and only takes requests of other domains through the generic remove when its runqueue
+ * is empty, as allocating a sandbox of another domain forces a flush when that domain is next scheduled.
+ */
+
+struct global_request_scheduler_domain_stats {
+	uint64_t same_domain_pulls;
+	uint64_t cross_domain_pulls;
+} CACHE_ALIGNED;
+
+extern struct global_request_scheduler_domain_stats global_request_scheduler_domain_stats[RUNTIME_MAX_WORKER_COUNT];
+
+void global_request_scheduler_domain_initialize();
+int  global_request_scheduler_domain_remove_from(uint32_t domain, struct sandbox_request **removed_sandbox_request);
+void global_request_scheduler_domain_pending(uint64_t bitmap[GANG_DOMAIN_BITMAP_WORDS]);
+void global_request_scheduler_domain_stats_print(void);
@@ -2,4 +2,5 @@
 
 #include "global_request_scheduler.h"
 
-void global_request_scheduler_minheap_initialize();
+uint64_t sandbox_request_get_priority_fn(void *element);
+void     global_request_scheduler_minheap_initialize();
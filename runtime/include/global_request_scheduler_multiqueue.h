@@ -0,0 +1,16 @@
+#pragma once
+
+#include "global_request_scheduler.h"
+
+/*
+ * Relaxed EDF global request scheduler built from several locked min-heaps (a MultiQueue)
+ *
+ * The listener inserts into a random heap. Workers sample two heaps and dequeue from the one with the earlier head,
+ * so concurrent workers usually lock different heaps. The dequeued request is not necessarily the globally earliest,
+ * but its expected rank error is bounded by a small multiple of the heap count.
+ */
+
+#define GLOBAL_REQUEST_SCHEDULER_MULTIQUEUE_FACTOR   2    /* Heaps per worker */
+#define GLOBAL_REQUEST_SCHEDULER_MULTIQUEUE_CAPACITY 1024 /* Requests per heap */
+
+void global_request_scheduler_multiqueue_initialize();
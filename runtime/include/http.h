@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <string.h>
 
 #define HTTP_MAX_HEADER_COUNT        16
@@ -19,32 +20,55 @@
 	"Connection: close\r\n"              \
 	"\r\n"
 
+#define HTTP_RESPONSE_429_TOO_MANY_REQUESTS  \
+	"HTTP/1.1 429 Too Many Requests\r\n" \
+	"Server: SLEdge\r\n"                 \
+	"Connection: close\r\n"              \
+	"\r\n"
+
 #define HTTP_RESPONSE_503_SERVICE_UNAVAILABLE  \
 	"HTTP/1.1 503 Service Unavailable\r\n" \
 	"Server: SLEdge\r\n"                   \
 	"Connection: close\r\n"                \
 	"\r\n"
 
+#define HTTP_RESPONSE_504_GATEWAY_TIMEOUT  \
+	"HTTP/1.1 504 Gateway Timeout\r\n" \
+	"Server: SLEdge\r\n"               \
+	"Connection: close\r\n"            \
+	"\r\n"
+
 #define HTTP_RESPONSE_200_TEMPLATE \
 	"HTTP/1.1 200 OK\r\n"      \
 	"Server: SLEdge\r\n"       \
-	"Connection: close\r\n"    \
+	"Connection: %s\r\n"       \
 	"Content-Type: %s\r\n"     \
 	"Content-Length: %s\r\n"   \
 	"\r\n"
 
 /* The sum of format specifier characters in the template above */
-#define HTTP_RESPONSE_200_TEMPLATE_FORMAT_SPECIFIER_LENGTH 4
+#define HTTP_RESPONSE_200_TEMPLATE_FORMAT_SPECIFIER_LENGTH 6
+
+/**
+ * @param keep_alive whether the connection persists after the response
+ * @returns the value of the Connection header
+ */
+static inline char *
+http_connection(bool keep_alive)
+{
+	return keep_alive ? "keep-alive" : "close";
+}
 
 /**
  * Calculates the number of bytes of the HTTP response containing the passed header values
  * @return total size in bytes
  */
 static inline size_t
-http_response_200_size(char *content_type, char *content_length)
+http_response_200_size(char *content_type, char *content_length, bool keep_alive)
 {
 	size_t size = 0;
 	size += strlen(HTTP_RESPONSE_200_TEMPLATE) - HTTP_RESPONSE_200_TEMPLATE_FORMAT_SPECIFIER_LENGTH;
+	size += strlen(http_connection(keep_alive));
 	size += strlen(content_type);
 	size += strlen(content_length);
 	return size;
@@ -57,12 +81,12 @@ http_response_200_size(char *content_type, char *content_length)
  * @return 0 on success, -1 otherwise
  */
 static inline int
-http_response_200(char *destination, char *content_type, char *content_length)
+http_response_200(char *destination, char *content_type, char *content_length, bool keep_alive)
 {
-	size_t response_size = http_response_200_size(content_type, content_length);
+	size_t response_size = http_response_200_size(content_type, content_length, keep_alive);
 	char   buffer[response_size + 1];
 	int    rc = 0;
-	rc        = sprintf(buffer, HTTP_RESPONSE_200_TEMPLATE, content_type, content_length);
+	rc = sprintf(buffer, HTTP_RESPONSE_200_TEMPLATE, http_connection(keep_alive), content_type, content_length);
 	if (rc <= 0) goto err;
 	memmove(destination, buffer, response_size);
 	rc = 0;
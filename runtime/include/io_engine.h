@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "sandbox_types.h"
+
+/*
+ * Network I/O engine used by sandboxes to exchange HTTP messages with clients and by the scheduler to wake sandboxes
+ * blocked on I/O. Selected at startup by SLEDGE_IO_ENGINE
+ */
+
+enum IO_ENGINE
+{
+	IO_ENGINE_EPOLL = 0,
+	IO_ENGINE_URING = 1
+};
+
+extern enum IO_ENGINE io_engine;
+
+typedef void (*io_engine_thread_initialize_fn_t)(void);
+typedef void (*io_engine_open_fn_t)(struct sandbox *sandbox);
+typedef ssize_t (*io_engine_recv_fn_t)(struct sandbox *sandbox, void *buffer, size_t length);
+typedef ssize_t (*io_engine_send_fn_t)(struct sandbox *sandbox, const void *buffer, size_t length);
+typedef void (*io_engine_close_fn_t)(struct sandbox *sandbox);
+typedef void (*io_engine_release_fn_t)(struct sandbox *sandbox);
+typedef void (*io_engine_poll_fn_t)(void);
+
+struct io_engine_config {
+	io_engine_thread_initialize_fn_t thread_initialize_fn;
+	io_engine_open_fn_t              open_fn;
+	io_engine_recv_fn_t              recv_fn;
+	io_engine_send_fn_t              send_fn;
+	io_engine_close_fn_t             close_fn;
+	io_engine_release_fn_t           release_fn;
+	io_engine_poll_fn_t              poll_fn;
+};
+
+void    io_engine_initialize(struct io_engine_config *config);
+void    io_engine_thread_initialize(void);
+void    io_engine_open(struct sandbox *sandbox);
+ssize_t io_engine_recv(struct sandbox *sandbox, void *buffer, size_t length);
+ssize_t io_engine_send(struct sandbox *sandbox, const void *buffer, size_t length);
+void    io_engine_close(struct sandbox *sandbox);
+void    io_engine_release(struct sandbox *sandbox);
+void    io_engine_poll(void);
+
+void io_engine_epoll_initialize(void);
+void io_engine_uring_initialize(void);
+
+static inline char *
+io_engine_print(enum IO_ENGINE variant)
+{
+	switch (variant) {
+	case IO_ENGINE_EPOLL:
+		return "EPOLL";
+	case IO_ENGINE_URING:
+		return "URING";
+	}
+}
@@ -1,24 +1,41 @@
 #pragma once
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 
+#include "runtime.h"
 #include "sandbox_types.h"
+#include "types.h"
 
 /* Returns pointer back if successful, null otherwise */
 typedef void (*local_runqueue_add_fn_t)(struct sandbox *);
 typedef bool (*local_runqueue_is_empty_fn_t)(void);
 typedef void (*local_runqueue_delete_fn_t)(struct sandbox *sandbox);
 typedef struct sandbox *(*local_runqueue_get_next_fn_t)();
+typedef struct sandbox *(*local_runqueue_steal_fn_t)(void);
+typedef struct sandbox *(*local_runqueue_get_next_in_domain_fn_t)(int32_t domain);
 
 struct local_runqueue_config {
-	local_runqueue_add_fn_t      add_fn;
-	local_runqueue_is_empty_fn_t is_empty_fn;
-	local_runqueue_delete_fn_t   delete_fn;
-	local_runqueue_get_next_fn_t get_next_fn;
+	local_runqueue_add_fn_t                add_fn;
+	local_runqueue_is_empty_fn_t           is_empty_fn;
+	local_runqueue_delete_fn_t             delete_fn;
+	local_runqueue_get_next_fn_t           get_next_fn;
+	local_runqueue_steal_fn_t              steal_fn; /* Optional. NULL if the variant does not support stealing */
+	local_runqueue_get_next_in_domain_fn_t get_next_in_domain_fn; /* Optional. NULL if not domain aware */
 };
 
+/* Number of sandboxes on a worker's runqueue, including the running sandbox. Read by other workers when stealing */
+struct local_runqueue_length {
+	_Atomic uint32_t value;
+} CACHE_ALIGNED;
+
+extern struct local_runqueue_length local_runqueue_lengths[RUNTIME_MAX_WORKER_COUNT];
+
 void            local_runqueue_add(struct sandbox *);
 void            local_runqueue_delete(struct sandbox *);
 bool            local_runqueue_is_empty();
 struct sandbox *local_runqueue_get_next();
+struct sandbox *local_runqueue_steal(void);
+struct sandbox *local_runqueue_get_next_in_domain(int32_t domain);
 void            local_runqueue_initialize(struct local_runqueue_config *config);
@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include "arch/getcycles.h"
+#include "generic_thread.h"
 #include "runtime.h"
 
 typedef ck_spinlock_mcs_t lock_t;
@@ -36,7 +37,8 @@ typedef ck_spinlock_mcs_t lock_t;
 	if (_hygiene_##unique_variable_name##_duration > generic_thread_lock_longest) {                                \
 		generic_thread_lock_longest = _hygiene_##unique_variable_name##_duration;                              \
 	}                                                                                                              \
-	generic_thread_lock_duration += _hygiene_##unique_variable_name##_duration;
+	generic_thread_counter_add(&generic_thread_stats[generic_thread_idx].lock_duration,                            \
+	                           _hygiene_##unique_variable_name##_duration);
 
 /**
  * Unlocks a lock
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "generic_thread.h"
+#include "runtime.h"
+#include "types.h"
+
+/*
+ * Live metrics in the Prometheus text exposition format, served on SLEDGE_METRICS_PORT
+ *
+ * Hot paths only ever write counters sharded by thread. The metrics thread sums the shards when it is scraped, so
+ * exposing the metrics adds no work or contention to the listener or workers between scrapes.
+ */
+
+/* Buckets of latency histograms. Samples above the last bound are counted in a final +Inf bucket */
+#define METRICS_LATENCY_BUCKET_COUNT 16
+
+/* Bytes of the request of a scrape that are read before responding. The request itself is ignored */
+#define METRICS_REQUEST_BUFFER_SIZE 1024
+
+struct metrics_latency {
+	_Atomic uint64_t buckets[METRICS_LATENCY_BUCKET_COUNT + 1];
+	_Atomic uint64_t sum; /* cycles */
+} CACHE_ALIGNED;
+
+extern const uint32_t metrics_latency_bounds_us[METRICS_LATENCY_BUCKET_COUNT];
+extern pthread_t      metrics_thread_id;
+
+void metrics_initialize(void);
+
+/**
+ * Records a sample in the calling worker's shard of a latency histogram
+ * @param self the shard
+ * @param latency cycles
+ */
+static inline void
+metrics_latency_record(struct metrics_latency *self, uint64_t latency)
+{
+	uint64_t latency_us = latency / runtime_processor_speed_MHz;
+	int      bucket     = 0;
+	while (bucket < METRICS_LATENCY_BUCKET_COUNT && latency_us > metrics_latency_bounds_us[bucket]) bucket++;
+
+	generic_thread_counter_add(&self->buckets[bucket], 1);
+	generic_thread_counter_add(&self->sum, latency);
+}
@@ -5,11 +5,17 @@
 #include <sys/types.h>
 #include <netdb.h>
 
+#include "admissions_codel.h"
+#include "execution_budget.h"
+#include "metrics.h"
 #include "admissions_control.h"
 #include "admissions_info.h"
 #include "awsm_abi.h"
 #include "http.h"
+#include "module_snapshot.h"
 #include "panic.h"
+#include "runtime.h"
+#include "sandbox_idle_list.h"
 #include "types.h"
 
 #define MODULE_DEFAULT_REQUEST_RESPONSE_SIZE (PAGE_SIZE)
@@ -34,14 +40,16 @@
 
 struct module {
 	/* Metadata from JSON Config */
-	char                   name[MODULE_MAX_NAME_LENGTH];
-	char                   path[MODULE_MAX_PATH_LENGTH];
-	uint32_t               stack_size; /* a specification? */
-	uint64_t               max_memory; /* perhaps a specification of the module. (max 4GB) */
-	uint32_t               relative_deadline_us;
-	int                    port;
-	struct admissions_info admissions_info;
-	uint64_t               relative_deadline; /* cycles */
+	char                    name[MODULE_MAX_NAME_LENGTH];
+	char                    path[MODULE_MAX_PATH_LENGTH];
+	uint32_t                stack_size; /* a specification? */
+	uint64_t                max_memory; /* perhaps a specification of the module. (max 4GB) */
+	uint32_t                relative_deadline_us;
+	int                     port;
+	struct admissions_info  admissions_info;
+	struct admissions_codel admissions_codel;
+	uint64_t                relative_deadline; /* cycles */
+	struct execution_budget execution_budget;
 
 	/* HTTP State */
 	size_t             max_request_size;
@@ -49,6 +57,21 @@ struct module {
 	char               response_content_type[HTTP_MAX_HEADER_VALUE_LENGTH];
 	struct sockaddr_in socket_address;
 	int                socket_descriptor;
+	int                worker_socket_descriptors[RUNTIME_MAX_WORKER_COUNT]; /* Used if runtime_worker_accept_enabled */
+	uint32_t           max_requests_per_connection; /* Keep-alive limit. 0 is unlimited */
+
+	/* Percentage of requests traced when SLEDGE_TRACE is set */
+	uint32_t trace_sample_percent;
+
+	/* Stage to hand the response to rather than responding to the client. NULL if this is the final stage */
+	struct module *next_stage;
+
+	/* The entrypoint starts once the headers are received, and wasm_read receives the body on demand */
+	bool stream_request_body;
+
+	/* Completed sandboxes are reset and kept warm for the next request rather than freed */
+	bool                     reuse_instances;
+	struct sandbox_idle_list idle_sandboxes[RUNTIME_MAX_WORKER_COUNT];
 
 	/* Handle and ABI Symbols for *.so file */
 	struct awsm_abi abi;
@@ -56,9 +79,22 @@ struct module {
 	_Atomic uint32_t            reference_count; /* ref count how many instances exist here. */
 	struct indirect_table_entry indirect_table[INDIRECT_TABLE_SIZE];
 
+	/* Copy-on-write template of initialized linear memory */
+	struct module_snapshot snapshot;
+
+	/* Largest linear memory size (bytes) of a sandbox that ran to completion. Prefaulted up to by expand_memory */
+	_Atomic uint32_t memory_high_water_mark;
+
     // TODO: should domain be associated with module or request?
     // domain of -1 means all untrusted...
     int32_t domain;
+    uint32_t domain_slot; /* Slot of the domain in the gang domain registry. Only set for the GANG scheduler */
+
+	/* Requests failed at dequeue because they could no longer meet their deadline */
+	_Atomic uint64_t early_rejection_count;
+
+	/* Latency of completed sandboxes, sharded by worker */
+	struct metrics_latency latency[RUNTIME_MAX_WORKER_COUNT];
 };
 
 /*************************
@@ -77,6 +113,20 @@ module_acquire(struct module *module)
 	return;
 }
 
+/**
+ * Raise a module's memory high-water mark to the linear memory size of a completed sandbox
+ * @param module
+ * @param memory_size linear memory size in bytes
+ */
+static inline void
+module_update_memory_high_water_mark(struct module *module, uint32_t memory_size)
+{
+	uint32_t high_water_mark = atomic_load(&module->memory_high_water_mark);
+	while (memory_size > high_water_mark) {
+		if (atomic_compare_exchange_weak(&module->memory_high_water_mark, &high_water_mark, memory_size)) break;
+	}
+}
+
 /**
  * Invoke a module's initialize_globals if the symbol was present in the *.so file.
  * This is present when aWsm is run with the --runtime-globals flag and absent otherwise.
@@ -152,5 +202,6 @@ module_release(struct module *module)
 void module_free(struct module *module);
 struct module *
     module_new(char *mod_name, char *mod_path, uint32_t stack_sz, uint32_t max_heap, uint32_t relative_deadline_us,
-               int port, int req_sz, int resp_sz, int admissions_percentile, uint32_t expected_execution_us, int32_t domain);
+               int port, int req_sz, int resp_sz, int admissions_percentile, uint32_t expected_execution_us, int32_t domain,
+               uint32_t domain_weight);
 int module_new_from_json(char *filename);
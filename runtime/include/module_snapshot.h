@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "wasm_types.h"
+
+/*
+ * A copy-on-write template of a module's linear memory, captured after the first sandbox of a module completes
+ * initialization of its data segments, arguments, and libc. Later sandboxes privately map the template over their
+ * linear memory instead of repeating initialization, so cold start becomes a page table operation
+ *
+ * WebAssembly globals are not part of the snapshot. These live in the *.so and are reset by initialize_globals, which
+ * is valid because libc initialization leaves the globals (e.g. the stack pointer) at their initial values.
+ */
+
+enum module_snapshot_state
+{
+	MODULE_SNAPSHOT_DISABLED  = 0,
+	MODULE_SNAPSHOT_EMPTY     = 1,
+	MODULE_SNAPSHOT_CAPTURING = 2,
+	MODULE_SNAPSHOT_READY     = 3,
+	MODULE_SNAPSHOT_FAILED    = 4
+};
+
+struct module_snapshot {
+	_Atomic enum module_snapshot_state state;
+	int                                file_descriptor; /* memfd backing the template */
+	uint32_t                           memory_size;     /* bytes of linear memory in the template */
+	int32_t                            arguments_offset;
+};
+
+void module_snapshot_initialize(struct module_snapshot *snapshot, bool is_enabled);
+void module_snapshot_capture(struct module_snapshot *snapshot, char *name, struct wasm_memory *memory,
+                             int32_t arguments_offset);
+void module_snapshot_restore(struct module_snapshot *snapshot, struct wasm_memory *memory, int32_t *arguments_offset);
+
+static inline bool
+module_snapshot_is_ready(struct module_snapshot *snapshot)
+{
+	return atomic_load(&snapshot->state) == MODULE_SNAPSHOT_READY;
+}
@@ -2,9 +2,9 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
-#include "lock.h"
 #include "panic.h"
 #include "perf_window_t.h"
 #include "runtime.h"
@@ -19,56 +19,54 @@ perf_window_initialize(struct perf_window *self)
 {
 	assert(self != NULL);
 
-	LOCK_INIT(&self->lock);
+	size_t shards_size = sizeof(struct perf_window_shard) * RUNTIME_MAX_WORKER_COUNT;
+	if (unlikely(posix_memalign((void **)&self->shards, CACHE_LINE_SIZE, shards_size) != 0))
+		panic("Failed to allocate perf window shards\n");
+
+	for (int i = 0; i < RUNTIME_MAX_WORKER_COUNT; i++) {
+		for (int j = 0; j < PERF_WINDOW_BUCKET_COUNT; j++) atomic_init(&self->shards[i].buckets[j], 0);
+	}
+
 	self->count = 0;
-	memset(&self->by_duration, 0, sizeof(struct execution_node) * PERF_WINDOW_BUFFER_SIZE);
-	memset(&self->by_termination, 0, sizeof(uint16_t) * PERF_WINDOW_BUFFER_SIZE);
+	memset(&self->merged, 0, sizeof(uint64_t) * PERF_WINDOW_BUCKET_COUNT);
 }
 
-
 /**
- * Swaps two execution nodes in the by_duration array, including updating the indices in the by_termination circular
- * buffer
- * @param self
- * @param first_by_duration_idx
- * @param second_by_duration_idx
+ * Maps a value to its log-linear bucket
+ * @param value
+ * @returns bucket index
  */
-static inline void
-perf_window_swap(struct perf_window *self, uint16_t first_by_duration_idx, uint16_t second_by_duration_idx)
+static inline uint32_t
+perf_window_bucket_of(uint64_t value)
 {
-	assert(LOCK_IS_LOCKED(&self->lock));
-	assert(self != NULL);
-	assert(first_by_duration_idx >= 0 && first_by_duration_idx < PERF_WINDOW_BUFFER_SIZE);
-	assert(second_by_duration_idx >= 0 && second_by_duration_idx < PERF_WINDOW_BUFFER_SIZE);
+	if (value < PERF_WINDOW_SUB_BUCKET_COUNT) return (uint32_t)value;
 
-	uint16_t first_by_termination_idx  = self->by_duration[first_by_duration_idx].by_termination_idx;
-	uint16_t second_by_termination_idx = self->by_duration[second_by_duration_idx].by_termination_idx;
+	uint32_t exponent = 63 - __builtin_clzll(value);
+	if (unlikely(exponent > PERF_WINDOW_MAX_EXPONENT)) return PERF_WINDOW_BUCKET_COUNT - 1;
 
-	/* The execution node's by_termination_idx points to a by_termination cell equal to its own by_duration index */
-	assert(self->by_termination[first_by_termination_idx] == first_by_duration_idx);
-	assert(self->by_termination[second_by_termination_idx] == second_by_duration_idx);
-
-	uint64_t first_execution_time  = self->by_duration[first_by_duration_idx].execution_time;
-	uint64_t second_execution_time = self->by_duration[second_by_duration_idx].execution_time;
+	uint32_t sub_bucket = (value >> (exponent - PERF_WINDOW_SUB_BUCKET_BITS)) & (PERF_WINDOW_SUB_BUCKET_COUNT - 1);
+	return (exponent - PERF_WINDOW_SUB_BUCKET_BITS + 1) * PERF_WINDOW_SUB_BUCKET_COUNT + sub_bucket;
+}
 
-	/* Swap Indices in Buffer*/
-	self->by_termination[first_by_termination_idx]  = second_by_duration_idx;
-	self->by_termination[second_by_termination_idx] = first_by_duration_idx;
+/**
+ * Maps a bucket to the largest value it holds, so percentiles read from the window never underestimate
+ * @param bucket
+ * @returns value
+ */
+static inline uint64_t
+perf_window_value_of(uint32_t bucket)
+{
+	assert(bucket < PERF_WINDOW_BUCKET_COUNT);
 
-	/* Swap by_termination_idx */
-	struct execution_node tmp_node            = self->by_duration[first_by_duration_idx];
-	self->by_duration[first_by_duration_idx]  = self->by_duration[second_by_duration_idx];
-	self->by_duration[second_by_duration_idx] = tmp_node;
+	if (bucket < PERF_WINDOW_SUB_BUCKET_COUNT) return bucket;
 
-	/* The circular by_termination indices should always point to the same execution times across all swaps  */
-	assert(self->by_duration[self->by_termination[first_by_termination_idx]].execution_time
-	       == first_execution_time);
-	assert(self->by_duration[self->by_termination[second_by_termination_idx]].execution_time
-	       == second_execution_time);
+	uint32_t exponent   = bucket / PERF_WINDOW_SUB_BUCKET_COUNT - 1 + PERF_WINDOW_SUB_BUCKET_BITS;
+	uint64_t sub_bucket = bucket % PERF_WINDOW_SUB_BUCKET_COUNT;
+	return ((PERF_WINDOW_SUB_BUCKET_COUNT + sub_bucket + 1) << (exponent - PERF_WINDOW_SUB_BUCKET_BITS)) - 1;
 }
 
 /**
- * Adds a new value to the perf window
+ * Adds a new value to the calling worker's shard of the perf window
  * Not intended to be called directly!
  * @param self
  * @param value
@@ -78,83 +76,81 @@ perf_window_add(struct perf_window *self, uint64_t value)
 {
 	assert(self != NULL);
 
-	uint16_t idx_of_oldest;
-	bool     check_up;
-
-	if (unlikely(!LOCK_IS_LOCKED(&self->lock))) panic("lock not held when calling perf_window_add\n");
-
 	/* A successful invocation should run for a non-zero amount of time */
 	assert(value > 0);
 
-	/* If count is 0, then fill entire array with initial execution times */
-	if (self->count == 0) {
-		for (int i = 0; i < PERF_WINDOW_BUFFER_SIZE; i++) {
-			self->by_termination[i] = i;
-			self->by_duration[i]    = (struct execution_node){ .execution_time     = value,
-                                                                        .by_termination_idx = i };
-		}
-		self->count = PERF_WINDOW_BUFFER_SIZE;
-		goto done;
-	}
+	/* Only this worker increments its shard, so the increment need not be atomic with respect to other writers. It
+	 * must only be atomic with respect to the aggregator's drain */
+	atomic_fetch_add_explicit(&self->shards[worker_thread_idx].buckets[perf_window_bucket_of(value)], 1,
+	                          memory_order_relaxed);
+}
 
-	/* Otherwise, replace the oldest value, and then sort */
-	idx_of_oldest = self->by_termination[self->count % PERF_WINDOW_BUFFER_SIZE];
-	check_up      = value > self->by_duration[idx_of_oldest].execution_time;
+/**
+ * Drains every shard into the merged histogram, halving the histogram while it exceeds PERF_WINDOW_CAPACITY
+ * Weights are fixed-point, so halving keeps rare tail executions in proportion rather than truncating them to zero
+ * Only called by the perf window aggregator
+ * @param self
+ * @returns the number of values merged
+ */
+static inline uint64_t
+perf_window_merge(struct perf_window *self)
+{
+	assert(self != NULL);
 
-	self->by_duration[idx_of_oldest].execution_time = value;
+	uint64_t merged_count = 0;
 
-	if (check_up) {
-		for (uint16_t i = idx_of_oldest;
-		     i + 1 < PERF_WINDOW_BUFFER_SIZE
-		     && self->by_duration[i + 1].execution_time < self->by_duration[i].execution_time;
-		     i++) {
-			perf_window_swap(self, i, i + 1);
-		}
-	} else {
-		for (int i = idx_of_oldest;
-		     i - 1 >= 0 && self->by_duration[i - 1].execution_time > self->by_duration[i].execution_time; i--) {
-			perf_window_swap(self, i, i - 1);
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		struct perf_window_shard *shard = &self->shards[i];
+		for (int j = 0; j < PERF_WINDOW_BUCKET_COUNT; j++) {
+			if (atomic_load_explicit(&shard->buckets[j], memory_order_relaxed) == 0) continue;
+
+			uint32_t count = atomic_exchange_explicit(&shard->buckets[j], 0, memory_order_relaxed);
+			self->merged[j] += (uint64_t)count << PERF_WINDOW_WEIGHT_SHIFT;
+			merged_count += count;
 		}
 	}
 
-	/* The idx that we replaces should still point to the same value */
-	assert(self->by_duration[self->by_termination[self->count % PERF_WINDOW_BUFFER_SIZE]].execution_time == value);
+	self->count += merged_count << PERF_WINDOW_WEIGHT_SHIFT;
 
-/* The by_duration array should be ordered by execution time */
-#ifndef NDEBUG
-	for (int i = 1; i < PERF_WINDOW_BUFFER_SIZE; i++) {
-		assert(self->by_duration[i - 1].execution_time <= self->by_duration[i].execution_time);
+	while (self->count > ((uint64_t)PERF_WINDOW_CAPACITY << PERF_WINDOW_WEIGHT_SHIFT)) {
+		self->count = 0;
+		for (int j = 0; j < PERF_WINDOW_BUCKET_COUNT; j++) {
+			self->merged[j] /= 2;
+			self->count += self->merged[j];
+		}
 	}
-#endif
 
-	self->count++;
-
-done:
-	return;
+	return merged_count;
 }
 
 /**
- * Returns pXX execution time
+ * Returns pXX execution time from the merged histogram
+ * Only called by the perf window aggregator
  * @param self
  * @param percentile represented by int between 50 and 99
- * @param precomputed_index memoized index for quick lookup when by_duration is full
  * @returns execution time
  */
 static inline uint64_t
-perf_window_get_percentile(struct perf_window *self, int percentile, int precomputed_index)
+perf_window_get_percentile(struct perf_window *self, int percentile)
 {
 	assert(self != NULL);
 	assert(percentile >= 50 && percentile <= 99);
-	int size = self->count;
-	assert(size > 0);
+	assert(self->count > 0);
+
+	/* The weight that must be exceeded. For whole counts, this matches the value of rank count * percentile / 100 + 1 */
+	uint64_t threshold  = self->count * percentile / 100;
+	uint64_t cumulative = 0;
 
-	if (likely(size >= PERF_WINDOW_BUFFER_SIZE)) return self->by_duration[precomputed_index].execution_time;
+	for (uint32_t i = 0; i < PERF_WINDOW_BUCKET_COUNT; i++) {
+		cumulative += self->merged[i];
+		if (cumulative > threshold) return perf_window_value_of(i);
+	}
 
-	return self->by_duration[size * percentile / 100].execution_time;
+	return perf_window_value_of(PERF_WINDOW_BUCKET_COUNT - 1);
 }
 
 /**
- * Returns the total count of executions
+ * Returns the count of executions in the merged histogram, rounded down to whole executions
  * @returns total count
  */
 static inline uint64_t
@@ -162,5 +158,5 @@ perf_window_get_count(struct perf_window *self)
 {
 	assert(self != NULL);
 
-	return self->count;
+	return self->count >> PERF_WINDOW_WEIGHT_SHIFT;
 }
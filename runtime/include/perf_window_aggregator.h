@@ -0,0 +1,10 @@
+#pragma once
+
+#include <pthread.h>
+
+/* Period at which the shards of each module's perf window are merged and admissions estimates refreshed */
+#define PERF_WINDOW_AGGREGATOR_INTERVAL_US 1000
+
+extern pthread_t perf_window_aggregator_thread_id;
+
+void perf_window_aggregator_initialize(void);
@@ -1,31 +1,53 @@
 #pragma once
 
+#include <stdatomic.h>
 #include <stdint.h>
 
-#include "lock.h"
+#include "runtime.h"
 
-/* Should be Power of 2! */
-#define PERF_WINDOW_BUFFER_SIZE 16
+/*
+ * Number of recent executions the window approximates. When the merged histogram exceeds this count, every bucket is
+ * halved, so older executions decay geometrically rather than leaving the window in strict order of termination
+ */
+#define PERF_WINDOW_CAPACITY 4096
 
-#if ((PERF_WINDOW_BUFFER_SIZE == 0) || (PERF_WINDOW_BUFFER_SIZE & (PERF_WINDOW_BUFFER_SIZE - 1)) != 0)
-#error "PERF_WINDOW_BUFFER_SIZE must be power of 2!"
-#endif
+/*
+ * The merged histogram holds fixed-point weights with this many fractional bits, so halving a bucket holding a
+ * single rare execution halves its weight rather than dropping it
+ */
+#define PERF_WINDOW_WEIGHT_SHIFT 16
 
 /*
- * The by_duration array sorts the last N executions by execution time
- * The by_termination array acts as a circular buffer that maps to indices in the by_duration array
- *
- * by_termination ensures that the when the circular buffer is full, the oldest data in both arrays is
- * overwritten, providing a sorted circular buffer
+ * Executions of a module after which its estimate is representative. The runtime estimates from the first merged
+ * execution, so this only sizes the warm-up of experiments, which scrape it from this file
  */
-struct execution_node {
-	uint64_t execution_time;
-	uint16_t by_termination_idx; /* Reverse idx of the associated by_termination bin. Used for swaps! */
-};
+#define PERF_WINDOW_WARMUP_COUNT 16
 
+/*
+ * Log-linear (HDR) buckets. Each power of two is split into 2^PERF_WINDOW_SUB_BUCKET_BITS linear sub-buckets, so a
+ * bucket spans at most 1 / 2^PERF_WINDOW_SUB_BUCKET_BITS of its values. Values below 2^PERF_WINDOW_SUB_BUCKET_BITS
+ * are counted exactly, and values of 2^(PERF_WINDOW_MAX_EXPONENT + 1) cycles or more share the last bucket
+ */
+#define PERF_WINDOW_SUB_BUCKET_BITS  4
+#define PERF_WINDOW_SUB_BUCKET_COUNT (1 << PERF_WINDOW_SUB_BUCKET_BITS)
+#define PERF_WINDOW_MAX_EXPONENT     40
+#define PERF_WINDOW_BUCKET_COUNT \
+	((PERF_WINDOW_MAX_EXPONENT - PERF_WINDOW_SUB_BUCKET_BITS + 2) * PERF_WINDOW_SUB_BUCKET_COUNT)
+
+/*
+ * Executions recorded by a single worker since the last merge. Only the owning worker increments, and only the
+ * aggregator drains, so the shard's cache line is not shared on the completion path
+ */
+struct perf_window_shard {
+	_Atomic uint32_t buckets[PERF_WINDOW_BUCKET_COUNT];
+} CACHE_ALIGNED;
+
+/*
+ * The shards are periodically drained into the merged histogram by the perf window aggregator, which is the only
+ * reader and writer of merged and count
+ */
 struct perf_window {
-	struct execution_node by_duration[PERF_WINDOW_BUFFER_SIZE];
-	uint16_t              by_termination[PERF_WINDOW_BUFFER_SIZE];
-	uint64_t              count;
-	lock_t                lock;
+	struct perf_window_shard *shards; /* RUNTIME_MAX_WORKER_COUNT shards, allocated on initialization */
+	uint64_t                  merged[PERF_WINDOW_BUCKET_COUNT]; /* Fixed-point weights */
+	uint64_t                  count;                            /* Fixed-point sum of merged */
 };
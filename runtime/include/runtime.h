@@ -24,12 +24,34 @@ enum RUNTIME_SIGALRM_HANDLER
 	RUNTIME_SIGALRM_HANDLER_TRIAGED   = 1
 };
 
+enum RUNTIME_SIGALRM_TIMER
+{
+	RUNTIME_SIGALRM_TIMER_PROCESS  = 0, /* One setitimer, relayed to the other workers by the receiving worker */
+	RUNTIME_SIGALRM_TIMER_THREAD   = 1, /* A timer_create timer per worker, each delivering to its own worker */
+	RUNTIME_SIGALRM_TIMER_TICKLESS = 2  /* A one-shot timer per worker, armed only when needed. EDF only */
+};
+
 extern bool                         runtime_preemption_enabled;
 extern bool                         runtime_sync_switches;
 extern bool                         runtime_domains;
+extern bool                         runtime_domain_affinity_enabled;
+extern bool                         runtime_sandbox_pool_enabled;
+extern bool                         runtime_worker_accept_enabled;
+extern bool                         runtime_keepalive_enabled;
+extern uint32_t                     runtime_keepalive_timeout_us;
+extern bool                         runtime_work_stealing_enabled;
+extern bool                         runtime_gang_epoch_enabled;
+extern uint32_t                     runtime_gang_group_size;
+extern bool                         runtime_admissions_codel_enabled;
+extern uint32_t                     runtime_admissions_codel_target_percent;
+extern bool                         runtime_admissions_adaptive_overhead_enabled;
+extern bool                         runtime_early_rejection_enabled;
+extern int                          runtime_early_rejection_status_code;
+extern uint16_t                     runtime_metrics_port;
 extern uint32_t                     runtime_processor_speed_MHz;
 extern uint32_t                     runtime_quantum_us;
 extern enum RUNTIME_SIGALRM_HANDLER runtime_sigalrm_handler;
+extern enum RUNTIME_SIGALRM_TIMER   runtime_sigalrm_timer;
 extern pthread_t *                  runtime_worker_threads;
 extern uint32_t                     runtime_worker_threads_count;
 extern int *                        runtime_worker_threads_argument;
@@ -42,6 +64,7 @@ extern void runtime_set_resource_limits_to_max(void);
 /* External Symbols */
 extern void  alloc_linear_memory(void);
 extern int   expand_memory(void);
+extern int   expand_memory_pages(uint32_t page_count);
 INLINE char *get_function_from_table(uint32_t idx, uint32_t type_id);
 INLINE char *get_memory_ptr_for_runtime(uint32_t offset, uint32_t bounds_check);
 extern void  stub_init(int32_t offset);
@@ -56,3 +79,16 @@ runtime_print_sigalrm_handler(enum RUNTIME_SIGALRM_HANDLER variant)
 		return "TRIAGED";
 	}
 }
+
+static inline char *
+runtime_print_sigalrm_timer(enum RUNTIME_SIGALRM_TIMER variant)
+{
+	switch (variant) {
+	case RUNTIME_SIGALRM_TIMER_PROCESS:
+		return "PROCESS";
+	case RUNTIME_SIGALRM_TIMER_THREAD:
+		return "THREAD";
+	case RUNTIME_SIGALRM_TIMER_TICKLESS:
+		return "TICKLESS";
+	}
+}
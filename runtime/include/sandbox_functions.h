@@ -5,7 +5,10 @@
 #include <stdint.h>
 
 #include "client_socket.h"
+#include "connection_table.h"
+#include "io_engine.h"
 #include "panic.h"
+#include "sandbox_pool.h"
 #include "sandbox_request.h"
 
 /***************************
@@ -22,21 +25,31 @@ sandbox_close_http(struct sandbox *sandbox)
 {
 	assert(sandbox != NULL);
 
-	int rc = epoll_ctl(worker_thread_epoll_file_descriptor, EPOLL_CTL_DEL, sandbox->client_socket_descriptor, NULL);
-	if (unlikely(rc < 0)) panic_err();
+	/* Park the connection for the client's next request */
+	if (sandbox->keep_alive) {
+		io_engine_release(sandbox);
+		connection_table_add(sandbox->module, sandbox->client_socket_descriptor, &sandbox->client_address,
+		                     sandbox->connection_request_count + 1);
+		return;
+	}
 
-	client_socket_close(sandbox->client_socket_descriptor, &sandbox->client_address);
+	io_engine_close(sandbox);
 }
 
 /**
  * Free Linear Memory, leaving stack in place
+ * If the sandbox pool is enabled, linear memory is instead reset in place so the reservation can be recycled
  * @param sandbox
  */
 static inline void
 sandbox_free_linear_memory(struct sandbox *sandbox)
 {
-	int rc = munmap(sandbox->memory.start, sandbox->memory.max + PAGE_SIZE);
-	if (rc == -1) panic("sandbox_free_linear_memory - munmap failed\n");
+	if (runtime_sandbox_pool_enabled) {
+		sandbox_pool_reset_linear_memory(sandbox);
+	} else {
+		int rc = munmap(sandbox->memory.start, sandbox->memory.max + PAGE_SIZE);
+		if (rc == -1) panic("sandbox_free_linear_memory - munmap failed\n");
+	}
 	sandbox->memory.start = NULL;
 }
 
@@ -75,11 +88,5 @@ sandbox_open_http(struct sandbox *sandbox)
 	/* Set the sandbox as the data the http-parser has access to */
 	sandbox->http_parser.data = sandbox;
 
-	/* Freshly allocated sandbox going runnable for first time, so register client socket with epoll */
-	struct epoll_event accept_evt;
-	accept_evt.data.ptr = (void *)sandbox;
-	accept_evt.events   = EPOLLIN | EPOLLOUT | EPOLLET;
-	int rc = epoll_ctl(worker_thread_epoll_file_descriptor, EPOLL_CTL_ADD, sandbox->client_socket_descriptor,
-	                   &accept_evt);
-	if (unlikely(rc < 0)) panic_err();
+	io_engine_open(sandbox);
 }
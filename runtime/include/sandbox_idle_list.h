@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "runtime.h"
+#include "types.h"
+
+/*
+ * Warm instances of modules that set reuse-instances in the module JSON
+ *
+ * Rather than being freed, a sandbox that completed is reset and kept on an idle list of its module for the worker
+ * that ran it. The next request of the module on that worker runs in the warm sandbox instead of a freshly allocated
+ * one. Its memory reservation, stack, and HTTP buffers are never unmapped or discarded, so their pages stay resident.
+ * Linear memory is trimmed to its initial size and zeroed in place, and current_sandbox_init restores the data
+ * segments as for any new sandbox.
+ */
+
+struct module;
+struct sandbox;
+
+#define SANDBOX_IDLE_LIST_CAPACITY 8 /* Warm sandboxes kept per module per worker */
+
+struct sandbox_idle_list {
+	struct sandbox *sandboxes[SANDBOX_IDLE_LIST_CAPACITY];
+	uint32_t        count;
+} CACHE_ALIGNED;
+
+struct sandbox_idle_list_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t overflows; /* Completed sandboxes freed because the idle list was full */
+} CACHE_ALIGNED;
+
+extern struct sandbox_idle_list_stats sandbox_idle_list_stats[RUNTIME_MAX_WORKER_COUNT];
+extern uint32_t                       sandbox_idle_list_module_count;
+
+int             sandbox_idle_list_add(struct sandbox *sandbox);
+struct sandbox *sandbox_idle_list_remove(struct module *module);
+void            sandbox_idle_list_stats_print(void);
@@ -1,70 +1,134 @@
 #pragma once
 
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "arch/getcycles.h"
+#include "generic_thread.h"
 #include "runtime.h"
+#include "sandbox_perf_log_record.h"
+#include "sandbox_request.h"
 #include "sandbox_types.h"
+#include "worker_thread.h"
+
+/*
+ * Per-sandbox performance log, written to the file named by SLEDGE_SANDBOX_PERF_LOG
+ *
+ * Workers copy a fixed-size binary record into their own single-producer single-consumer ring, and a writer thread on
+ * the listener core drains the rings into the file. Workers thus never format text, take stdio locks, or block on I/O.
+ * If a worker's ring is full, the record is dropped and counted. bin/sledge_perf_log_to_csv converts a log to CSV.
+ */
+
+#define SANDBOX_PERF_LOG_RING_CAPACITY      4096 /* Records per worker. Must be a power of 2 */
+#define SANDBOX_PERF_LOG_WRITER_INTERVAL_US 10000
+#define SANDBOX_PERF_LOG_BUFFER_SIZE        (1 << 20)
 
-extern FILE *sandbox_perf_log;
+static_assert(SANDBOX_PERF_LOG_STATE_COUNT == SANDBOX_STATE_COUNT, "perf log records must hold every state");
+static_assert(SANDBOX_PERF_LOG_MODULE_NAME_LENGTH == MODULE_MAX_NAME_LENGTH, "perf log records must hold any name");
+static_assert((SANDBOX_PERF_LOG_RING_CAPACITY & (SANDBOX_PERF_LOG_RING_CAPACITY - 1)) == 0,
+              "SANDBOX_PERF_LOG_RING_CAPACITY must be a power of 2");
+
+/* The worker and the writer thread each write their own index, so the indices are on separate cache lines */
+struct sandbox_perf_log_ring {
+	_Atomic uint64_t tail;    /* Next slot written by the worker */
+	_Atomic uint64_t dropped; /* Records discarded because the ring was full */
+	CACHE_ALIGNED _Atomic uint64_t head; /* Next slot read by the writer thread */
+	struct sandbox_perf_log_record records[SANDBOX_PERF_LOG_RING_CAPACITY];
+} CACHE_ALIGNED;
+
+extern FILE *                        sandbox_perf_log;
+extern struct sandbox_perf_log_ring *sandbox_perf_log_rings;
+
+void sandbox_perf_log_init(void);
+void sandbox_perf_log_writer_initialize(void);
+void sandbox_perf_log_cleanup(void);
 
 /**
- * @brief Prints headers for the per-sandbox perf logs
+ * Reserves the next record of the calling worker's ring
+ * @returns the record to fill before calling sandbox_perf_log_commit, or NULL if the log is disabled or the ring is
+ * full, in which case the record is counted as dropped
+ */
+static inline struct sandbox_perf_log_record *
+sandbox_perf_log_reserve(void)
+{
+	/* If the log was not defined by an environment variable, early out */
+	if (sandbox_perf_log_rings == NULL) return NULL;
+
+	struct sandbox_perf_log_ring *ring = &sandbox_perf_log_rings[worker_thread_idx];
+	uint64_t                      tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	if (unlikely(tail - atomic_load_explicit(&ring->head, memory_order_acquire) == SANDBOX_PERF_LOG_RING_CAPACITY)) {
+		generic_thread_counter_add(&ring->dropped, 1);
+		return NULL;
+	}
+
+	return &ring->records[tail & (SANDBOX_PERF_LOG_RING_CAPACITY - 1)];
+}
+
+/**
+ * Publishes the record returned by the last sandbox_perf_log_reserve to the writer thread
  */
 static inline void
-sandbox_perf_log_print_header()
+sandbox_perf_log_commit(void)
 {
-	if (sandbox_perf_log == NULL) { perror("sandbox perf log"); }
-	fprintf(sandbox_perf_log,
-	        "id,module,port,state,deadline,actual,queued,uninitialized,allocated,initialized,runnable,preempted,"
-	        "running_sys,running_user,asleep,returned,complete,error,proc_MHz,memory\n");
+	struct sandbox_perf_log_ring *ring = &sandbox_perf_log_rings[worker_thread_idx];
+	atomic_store_explicit(&ring->tail, atomic_load_explicit(&ring->tail, memory_order_relaxed) + 1,
+	                      memory_order_release);
 }
 
 /**
- * Prints key performance metrics for a sandbox to sandbox_perf_log
- * This is defined by an environment variable
+ * Logs key performance metrics of a sandbox
  * @param sandbox
  */
 static inline void
 sandbox_perf_log_print_entry(struct sandbox *sandbox)
 {
-	/* If the log was not defined by an environment variable, early out */
-	if (sandbox_perf_log == NULL) return;
-
-	uint64_t queued_duration = sandbox->timestamp_of.allocation - sandbox->timestamp_of.request_arrival;
+	struct sandbox_perf_log_record *record = sandbox_perf_log_reserve();
+	if (record == NULL) return;
 
+	record->id                = sandbox->id;
+	record->relative_deadline = sandbox->module->relative_deadline;
+	record->total_time        = sandbox->total_time;
+	record->queued            = sandbox->timestamp_of.allocation - sandbox->timestamp_of.request_arrival;
+	memcpy(record->duration_of_state, sandbox->duration_of_state, sizeof(record->duration_of_state));
 	/*
 	 * Assumption: A sandbox is never able to free pages. If linear memory management
 	 * becomes more intelligent, then peak linear memory size needs to be tracked
 	 * seperately from current linear memory size.
 	 */
-	fprintf(sandbox_perf_log, "%lu,%s,%d,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%u,%u\n",
-	        sandbox->id, sandbox->module->name, sandbox->module->port, sandbox_state_stringify(sandbox->state),
-	        sandbox->module->relative_deadline, sandbox->total_time, queued_duration,
-	        sandbox->duration_of_state[SANDBOX_UNINITIALIZED], sandbox->duration_of_state[SANDBOX_ALLOCATED],
-	        sandbox->duration_of_state[SANDBOX_INITIALIZED], sandbox->duration_of_state[SANDBOX_RUNNABLE],
-	        sandbox->duration_of_state[SANDBOX_PREEMPTED], sandbox->duration_of_state[SANDBOX_RUNNING_SYS],
-	        sandbox->duration_of_state[SANDBOX_RUNNING_USER], sandbox->duration_of_state[SANDBOX_ASLEEP],
-	        sandbox->duration_of_state[SANDBOX_RETURNED], sandbox->duration_of_state[SANDBOX_COMPLETE],
-	        sandbox->duration_of_state[SANDBOX_ERROR], runtime_processor_speed_MHz, sandbox->memory.size);
-}
+	record->memory_size = sandbox->memory.size;
+	record->port        = sandbox->module->port;
+	strncpy(record->module, sandbox->module->name, sizeof(record->module));
+	strncpy(record->state, sandbox_state_stringify(sandbox->state), sizeof(record->state));
 
-static inline void
-sandbox_perf_log_init()
-{
-	char *sandbox_perf_log_path = getenv("SLEDGE_SANDBOX_PERF_LOG");
-	if (sandbox_perf_log_path != NULL) {
-		printf("\tSandbox Performance Log: %s\n", sandbox_perf_log_path);
-		sandbox_perf_log = fopen(sandbox_perf_log_path, "w");
-		if (sandbox_perf_log == NULL) perror("sandbox_perf_log_init\n");
-		sandbox_perf_log_print_header();
-	} else {
-		printf("\tSandbox Performance Log: Disabled\n");
-	}
+	sandbox_perf_log_commit();
 }
 
+/**
+ * Logs a request failed before a sandbox was allocated for it. Durations of sandbox states are zero
+ * @param sandbox_request
+ * @param state label of why the request failed
+ */
 static inline void
-sandbox_perf_log_cleanup()
+sandbox_perf_log_print_request_entry(struct sandbox_request *sandbox_request, const char *state)
 {
-	if (sandbox_perf_log != NULL) {
-		fflush(sandbox_perf_log);
-		fclose(sandbox_perf_log);
-	}
+	struct sandbox_perf_log_record *record = sandbox_perf_log_reserve();
+	if (record == NULL) return;
+
+	uint64_t queued_duration = __getcycles() - sandbox_request->request_arrival_timestamp;
+
+	record->id                = sandbox_request->id;
+	record->relative_deadline = sandbox_request->module->relative_deadline;
+	record->total_time        = queued_duration;
+	record->queued            = queued_duration;
+	memset(record->duration_of_state, 0, sizeof(record->duration_of_state));
+	record->memory_size = 0;
+	record->port        = sandbox_request->module->port;
+	strncpy(record->module, sandbox_request->module->name, sizeof(record->module));
+	strncpy(record->state, state, sizeof(record->state));
+
+	sandbox_perf_log_commit();
 }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Binary format of the sandbox perf log: a struct sandbox_perf_log_header followed by fixed-size records in the byte
+ * order of the host. The offline converter in tools/ shares this header, so it only depends on libc.
+ */
+
+#define SANDBOX_PERF_LOG_MAGIC              "SLEDGEPL"
+#define SANDBOX_PERF_LOG_VERSION            1
+#define SANDBOX_PERF_LOG_STATE_COUNT        11 /* Equal to SANDBOX_STATE_COUNT */
+#define SANDBOX_PERF_LOG_MODULE_NAME_LENGTH 32 /* Equal to MODULE_MAX_NAME_LENGTH */
+#define SANDBOX_PERF_LOG_STATE_LENGTH       16
+
+struct sandbox_perf_log_header {
+	char     magic[8];
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t processor_speed_MHz;
+	uint32_t state_count;
+};
+
+struct sandbox_perf_log_record {
+	uint64_t id;
+	uint64_t relative_deadline; /* cycles */
+	uint64_t total_time;        /* cycles */
+	uint64_t queued;            /* cycles */
+	uint64_t duration_of_state[SANDBOX_PERF_LOG_STATE_COUNT]; /* cycles */
+	uint32_t memory_size;                                      /* bytes */
+	int32_t  port;
+	char     module[SANDBOX_PERF_LOG_MODULE_NAME_LENGTH]; /* NUL-terminated unless it fills the array */
+	char     state[SANDBOX_PERF_LOG_STATE_LENGTH];        /* Sandbox state, or why a request was failed */
+};
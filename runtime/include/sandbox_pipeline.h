@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "runtime.h"
+#include "types.h"
+
+/*
+ * Function composition pipelines, configured by the next-stage key of the module JSON
+ *
+ * When a sandbox of a module with a next stage returns, its response is not sent to the client. The response buffer
+ * is instead handed to a new sandbox of the next stage as its request body, and that sandbox is made runnable on the
+ * same worker with the absolute deadline of the request. The client socket passes along the pipeline, and only the
+ * final stage responds. Responses of at least SANDBOX_PIPELINE_REMAP_THRESHOLD bytes are moved by remapping their
+ * pages, as both buffers are page-aligned. Smaller responses are copied, which is cheaper than the syscalls.
+ *
+ * Every stage keeps the id of the request, so the perf log and the trace group the stages of a request.
+ * The final stage always closes the connection, as a parked connection would be routed to the final stage.
+ */
+
+struct sandbox;
+
+#define SANDBOX_PIPELINE_REMAP_THRESHOLD (16 * PAGE_SIZE)
+
+struct sandbox_pipeline_stats {
+	uint64_t remaps; /* Handoffs that moved the pages of the response buffer */
+	uint64_t copies; /* Handoffs that copied the response buffer */
+} CACHE_ALIGNED;
+
+extern struct sandbox_pipeline_stats sandbox_pipeline_stats[RUNTIME_MAX_WORKER_COUNT];
+extern uint32_t                      sandbox_pipeline_module_count;
+
+int  sandbox_pipeline_handoff(struct sandbox *sandbox);
+void sandbox_pipeline_stats_print(void);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "module.h"
+#include "runtime.h"
+#include "types.h"
+#include "wasm_types.h"
+
+/*
+ * A per-worker cache of sandbox memory reservations, avoiding the mmap/munmap of the 4GB linear memory reservation
+ * and the stack on every request. Regions are bucketed by layout, so a region is only ever recycled by a module with
+ * the same request buffer, response buffer, and stack sizes
+ */
+
+struct sandbox;
+
+#define SANDBOX_POOL_BUCKET_COUNT    16
+#define SANDBOX_POOL_BUCKET_CAPACITY 32
+
+struct sandbox_pool_entry {
+	void *memory; /* struct sandbox | HTTP Req Buffer | HTTP Resp Buffer | Linear Memory | Guard Page */
+	void *stack;  /* Bottom of the usable stack. A guard page sits immediately below */
+};
+
+struct sandbox_pool_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t overflows; /* Releases that found the bucket full and were unmapped */
+} CACHE_ALIGNED;
+
+extern struct sandbox_pool_stats sandbox_pool_stats[RUNTIME_MAX_WORKER_COUNT];
+
+int  sandbox_pool_add(struct module *module, struct sandbox_pool_entry *entry);
+int  sandbox_pool_remove(struct module *module, struct sandbox_pool_entry *entry);
+void sandbox_pool_reset_linear_memory(struct sandbox *sandbox);
+void sandbox_pool_stats_print(void);
@@ -12,12 +12,15 @@
 #include "http_parser.h"
 #include "http_request.h"
 #include "http_parser_settings.h"
+#include "io_engine.h"
 #include "likely.h"
 #include "sandbox_types.h"
 #include "scheduler.h"
 
 /**
  * Receive and Parse the Request for the current sandbox
+ * If the module streams request bodies, returns once the headers are parsed, and the request buffer from the start of
+ * the body is left to receive the rest of the body on demand
  * @return 0 if message parsing complete, -1 on error, -2 if buffers run out of space
  */
 static inline int
@@ -27,9 +30,12 @@ sandbox_receive_request(struct sandbox *sandbox)
 	assert(sandbox->module->max_request_size > 0);
 	assert(sandbox->request.length == 0);
 
-	int rc = 0;
+	int   rc           = 0;
+	char *stream_start = NULL;
 
 	while (!sandbox->http_request.message_end) {
+		if (sandbox->module->stream_request_body && sandbox->http_request.header_end) goto stream;
+
 		/* Read from the Socket */
 
 		/* Structured to closely follow usage example at https://github.com/nodejs/http-parser */
@@ -41,19 +47,12 @@ sandbox_receive_request(struct sandbox *sandbox)
 			goto err_nobufs;
 		}
 
-		ssize_t bytes_received = recv(sandbox->client_socket_descriptor,
-		                              &sandbox->request.base[sandbox->request.length],
-		                              sandbox->module->max_request_size - sandbox->request.length, 0);
+		ssize_t bytes_received = io_engine_recv(sandbox, &sandbox->request.base[sandbox->request.length],
+		                                        sandbox->module->max_request_size - sandbox->request.length);
 
 		if (bytes_received == -1) {
-			if (errno == EAGAIN) {
-				current_sandbox_sleep();
-				continue;
-			} else {
-				debuglog("Error reading socket %d - %s\n", sandbox->client_socket_descriptor,
-				         strerror(errno));
-				goto err;
-			}
+			debuglog("Error reading socket %d - %s\n", sandbox->client_socket_descriptor, strerror(errno));
+			goto err;
 		}
 
 		/* If we received an EOF before we were able to parse a complete HTTP header, request is malformed */
@@ -93,6 +92,20 @@ sandbox_receive_request(struct sandbox *sandbox)
 	rc = 0;
 done:
 	return rc;
+stream:
+	/* wasm_read consumes the body bytes received with the headers before the stream, so the stream reuses their space */
+	stream_start = sandbox->http_request.body != NULL ? sandbox->http_request.body
+	                                                  : &sandbox->request.base[sandbox->request.length];
+	if (stream_start == &sandbox->request.base[sandbox->module->max_request_size]) {
+		debuglog("Sandbox %lu: Ran out of Request Buffer before the body could be streamed\n", sandbox->id);
+		goto err_nobufs;
+	}
+
+	sandbox->request_stream.base     = stream_start;
+	sandbox->request_stream.capacity = &sandbox->request.base[sandbox->module->max_request_size] - stream_start;
+
+	rc = 0;
+	goto done;
 err_nobufs:
 	rc = -2;
 	goto done;
@@ -100,3 +113,47 @@ err:
 	rc = -1;
 	goto done;
 }
+
+/**
+ * Receives and parses more of the body of a request whose module streams request bodies, sleeping until the client
+ * sends it. The request stream must have been consumed
+ * @param sandbox in the running sys state
+ * @return 0 on success, -1 on error or if the client closed the connection before the end of the body
+ */
+static inline int
+sandbox_receive_request_stream(struct sandbox *sandbox)
+{
+	assert(sandbox != NULL);
+	assert(sandbox->request_stream.base != NULL);
+	assert(sandbox->request_stream.length == 0);
+
+	http_parser *                  parser   = &sandbox->http_parser;
+	const http_parser_settings *   settings = http_parser_settings_get();
+	struct sandbox_request_stream *stream   = &sandbox->request_stream;
+
+	/* The stream is refilled from its start, and the body callback compacts parsed bytes toward it */
+	stream->read = 0;
+	while (stream->length == 0 && !sandbox->http_request.message_end) {
+		ssize_t bytes_received = io_engine_recv(sandbox, stream->base, stream->capacity);
+		if (bytes_received == -1) {
+			debuglog("Error reading socket %d - %s\n", sandbox->client_socket_descriptor, strerror(errno));
+			return -1;
+		}
+
+		if (bytes_received == 0) {
+			debuglog("Sandbox %lu: recv returned 0 before the end of the body\n", sandbox->id);
+			return -1;
+		}
+
+		size_t bytes_parsed = http_parser_execute(parser, settings, stream->base, bytes_received);
+		if (bytes_parsed != bytes_received) {
+			debuglog("Error: %s, Description: %s\n",
+			         http_errno_name((enum http_errno)sandbox->http_parser.http_errno),
+			         http_errno_description((enum http_errno)sandbox->http_parser.http_errno));
+			debuglog("Error parsing socket %d\n", sandbox->client_socket_descriptor);
+			return -1;
+		}
+	}
+
+	return 0;
+}
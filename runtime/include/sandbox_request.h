@@ -26,6 +26,9 @@ struct sandbox_request {
 	 * Calculated by estimated execution time (cycles) * runtime_admissions_granularity / relative deadline (cycles)
 	 */
 	uint64_t admissions_estimate;
+
+	/* Requests previously served on the client connection. Nonzero if the connection was kept alive */
+	uint32_t connection_request_count;
 };
 
 DEQUE_PROTOTYPE(sandbox, struct sandbox_request *)
@@ -85,6 +88,8 @@ sandbox_request_allocate(struct module *module, int socket_descriptor, const str
 	assert(admissions_estimate != 0);
 	sandbox_request->admissions_estimate = admissions_estimate;
 
+	sandbox_request->connection_request_count = 0;
+
 	sandbox_request_log_allocation(sandbox_request);
 
 	return sandbox_request;
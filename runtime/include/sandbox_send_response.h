@@ -8,14 +8,39 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "connection_table.h"
 #include "current_sandbox.h"
 #include "http.h"
 #include "http_total.h"
+#include "io_engine.h"
 #include "likely.h"
+#include "runtime.h"
 #include "sandbox_types.h"
 #include "scheduler.h"
 #include "panic.h"
 
+/**
+ * Determines whether the client connection is parked for another request after the response
+ * Assumption: the parser has reached the end of the request message
+ * @returns true if keep-alive is enabled, the client requested it, the module's per-connection request limit has not
+ * been reached, and the worker's connection table has space
+ */
+static inline bool
+sandbox_should_keep_alive(struct sandbox *sandbox)
+{
+	if (!runtime_keepalive_enabled) return false;
+	/* The connection would be parked for the final stage rather than the module the client requested */
+	if (sandbox->pipeline_stage > 0) return false;
+	/* The module did not consume a streamed body, so the rest of it precedes the next request on the connection */
+	if (!sandbox->http_request.message_end) return false;
+	if (!http_should_keep_alive(&sandbox->http_parser)) return false;
+
+	uint32_t max_requests = sandbox->module->max_requests_per_connection;
+	if (max_requests > 0 && sandbox->connection_request_count + 1 >= max_requests) return false;
+
+	return connection_table_has_space();
+}
+
 /**
  * Sends Response Back to Client
  * @return RC. -1 on Failure
@@ -37,10 +62,12 @@ sandbox_send_response(struct sandbox *sandbox)
 	char *module_content_type = sandbox->module->response_content_type;
 	char *content_type        = strlen(module_content_type) > 0 ? module_content_type : "text/plain";
 
+	sandbox->keep_alive = sandbox_should_keep_alive(sandbox);
+
 	/* Prepend HTTP Response Headers */
-	size_t response_header_size = http_response_200_size(content_type, content_length);
+	size_t response_header_size = http_response_200_size(content_type, content_length, sandbox->keep_alive);
 	char * response_header      = sandbox->response.base - response_header_size;
-	rc                          = http_response_200(response_header, content_type, content_length);
+	rc = http_response_200(response_header, content_type, content_length, sandbox->keep_alive);
 	if (rc < 0) goto err;
 
 	/* Capture Timekeeping data for end-to-end latency */
@@ -48,19 +75,10 @@ sandbox_send_response(struct sandbox *sandbox)
 	sandbox->total_time = end_time - sandbox->timestamp_of.request_arrival;
 
 	/* Send HTTP Response */
-	int    sent          = 0;
 	size_t response_size = response_header_size + response_body_size;
-	while (sent < response_size) {
-		rc = write(sandbox->client_socket_descriptor, response_header, response_size - sent);
-		if (rc < 0) {
-			if (errno == EAGAIN)
-				current_sandbox_sleep();
-			else {
-				perror("write");
-				goto err;
-			}
-		}
-		sent += rc;
+	if (io_engine_send(sandbox, response_header, response_size) < 0) {
+		perror("write");
+		goto err;
 	}
 
 	http_total_increment_2xx();
@@ -69,6 +87,7 @@ sandbox_send_response(struct sandbox *sandbox)
 done:
 	return rc;
 err:
-	rc = -1;
+	sandbox->keep_alive = false;
+	rc                  = -1;
 	goto done;
 }
@@ -8,6 +8,8 @@
 #include "sandbox_types.h"
 #include "sandbox_state.h"
 #include "sandbox_state_history.h"
+#include "trace.h"
+#include "worker_thread.h"
 
 /**
  * Transitions a sandbox to the SANDBOX_ASLEEP state.
@@ -27,6 +29,7 @@ sandbox_set_as_asleep(struct sandbox *sandbox, sandbox_state_t last_state)
 	switch (last_state) {
 	case SANDBOX_RUNNING_SYS: {
 		local_runqueue_delete(sandbox);
+		worker_thread_asleep_count++;
 		break;
 	}
 	default: {
@@ -36,6 +39,7 @@ sandbox_set_as_asleep(struct sandbox *sandbox, sandbox_state_t last_state)
 	}
 
 	/* State Change Bookkeeping */
+	trace_sandbox_state(sandbox, last_state, now);
 	sandbox->duration_of_state[last_state] += (now - sandbox->timestamp_of.last_state_change);
 	sandbox->timestamp_of.last_state_change = now;
 	sandbox_state_history_append(sandbox, SANDBOX_ASLEEP);
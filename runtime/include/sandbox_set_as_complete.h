@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include "arch/getcycles.h"
+#include "cache_protection.h"
 #include "panic.h"
 #include "local_completion_queue.h"
 #include "sandbox_functions.h"
@@ -12,6 +13,7 @@
 #include "sandbox_state_history.h"
 #include "sandbox_summarize_page_allocations.h"
 #include "sandbox_types.h"
+#include "trace.h"
 
 /**
  * Transitions a sandbox from the SANDBOX_RETURNED state to the SANDBOX_COMPLETE state.
@@ -39,6 +41,7 @@ sandbox_set_as_complete(struct sandbox *sandbox, sandbox_state_t last_state)
 	}
 
 	/* State Change Bookkeeping */
+	trace_sandbox_state(sandbox, last_state, now);
 	sandbox->duration_of_state[last_state] += (now - sandbox->timestamp_of.last_state_change);
 	sandbox->timestamp_of.last_state_change = now;
 	sandbox_state_history_append(sandbox, SANDBOX_COMPLETE);
@@ -49,8 +52,12 @@ sandbox_set_as_complete(struct sandbox *sandbox, sandbox_state_t last_state)
 	admissions_info_update(&sandbox->module->admissions_info, sandbox->duration_of_state[SANDBOX_RUNNING_USER]
 	                                                            + sandbox->duration_of_state[SANDBOX_RUNNING_SYS]);
 	admissions_control_subtract(sandbox->admissions_estimate);
+	/* A demoted sandbox overran its budget, so it counts as a miss even though its deadline was pushed back */
+	admissions_control_record_completion(sandbox->is_demoted || now > sandbox->absolute_deadline);
+	metrics_latency_record(&sandbox->module->latency[worker_thread_idx], sandbox->total_time);
 
 	/* Terminal State Logging */
+	cache_protection_record_completion(sandbox);
 	sandbox_perf_log_print_entry(sandbox);
 	sandbox_summarize_page_allocations(sandbox);
 
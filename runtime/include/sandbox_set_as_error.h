@@ -12,6 +12,7 @@
 #include "sandbox_state_history.h"
 #include "sandbox_summarize_page_allocations.h"
 #include "panic.h"
+#include "trace.h"
 
 /**
  * Transitions a sandbox to the SANDBOX_ERROR state.
@@ -48,6 +49,7 @@ sandbox_set_as_error(struct sandbox *sandbox, sandbox_state_t last_state)
 	}
 
 	/* State Change Bookkeeping */
+	trace_sandbox_state(sandbox, last_state, now);
 	uint64_t duration_of_last_state = now - sandbox->timestamp_of.last_state_change;
 	sandbox->duration_of_state[last_state] += duration_of_last_state;
 	sandbox_state_history_append(sandbox, SANDBOX_ERROR);
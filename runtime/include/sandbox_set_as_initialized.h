@@ -10,6 +10,7 @@
 #include "sandbox_request.h"
 #include "sandbox_state_history.h"
 #include "sandbox_types.h"
+#include "trace.h"
 
 /**
  * Transitions a sandbox to the SANDBOX_INITIALIZED state.
@@ -32,8 +33,12 @@ sandbox_set_as_initialized(struct sandbox *sandbox, struct sandbox_request *sand
 	/* Copy State from Sandbox Request */
 	sandbox->id                           = sandbox_request->id;
 	sandbox->absolute_deadline            = sandbox_request->absolute_deadline;
+	sandbox->is_demoted                   = false;
+	sandbox->has_run                      = false;
 	sandbox->admissions_estimate          = sandbox_request->admissions_estimate;
 	sandbox->client_socket_descriptor     = sandbox_request->socket_descriptor;
+	sandbox->connection_request_count     = sandbox_request->connection_request_count;
+	sandbox->keep_alive                   = false;
 	sandbox->timestamp_of.request_arrival = sandbox_request->request_arrival_timestamp;
 	/* Copy the socket descriptor and address of the client invocation */
 	memcpy(&sandbox->client_address, &sandbox_request->socket_address, sizeof(struct sockaddr));
@@ -52,6 +57,7 @@ sandbox_set_as_initialized(struct sandbox *sandbox, struct sandbox_request *sand
 	sandbox->duration_of_state[SANDBOX_ALLOCATED] = now - allocation_timestamp;
 	sandbox->timestamp_of.allocation              = allocation_timestamp;
 	sandbox->timestamp_of.last_state_change       = allocation_timestamp;
+	trace_sandbox_state(sandbox, SANDBOX_ALLOCATED, now);
 	sandbox_state_history_append(sandbox, SANDBOX_INITIALIZED);
 	runtime_sandbox_total_increment(SANDBOX_INITIALIZED);
 }
@@ -8,6 +8,7 @@
 #include "panic.h"
 #include "sandbox_state_history.h"
 #include "sandbox_types.h"
+#include "trace.h"
 
 /**
  * Transitions a sandbox to the SANDBOX_PREEMPTED state.
@@ -37,6 +38,7 @@ sandbox_set_as_preempted(struct sandbox *sandbox, sandbox_state_t last_state)
 	}
 
 	/* State Change Bookkeeping */
+	trace_sandbox_state(sandbox, last_state, now);
 	sandbox->duration_of_state[last_state] += (now - sandbox->timestamp_of.last_state_change);
 	sandbox->timestamp_of.last_state_change = now;
 	sandbox_state_history_append(sandbox, SANDBOX_PREEMPTED);
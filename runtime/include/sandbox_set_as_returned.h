@@ -10,6 +10,7 @@
 #include "sandbox_state.h"
 #include "sandbox_state_history.h"
 #include "sandbox_types.h"
+#include "trace.h"
 
 /**
  * Transitions a sandbox to the SANDBOX_RETURNED state.
@@ -32,7 +33,9 @@ sandbox_set_as_returned(struct sandbox *sandbox, sandbox_state_t last_state)
 		sandbox->timestamp_of.response = now;
 		sandbox->total_time            = now - sandbox->timestamp_of.request_arrival;
 		local_runqueue_delete(sandbox);
-		sandbox_free_linear_memory(sandbox);
+		module_update_memory_high_water_mark(sandbox->module, sandbox->memory.size);
+		/* A sandbox that may be reused keeps its linear memory until it is reset from the completion queue */
+		if (!sandbox->module->reuse_instances) sandbox_free_linear_memory(sandbox);
 		break;
 	}
 	default: {
@@ -42,6 +45,7 @@ sandbox_set_as_returned(struct sandbox *sandbox, sandbox_state_t last_state)
 	}
 
 	/* State Change Bookkeeping */
+	trace_sandbox_state(sandbox, last_state, now);
 	sandbox->duration_of_state[last_state] += (now - sandbox->timestamp_of.last_state_change);
 	sandbox->timestamp_of.last_state_change = now;
 	sandbox_state_history_append(sandbox, SANDBOX_RETURNED);
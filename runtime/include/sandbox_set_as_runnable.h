@@ -8,6 +8,8 @@
 #include "panic.h"
 #include "sandbox_state_history.h"
 #include "sandbox_types.h"
+#include "trace.h"
+#include "worker_thread.h"
 
 /**
  * Transitions a sandbox to the SANDBOX_RUNNABLE state.
@@ -34,6 +36,7 @@ sandbox_set_as_runnable(struct sandbox *sandbox, sandbox_state_t last_state)
 	}
 	case SANDBOX_ASLEEP: {
 		local_runqueue_add(sandbox);
+		worker_thread_asleep_count--;
 		break;
 	}
 	default: {
@@ -43,6 +46,7 @@ sandbox_set_as_runnable(struct sandbox *sandbox, sandbox_state_t last_state)
 	}
 
 	/* State Change Bookkeeping */
+	trace_sandbox_state(sandbox, last_state, now);
 	sandbox->duration_of_state[last_state] += (now - sandbox->timestamp_of.last_state_change);
 	sandbox->timestamp_of.last_state_change = now;
 	sandbox_state_history_append(sandbox, SANDBOX_RUNNABLE);
@@ -9,6 +9,7 @@
 #include "sandbox_functions.h"
 #include "sandbox_state_history.h"
 #include "sandbox_types.h"
+#include "trace.h"
 
 static inline void
 sandbox_set_as_running_sys(struct sandbox *sandbox, sandbox_state_t last_state)
@@ -26,6 +27,7 @@ sandbox_set_as_running_sys(struct sandbox *sandbox, sandbox_state_t last_state)
 	case SANDBOX_RUNNABLE: {
 		assert(sandbox);
 		current_sandbox_set(sandbox);
+		sandbox->has_run = true;
 		/* Does not handle context switch because the caller knows if we need to use fast or slow switched. We
 		 * can fix this by breakout out SANDBOX_RUNNABLE and SANDBOX_PREEMPTED */
 		break;
@@ -37,6 +39,7 @@ sandbox_set_as_running_sys(struct sandbox *sandbox, sandbox_state_t last_state)
 	}
 
 	/* State Change Bookkeeping */
+	trace_sandbox_state(sandbox, last_state, now);
 	sandbox->duration_of_state[last_state] += (now - sandbox->timestamp_of.last_state_change);
 	sandbox->timestamp_of.last_state_change = now;
 	sandbox_state_history_append(sandbox, SANDBOX_RUNNING_SYS);
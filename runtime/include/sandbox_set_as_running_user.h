@@ -9,6 +9,7 @@
 #include "sandbox_state_history.h"
 #include "sandbox_types.h"
 #include "sandbox_functions.h"
+#include "trace.h"
 
 static inline void
 sandbox_set_as_running_user(struct sandbox *sandbox, sandbox_state_t last_state)
@@ -36,6 +37,7 @@ sandbox_set_as_running_user(struct sandbox *sandbox, sandbox_state_t last_state)
 
 
 	/* State Change Bookkeeping */
+	trace_sandbox_state(sandbox, last_state, now);
 	sandbox->duration_of_state[last_state] += (now - sandbox->timestamp_of.last_state_change);
 	sandbox->timestamp_of.last_state_change = now;
 	sandbox_state_history_append(sandbox, SANDBOX_RUNNING_USER);
@@ -3,6 +3,7 @@
 #include <stdatomic.h>
 
 #include "debuglog.h"
+#include "generic_thread.h"
 #include "likely.h"
 #include "panic.h"
 
@@ -31,31 +32,38 @@ sandbox_state_stringify(sandbox_state_t state)
 	return sandbox_state_labels[state];
 }
 
-#ifdef LOG_SANDBOX_COUNT
-extern _Atomic uint32_t sandbox_state_count[SANDBOX_STATE_COUNT];
-#endif
+/*
+ * Number of sandboxes in each state, sharded by thread. A sandbox can enter a state on one worker and leave it on
+ * another, so a shard alone may underflow and wrap, but the sum across shards is exact
+ */
+struct sandbox_state_totals {
+	_Atomic uint64_t count[SANDBOX_STATE_COUNT];
+} CACHE_ALIGNED;
 
-static inline void
-sandbox_count_initialize()
-{
-#ifdef LOG_SANDBOX_COUNT
-	for (int i = 0; i < SANDBOX_STATE_COUNT; i++) atomic_init(&sandbox_state_count[i], 0);
-#endif
-}
+extern struct sandbox_state_totals sandbox_state_totals[GENERIC_THREAD_MAX_COUNT];
 
 static inline void
 runtime_sandbox_total_increment(sandbox_state_t state)
 {
-#ifdef LOG_SANDBOX_COUNT
-	atomic_fetch_add(&sandbox_state_count[state], 1);
-#endif
+	generic_thread_counter_add(&sandbox_state_totals[generic_thread_idx].count[state], 1);
 }
 
 static inline void
 runtime_sandbox_total_decrement(sandbox_state_t state)
 {
-#ifdef LOG_SANDBOX_COUNT
-	if (atomic_load(&sandbox_state_count[state]) == 0) panic("Underflow of %s\n", sandbox_state_stringify(state));
-	atomic_fetch_sub(&sandbox_state_count[state], 1);
-#endif
+	generic_thread_counter_add(&sandbox_state_totals[generic_thread_idx].count[state], UINT64_MAX);
+}
+
+/**
+ * @param state
+ * @returns the number of sandboxes in the state across all threads
+ */
+static inline uint64_t
+runtime_sandbox_total(sandbox_state_t state)
+{
+	uint64_t total = 0;
+	for (int i = 0; i < GENERIC_THREAD_MAX_COUNT; i++) {
+		total += atomic_load_explicit(&sandbox_state_totals[i].count[state], memory_order_relaxed);
+	}
+	return total;
 }
@@ -20,7 +20,8 @@ sandbox_summarize_page_allocations(struct sandbox *sandbox)
 
 	FILE *sandbox_page_allocations_log = fopen(sandbox_page_allocations_log_path, "a");
 
-	fprintf(sandbox_page_allocations_log, "%lu,%lu,%s,", sandbox->id, sandbox->duration_of_state.running,
+	fprintf(sandbox_page_allocations_log, "%lu,%lu,%s,", sandbox->id,
+	        sandbox->duration_of_state[SANDBOX_RUNNING_USER] + sandbox->duration_of_state[SANDBOX_RUNNING_SYS],
 	        sandbox_state_stringify(sandbox->state));
 	for (size_t i = 0; i < sandbox->timestamp_of.page_allocations_size; i++)
 		fprintf(sandbox_page_allocations_log, "%u,", sandbox->timestamp_of.page_allocations[i]);
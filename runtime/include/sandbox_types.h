@@ -71,6 +71,22 @@ struct sandbox_buffer {
 	size_t length;
 };
 
+/*
+ * If the module streams request bodies, the request buffer only has to hold the headers. The body received with the
+ * headers follows them. Once wasm_read consumes it, the request buffer from the start of the body holds the body bytes
+ * received later, which wasm_read consumes before refilling it from the socket
+ *
+ * ---------------------------------------------------
+ * | Sandbox | Headers | Body, then Stream | Response |
+ * ---------------------------------------------------
+ */
+struct sandbox_request_stream {
+	char * base;     /* NULL unless the body is still being received */
+	size_t capacity; /* bytes of the request buffer following base */
+	size_t read;     /* offset of the next byte wasm_read consumes */
+	size_t length;   /* body bytes received but not yet consumed */
+};
+
 struct sandbox {
 	uint64_t        id;
 	sandbox_state_t state;
@@ -90,6 +106,14 @@ struct sandbox {
 	ssize_t               http_request_length; /* TODO: Get rid of me */
 	struct sandbox_buffer request;
 	struct sandbox_buffer response;
+	uint32_t              connection_request_count; /* requests previously served on the connection */
+	bool                  keep_alive;               /* park the connection rather than close it after responding */
+	int32_t               io_result;                /* result of the last completed io_uring operation */
+	uint32_t              io_pending;               /* io_uring operations submitted but not yet completed */
+	uint32_t              pipeline_stage;           /* 0 unless the request body was handed off by a prior stage */
+
+	/* Body bytes received on demand if the module streams request bodies */
+	struct sandbox_request_stream request_stream;
 
 	/* WebAssembly Module State */
 	struct module *module; /* the module this is an instance of */
@@ -98,12 +122,15 @@ struct sandbox {
 	struct arch_context  ctxt;
 	struct sandbox_stack stack;
 	struct wasm_memory   memory;
+	bool                 memory_is_snapshot; /* linear memory is a private mapping of the module snapshot */
 
 	/* Scheduling and Temporal State */
 	struct sandbox_timestamps timestamp_of;
 	uint64_t                  duration_of_state[SANDBOX_STATE_COUNT];
 
-	uint64_t absolute_deadline;
+	uint64_t absolute_deadline;   /* Offset by EXECUTION_BUDGET_BACKGROUND_OFFSET once demoted */
+	bool     is_demoted;          /* Overran its execution budget and was demoted to the background class */
+	bool     has_run;             /* Switched to at least once, so its context may hold worker thread-local state */
 	uint64_t admissions_estimate; /* estimated execution time (cycles) * runtime_admissions_granularity / relative
 	                                 deadline (cycles) */
 	uint64_t total_time;          /* Total time from Request to Response */
@@ -4,25 +4,37 @@
 #include <errno.h>
 #include <stdint.h>
 
+#include "admissions_codel.h"
 #include "client_socket.h"
 #include "cache_protection.h"
+#include "connection_table.h"
 #include "current_sandbox.h"
+#include "execution_budget.h"
+#include "gang_epoch.h"
 #include "gang_scheduler.h"
 #include "global_request_scheduler.h"
 #include "global_request_scheduler_deque.h"
+#include "global_request_scheduler_domain.h"
 #include "global_request_scheduler_minheap.h"
+#include "global_request_scheduler_multiqueue.h"
+#include "io_engine.h"
 #include "local_runqueue.h"
 #include "local_runqueue_minheap.h"
 #include "local_runqueue_list.h"
 #include "panic.h"
 #include "sandbox_request.h"
 #include "sandbox_functions.h"
+#include "sandbox_perf_log.h"
 #include "sandbox_types.h"
+#include "sandbox_set_as_error.h"
 #include "sandbox_set_as_preempted.h"
 #include "sandbox_set_as_runnable.h"
 #include "sandbox_set_as_running_sys.h"
 #include "sandbox_set_as_running_user.h"
-#include "scheduler_execute_epoll_loop.h"
+#include "software_interrupt.h"
+#include "trace.h"
+#include "work_stealing.h"
+#include "worker_listener.h"
 
 #define LOG_CONTEXT_SWITCHES
 
@@ -35,6 +47,42 @@ enum SCHEDULER
 
 extern enum SCHEDULER scheduler;
 
+void scheduler_early_rejection_print(void);
+
+/**
+ * Fails a request that has left the global request scheduler before a sandbox is allocated for it, if the request
+ * can no longer meet its deadline given its module's estimated execution time, or if its module is shedding load
+ * @param request
+ * @returns true if the request was failed and freed
+ */
+static inline bool
+scheduler_shed_request(struct sandbox_request *request)
+{
+	struct module *module = request->module;
+	int            status_code;
+	const char *   reason;
+
+	if (runtime_early_rejection_enabled
+	    && __getcycles() + module->admissions_info.estimated_execution > request->absolute_deadline) {
+		atomic_fetch_add(&module->early_rejection_count, 1);
+		status_code = runtime_early_rejection_status_code;
+		reason      = "Rejected";
+	} else if (runtime_admissions_codel_enabled
+	           && admissions_codel_should_shed(&module->admissions_codel, request->request_arrival_timestamp)) {
+		status_code = 503;
+		reason      = "Shed";
+	} else {
+		return false;
+	}
+
+	sandbox_perf_log_print_request_entry(request, reason);
+	client_socket_send(request->socket_descriptor, status_code);
+	client_socket_close(request->socket_descriptor, &request->socket_address);
+	admissions_control_subtract(request->admissions_estimate);
+	free(request);
+	return true;
+}
+
 static inline struct sandbox *
 scheduler_edf_get_next(bool preemptive)
 {
@@ -51,6 +99,8 @@ scheduler_edf_get_next(bool preemptive)
 		if (global_request_scheduler_remove_if_earlier(&request, local_deadline) == 0) {
 			assert(request != NULL);
 			assert(request->absolute_deadline < local_deadline);
+			if (scheduler_shed_request(request)) goto done;
+
 			struct sandbox *global = sandbox_allocate(request);
 			if (!global) goto err_allocate;
 
@@ -80,6 +130,7 @@ scheduler_fifo_get_next(bool preemptive)
 	if (sandbox == NULL) {
 		/* If the local runqueue is empty, pull from global request scheduler */
 		if (global_request_scheduler_remove(&sandbox_request) < 0) goto err;
+		if (scheduler_shed_request(sandbox_request)) goto err;
 
 		sandbox = sandbox_allocate(sandbox_request);
 		if (!sandbox) goto err_allocate;
@@ -115,7 +166,9 @@ scheduler_gang_get_next(bool preemptive)
     // get the next sandbox... should be from this domain
 
     // swap to the next domain for gang scheduling...
-    if (preemptive) {
+    if (runtime_gang_epoch_enabled) {
+        local_runqueue_gang_set_domain(gang_epoch_domain());
+    } else if (preemptive) {
 #ifdef LOG_DOMAIN_SWITCH
         uint32_t current_domain = local_runqueue_gang_current_domain();
 #endif
@@ -130,20 +183,38 @@ scheduler_gang_get_next(bool preemptive)
 	struct sandbox_request *sandbox_request = NULL;
 
 	if (sandbox == NULL) {
-		/* If the local runqueue is empty, pull from global request scheduler */
-        // TODO: change global_request_scheduler to respect domains...
-		if (global_request_scheduler_remove(&sandbox_request) < 0) goto err;
+		/* If the current domain is empty, pull a request of that domain from the global request scheduler, or a
+		 * request of any domain if the worker has nothing else to run */
+		uint32_t domain = local_runqueue_gang_current_domain();
+		if (global_request_scheduler_domain_remove_from(domain, &sandbox_request) == 0) {
+			global_request_scheduler_record_removal(sandbox_request);
+			global_request_scheduler_domain_stats[worker_thread_idx].same_domain_pulls++;
+		} else if (atomic_load_explicit(&local_runqueue_lengths[worker_thread_idx].value, memory_order_relaxed) == 0
+		           && global_request_scheduler_remove(&sandbox_request) == 0) {
+			global_request_scheduler_domain_stats[worker_thread_idx].cross_domain_pulls++;
+		} else {
+			goto err;
+		}
+		if (scheduler_shed_request(sandbox_request)) goto err;
 
 		sandbox = sandbox_allocate(sandbox_request);
 		if (!sandbox) goto err_allocate;
 
 		sandbox_set_as_runnable(sandbox, SANDBOX_INITIALIZED);
+
+		/* Park the request on its domain's runqueue until the epoch of its domain */
+		if (runtime_gang_epoch_enabled && sandbox->module->domain_slot != local_runqueue_gang_current_domain()) {
+			gang_epoch_stats[worker_thread_idx].parked++;
+			sandbox = NULL;
+		}
 	} else if (sandbox == current_sandbox_get()) {
 		/* Execute Round Robin Scheduling Logic if the head is the current sandbox */
 		local_runqueue_gang_rotate();
 		sandbox = local_runqueue_get_next(preemptive);
 	}
 
+	if (runtime_gang_epoch_enabled && sandbox != NULL) gang_epoch_mark_busy();
+
 
 done:
 	return sandbox;
@@ -157,6 +228,35 @@ err:
 
 }
 
+/**
+ * Under domain affinity, runs a sandbox of the domain that last ran on this worker ahead of the sandbox the policy
+ * chose, avoiding a flush, if the chosen sandbox has the slack to wait one more quantum and still meet its deadline
+ * given its expected execution. The decision is revisited every quantum, so slack is never lent past the deadline.
+ * @param next the sandbox chosen by the scheduling policy
+ * @returns the sandbox to run
+ */
+static inline struct sandbox *
+scheduler_domain_affinity_choose(struct sandbox *next)
+{
+	if (!runtime_domain_affinity_enabled || next == NULL) return next;
+
+	struct cache_protection_last last = cache_protection_last;
+	if (!last.is_valid || last.domain == -1 || next->module->domain == last.domain) return next;
+
+	struct sandbox *candidate = local_runqueue_get_next_in_domain(last.domain);
+	if (candidate == NULL) return next;
+
+	uint64_t executed  = next->duration_of_state[SANDBOX_RUNNING_USER] + next->duration_of_state[SANDBOX_RUNNING_SYS];
+	uint64_t estimate  = next->module->admissions_info.estimated_execution;
+	uint64_t remaining = estimate > executed ? estimate - executed : 0;
+	uint64_t quantum   = (uint64_t)runtime_quantum_us * runtime_processor_speed_MHz;
+	if (next->absolute_deadline < __getcycles() + remaining + quantum) return next;
+
+	cache_protection_stats[worker_thread_idx].affinity_picks++;
+	cache_protection_stats[worker_thread_idx].slack_used += quantum;
+	return candidate;
+}
+
 static inline struct sandbox *
 scheduler_get_next(bool preemptive)
 {
@@ -170,9 +270,9 @@ scheduler_get_next(bool preemptive)
 	atomic_store(&software_interrupt_deferred_sigalrm, 0);
 	switch (scheduler) {
 	case SCHEDULER_EDF:
-		return scheduler_edf_get_next(preemptive);
+		return scheduler_domain_affinity_choose(scheduler_edf_get_next(preemptive));
 	case SCHEDULER_FIFO:
-		return scheduler_fifo_get_next(preemptive);
+		return scheduler_domain_affinity_choose(scheduler_fifo_get_next(preemptive));
     case SCHEDULER_GANG:
         return scheduler_gang_get_next(preemptive);
 	default:
@@ -185,14 +285,17 @@ scheduler_initialize()
 {
 	switch (scheduler) {
 	case SCHEDULER_EDF:
-		global_request_scheduler_minheap_initialize();
+		if (global_queue == GLOBAL_QUEUE_MULTIQUEUE) {
+			global_request_scheduler_multiqueue_initialize();
+		} else {
+			global_request_scheduler_minheap_initialize();
+		}
 		break;
 	case SCHEDULER_FIFO:
 		global_request_scheduler_deque_initialize();
 		break;
     case SCHEDULER_GANG:
-        // TODO: What is the global policy for gang...?
-        global_request_scheduler_deque_initialize();
+        global_request_scheduler_domain_initialize();
         break;
 	default:
 		panic("Invalid scheduler policy: %u\n", scheduler);
@@ -267,6 +370,26 @@ scheduler_log_sandbox_switch(struct sandbox *current_sandbox, struct sandbox *ne
 #endif
 }
 
+/**
+ * Arms or disarms the one-shot timer of a tickless worker before it runs next
+ * Under EDF, a running sandbox is only preempted by an earlier deadline. Arrivals to the global request scheduler
+ * are signaled by the listener, so a tick is only needed to notice sandboxes waking from I/O and to service the
+ * features that poll from the scheduler
+ * @param next the sandbox about to run or NULL if the worker is going idle
+ */
+static inline void
+scheduler_tickless_rearm(struct sandbox *next)
+{
+	if (runtime_sigalrm_timer != RUNTIME_SIGALRM_TIMER_TICKLESS) return;
+
+	bool should_arm = next != NULL
+	                  && (worker_thread_asleep_count > 0 || runtime_worker_accept_enabled
+	                      || runtime_keepalive_enabled || runtime_work_stealing_enabled
+	                      || runtime_domain_affinity_enabled
+	                      || execution_budget_is_enabled(&next->module->execution_budget));
+	software_interrupt_tickless_arm(should_arm);
+}
+
 static inline void
 scheduler_preemptive_switch_to(ucontext_t *interrupted_context, struct sandbox *next)
 {
@@ -291,6 +414,60 @@ scheduler_preemptive_switch_to(ucontext_t *interrupted_context, struct sandbox *
 	}
 }
 
+/**
+ * Enforces the execution budget of the module of an interrupted sandbox
+ * An aborted sandbox is answered with a 504 and placed on the completion queue, which only releases its stack once the
+ * worker has switched away from it and returned to its base context
+ * @param sandbox the current sandbox, just interrupted
+ * @returns true if the sandbox was aborted, so the caller must not resume it
+ */
+static inline bool
+scheduler_enforce_budget(struct sandbox *sandbox)
+{
+	assert(sandbox->state == SANDBOX_RUNNING_SYS);
+
+	struct execution_budget *budget = &sandbox->module->execution_budget;
+	if (!execution_budget_is_enabled(budget) || sandbox->is_demoted) return false;
+
+	uint64_t now       = __getcycles();
+	uint64_t execution = sandbox->duration_of_state[SANDBOX_RUNNING_USER]
+	                     + sandbox->duration_of_state[SANDBOX_RUNNING_SYS]
+	                     + (now - sandbox->timestamp_of.last_state_change);
+	if (!execution_budget_is_exceeded(budget, execution, now - sandbox->timestamp_of.request_arrival)) return false;
+
+	switch (budget->policy) {
+	case EXECUTION_BUDGET_POLICY_DEMOTE: {
+		/* Reinsert, as the runqueue is ordered by deadline */
+		local_runqueue_delete(sandbox);
+		sandbox->absolute_deadline += EXECUTION_BUDGET_BACKGROUND_OFFSET;
+		sandbox->is_demoted = true;
+		local_runqueue_add(sandbox);
+		runtime_worker_threads_deadline[worker_thread_idx] = sandbox->absolute_deadline;
+		execution_budget_stats[worker_thread_idx].demotions++;
+		return false;
+	}
+	case EXECUTION_BUDGET_POLICY_KILL: {
+#ifdef LOG_PREEMPTION
+		debuglog("Aborting sandbox %lu after %lu cycles of execution\n", sandbox->id, execution);
+#endif
+		client_socket_send(sandbox->client_socket_descriptor, 504);
+		sandbox->keep_alive = false;
+		sandbox_close_http(sandbox);
+		admissions_control_record_completion(true);
+		execution_budget_stats[worker_thread_idx].aborts++;
+
+		scheduler_log_sandbox_switch(sandbox, NULL);
+		cache_protection_flush(sandbox);
+		current_sandbox_set(NULL);
+		sandbox_set_as_error(sandbox, SANDBOX_RUNNING_SYS);
+		return true;
+	}
+	default: {
+		panic("Unexpected execution budget policy %d\n", budget->policy);
+	}
+	}
+}
+
 /**
  * Called by the SIGALRM handler after a quantum
  * Assumes the caller validates that there is something to preempt
@@ -302,8 +479,11 @@ scheduler_preemptive_sched(ucontext_t *interrupted_context)
 {
 	assert(interrupted_context != NULL);
 
-	/* Process epoll to make sure that all runnable jobs are considered for execution */
-	scheduler_execute_epoll_loop();
+	/* Process completed I/O to make sure that all runnable jobs are considered for execution */
+	io_engine_poll();
+	if (runtime_worker_accept_enabled) worker_listener_accept();
+	if (runtime_keepalive_enabled) connection_table_poll();
+	if (runtime_work_stealing_enabled) work_stealing_poll();
 
 	struct sandbox *current = current_sandbox_get();
 	assert(current != NULL);
@@ -311,12 +491,40 @@ scheduler_preemptive_sched(ucontext_t *interrupted_context)
 
 	sandbox_interrupt(current);
 
+	if (unlikely(scheduler_enforce_budget(current))) {
+		/* The aborted sandbox is off the runqueue, so its context is discarded rather than saved */
+		struct sandbox *next = scheduler_get_next(true);
+		if (next == NULL) {
+			scheduler_tickless_rearm(NULL);
+			arch_context_restore_base(&interrupted_context->uc_mcontext);
+			return;
+		}
+
+		scheduler_tickless_rearm(next);
+		scheduler_preemptive_switch_to(interrupted_context, next);
+		return;
+	}
+
 	struct sandbox *next = scheduler_get_next(true);
-	/* Assumption: the current sandbox is on the runqueue, so the scheduler should always return something */
-	assert(next != NULL);
+	trace_preemption(current, next);
+
+	/* The gang scheduler idles a worker whose domain has no work, so preempt to the base context */
+	if (next == NULL) {
+		assert(scheduler == SCHEDULER_GANG);
+		scheduler_log_sandbox_switch(current, NULL);
+		cache_protection_flush(current);
+		sandbox_preempt(current);
+		arch_context_save_slow(&current->ctxt, &interrupted_context->uc_mcontext);
+		arch_context_restore_base(&interrupted_context->uc_mcontext);
+		return;
+	}
+
+	/* Assumption: outside of the gang scheduler, the current sandbox is on the runqueue, so the scheduler should
+	 * always return something */
 
 	/* If current equals next, no switch is necessary, so resume execution */
 	if (current == next) {
+		scheduler_tickless_rearm(current);
 		sandbox_return(current);
 		return;
 	}
@@ -327,10 +535,12 @@ scheduler_preemptive_sched(ucontext_t *interrupted_context)
 
 	scheduler_log_sandbox_switch(current, next);
 
-    if (!runtime_domains || current->module->domain == -1 
+    if (runtime_domain_affinity_enabled) {
+        cache_protection_switch_to(current, next);
+    } else if (!runtime_domains || current->module->domain == -1 
             || current->module->domain != next->module->domain) {
         // clear the cache via policy
-        cache_protection_flush();
+        cache_protection_flush(current);
     }
 
 
@@ -338,6 +548,7 @@ scheduler_preemptive_sched(ucontext_t *interrupted_context)
 	sandbox_preempt(current);
 	arch_context_save_slow(&current->ctxt, &interrupted_context->uc_mcontext);
 
+	scheduler_tickless_rearm(next);
 	scheduler_preemptive_switch_to(interrupted_context, next);
 }
 
@@ -387,15 +598,29 @@ scheduler_cooperative_sched()
 	assert(current_sandbox_get() == NULL);
 
 	/* Try to wakeup sleeping sandboxes */
-	scheduler_execute_epoll_loop();
+	io_engine_poll();
+	if (runtime_worker_accept_enabled) worker_listener_accept();
+	if (runtime_keepalive_enabled) connection_table_poll();
+	if (runtime_work_stealing_enabled) work_stealing_poll();
 
 	/* Switch to a sandbox if one is ready to run */
 	struct sandbox *next_sandbox = scheduler_get_next(false);
 
     // clear the cache via policy (TODO: always do on coop for now)
-    cache_protection_flush();
+    // an idle pass defers the flush to the pass that finds the next sandbox
+    if (runtime_domain_affinity_enabled) {
+        cache_protection_switch_to(NULL, next_sandbox);
+    } else if (next_sandbox != NULL) {
+        cache_protection_flush(NULL);
+    }
+
+	scheduler_tickless_rearm(next_sandbox);
 
-	if (next_sandbox != NULL) scheduler_cooperative_switch_to(next_sandbox);
+	if (next_sandbox != NULL) {
+		scheduler_cooperative_switch_to(next_sandbox);
+	} else if (runtime_work_stealing_enabled) {
+		work_stealing_request();
+	}
 
 	/* Clear the completion queue */
 	local_completion_queue_free();
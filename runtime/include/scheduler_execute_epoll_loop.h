@@ -64,6 +64,7 @@ scheduler_execute_epoll_loop(void)
 					panic("Expected to have closed socket");
 				default:
 					client_socket_send(sandbox->client_socket_descriptor, 503);
+					sandbox->keep_alive = false;
 					sandbox_close_http(sandbox);
 					sandbox_set_as_error(sandbox, sandbox->state);
 				}
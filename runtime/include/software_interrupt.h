@@ -9,17 +9,30 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <threads.h>
+#include <time.h>
 
 #include "debuglog.h"
 #include "runtime.h"
 #include "worker_thread.h"
 
+/* Older glibc does not expose the thread id member of struct sigevent */
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
 /************
  * Externs  *
  ***********/
 
+/* Totals since startup. Only the signal handler of the worker writes its entry */
+struct software_interrupt_stats {
+	_Atomic uint64_t deferred_sigalrms;
+} CACHE_ALIGNED;
+
+extern struct software_interrupt_stats software_interrupt_stats[RUNTIME_MAX_WORKER_COUNT];
 extern _Atomic thread_local volatile sig_atomic_t software_interrupt_deferred_sigalrm;
 extern _Atomic volatile sig_atomic_t *            software_interrupt_deferred_sigalrm_max;
+extern struct timespec                            software_interrupt_timer_epoch;
 
 /*************************
  * Public Static Inlines *
@@ -81,6 +94,10 @@ software_interrupt_unmask_signal(int signal)
 void software_interrupt_initialize(void);
 void software_interrupt_arm_timer(void);
 void software_interrupt_disarm_timer(void);
+void software_interrupt_arm_thread_timer(void);
+void software_interrupt_disarm_thread_timers(void);
+void software_interrupt_tickless_arm(bool should_arm);
+void software_interrupt_tickless_notify(uint64_t absolute_deadline);
 void software_interrupt_set_interval_duration(uint64_t cycles);
 void software_interrupt_deferred_sigalrm_max_free(void);
 void software_interrupt_deferred_sigalrm_max_print(void);
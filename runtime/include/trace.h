@@ -0,0 +1,163 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arch/getcycles.h"
+#include "generic_thread.h"
+#include "runtime.h"
+#include "sandbox_request.h"
+#include "sandbox_types.h"
+#include "worker_thread.h"
+
+/*
+ * Per-request span tracing, written as Chrome trace-event JSON to the file named by SLEDGE_TRACE
+ *
+ * Workers record timestamped events about sampled requests into their own single-producer single-consumer ring: the
+ * time a sandbox spent in each state, the time its request waited in the global request scheduler, the decisions of
+ * the preemptive scheduler, and cache flushes. A writer thread on the listener core formats the events, so workers
+ * never format text or block on I/O. If a worker's ring is full, the event is dropped and counted.
+ *
+ * The output uses the JSON array format, which Perfetto and chrome://tracing load even if the closing bracket is
+ * missing because the runtime was killed. Each sampled request gets its own track under the "Requests" process, and
+ * each worker gets a track under the "Workers" process showing what it ran, its scheduling decisions, and its
+ * flushes. The trace-sample-percent key of the module JSON sets the percentage of requests of a module to trace.
+ *
+ * Events are only recorded by workers, outside of signal handlers or from the SIGALRM handler while a sandbox runs
+ * user code. The handler defers otherwise, so a worker never reenters its ring.
+ */
+
+#define TRACE_RING_CAPACITY      8192 /* Events per worker. Must be a power of 2 */
+#define TRACE_WRITER_INTERVAL_US 10000
+#define TRACE_BUFFER_SIZE        (1 << 20)
+
+/* The id of the next sandbox of a preemption event when the worker switches to its base context */
+#define TRACE_SANDBOX_ID_NONE UINT64_MAX
+
+enum trace_event_type
+{
+	TRACE_EVENT_STATE       = 0, /* A sandbox left a state */
+	TRACE_EVENT_DEQUEUE     = 1, /* A request was removed from the global request scheduler */
+	TRACE_EVENT_PREEMPTION  = 2, /* The preemptive scheduler chose the next sandbox */
+	TRACE_EVENT_CACHE_FLUSH = 3  /* The cache was flushed after a sandbox ran */
+};
+
+struct trace_event {
+	uint64_t       timestamp;  /* cycles */
+	uint64_t       duration;   /* cycles. 0 for instant events */
+	uint64_t       sandbox_id; /* The sandbox the event is about */
+	uint64_t       argument;   /* The state left by a state event, or the id of the next sandbox of a preemption */
+	struct module *module;     /* Modules are never freed, so the writer can read the name */
+	uint32_t       type;       /* enum trace_event_type */
+};
+
+/* The worker and the writer thread each write their own index, so the indices are on separate cache lines */
+struct trace_ring {
+	_Atomic uint64_t tail;    /* Next slot written by the worker */
+	_Atomic uint64_t dropped; /* Events discarded because the ring was full */
+	CACHE_ALIGNED _Atomic uint64_t head; /* Next slot read by the writer thread */
+	struct trace_event events[TRACE_RING_CAPACITY];
+} CACHE_ALIGNED;
+
+extern FILE *             trace_file;
+extern struct trace_ring *trace_rings;
+
+void trace_init(void);
+void trace_writer_initialize(void);
+void trace_cleanup(void);
+
+/**
+ * Requests are sampled by id, which the listener assigns sequentially, so a module's sampled requests are spread
+ * evenly over time
+ * @param module
+ * @param id of the request or sandbox
+ * @returns true if tracing is enabled and the request is sampled
+ */
+static inline bool
+trace_is_sampled(struct module *module, uint64_t id)
+{
+	return trace_rings != NULL && id % 100 < module->trace_sample_percent;
+}
+
+static inline void
+trace_record(enum trace_event_type type, struct module *module, uint64_t sandbox_id, uint64_t timestamp,
+             uint64_t duration, uint64_t argument)
+{
+	struct trace_ring *ring = &trace_rings[worker_thread_idx];
+	uint64_t           tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	if (unlikely(tail - atomic_load_explicit(&ring->head, memory_order_acquire) == TRACE_RING_CAPACITY)) {
+		generic_thread_counter_add(&ring->dropped, 1);
+		return;
+	}
+
+	struct trace_event *event = &ring->events[tail & (TRACE_RING_CAPACITY - 1)];
+	event->timestamp          = timestamp;
+	event->duration           = duration;
+	event->sandbox_id         = sandbox_id;
+	event->argument           = argument;
+	event->module             = module;
+	event->type               = type;
+
+	atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+/**
+ * Records the time a sandbox spent in the state it is leaving
+ * Called by the sandbox_set_as_* transitions before they update the state change bookkeeping
+ * @param sandbox
+ * @param last_state the state the sandbox is leaving
+ * @param now cycles at the transition
+ */
+static inline void
+trace_sandbox_state(struct sandbox *sandbox, sandbox_state_t last_state, uint64_t now)
+{
+	if (likely(!trace_is_sampled(sandbox->module, sandbox->id))) return;
+
+	uint64_t start = sandbox->timestamp_of.last_state_change;
+	trace_record(TRACE_EVENT_STATE, sandbox->module, sandbox->id, start, now - start, last_state);
+}
+
+/**
+ * Records the time a request waited before it was removed from the global request scheduler
+ * @param sandbox_request
+ */
+static inline void
+trace_dequeue(struct sandbox_request *sandbox_request)
+{
+	if (likely(!trace_is_sampled(sandbox_request->module, sandbox_request->id))) return;
+
+	uint64_t start = sandbox_request->request_arrival_timestamp;
+	trace_record(TRACE_EVENT_DEQUEUE, sandbox_request->module, sandbox_request->id, start, __getcycles() - start,
+	             0);
+}
+
+/**
+ * Records a decision of the preemptive scheduler
+ * @param current the preempted sandbox
+ * @param next the sandbox chosen to run next, which may be current, or NULL if the worker goes idle
+ */
+static inline void
+trace_preemption(struct sandbox *current, struct sandbox *next)
+{
+	if (likely(!trace_is_sampled(current->module, current->id))) return;
+
+	trace_record(TRACE_EVENT_PREEMPTION, current->module, current->id, __getcycles(), 0,
+	             next == NULL ? TRACE_SANDBOX_ID_NONE : next->id);
+}
+
+/**
+ * Records a cache flush performed after a sandbox ran
+ * @param outgoing the sandbox that ran before the flush, or NULL if unknown
+ * @param start cycles when the flush started
+ * @param end cycles when the flush ended
+ */
+static inline void
+trace_cache_flush(struct sandbox *outgoing, uint64_t start, uint64_t end)
+{
+	if (likely(outgoing == NULL || !trace_is_sampled(outgoing->module, outgoing->id))) return;
+
+	trace_record(TRACE_EVENT_CACHE_FLUSH, outgoing->module, outgoing->id, start, end - start, 0);
+}
@@ -13,6 +13,9 @@
 #define round_to_page(x)    round_to_pow2(x, PAGE_SIZE)
 #define round_up_to_page(x) round_up_to_pow2(x, PAGE_SIZE)
 
+#define CACHE_LINE_SIZE 64
+#define CACHE_ALIGNED   __attribute__((aligned(CACHE_LINE_SIZE)))
+
 #define EXPORT       __attribute__((visibility("default")))
 #define IMPORT       __attribute__((visibility("default")))
 #define INLINE       __attribute__((always_inline))
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Minimal io_uring ring built directly on the io_uring_setup and io_uring_enter system calls
+ * Submission queue entries are only visible to the kernel after uring_submit publishes the tail, so a caller may
+ * prepare several entries (e.g. a linked chain) before a single system call
+ */
+
+struct uring {
+	int file_descriptor;
+
+	/* Submission Queue */
+	unsigned *           sq_head;
+	unsigned *           sq_tail;
+	unsigned *           sq_mask;
+	unsigned *           sq_flags;
+	unsigned *           sq_array;
+	unsigned             sq_entries;
+	unsigned             sq_local_tail; /* Prepared but unpublished entries lie between *sq_tail and this */
+	struct io_uring_sqe *sqes;
+
+	/* Completion Queue */
+	unsigned *           cq_head;
+	unsigned *           cq_tail;
+	unsigned *           cq_mask;
+	struct io_uring_cqe *cqes;
+
+	/* Mappings */
+	void * sq_ring;
+	size_t sq_ring_size;
+	void * cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+};
+
+int                  uring_initialize(struct uring *ring, unsigned entries, unsigned flags);
+void                 uring_deinitialize(struct uring *ring);
+struct io_uring_sqe *uring_get_sqe(struct uring *ring);
+int                  uring_submit(struct uring *ring, unsigned wait_count);
+int                  uring_wait(struct uring *ring, unsigned wait_count);
+
+/**
+ * @returns the number of free submission queue entries
+ */
+static inline unsigned
+uring_sq_space_left(struct uring *ring)
+{
+	return ring->sq_entries - (ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * @returns true if entries were prepared but not yet consumed by the kernel
+ */
+static inline bool
+uring_has_unsubmitted(struct uring *ring)
+{
+	return ring->sq_local_tail != __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @returns true if the kernel flagged pending task work that requires entering the kernel to post completions
+ */
+static inline bool
+uring_needs_enter(struct uring *ring)
+{
+	return uring_has_unsubmitted(ring)
+	       || (__atomic_load_n(ring->sq_flags, __ATOMIC_RELAXED) & (IORING_SQ_TASKRUN | IORING_SQ_CQ_OVERFLOW));
+}
+
+/**
+ * Returns the completion queue entry at the head without consuming it. Does not make a system call
+ * @returns cqe or NULL if the completion queue is empty
+ */
+static inline struct io_uring_cqe *
+uring_peek_cqe(struct uring *ring)
+{
+	unsigned head = *ring->cq_head;
+	if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+	return &ring->cqes[head & *ring->cq_mask];
+}
+
+/**
+ * Consumes the completion queue entry at the head
+ */
+static inline void
+uring_cqe_seen(struct uring *ring)
+{
+	__atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
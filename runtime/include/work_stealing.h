@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "runtime.h"
+#include "sandbox_types.h"
+#include "types.h"
+
+/*
+ * Work stealing between worker runqueues, used when SLEDGE_WORK_STEALING is set
+ *
+ * Runqueues stay private to their worker, which also mutates them from the SIGALRM handler. An idle worker instead
+ * posts a steal request to the worker with the longest runqueue. At its next scheduling decision the victim removes
+ * the sandbox it would run last (the latest deadline for EDF, the tail for FIFO) and hands it to the thief, which adds
+ * it to its own runqueue.
+ *
+ * Only sandboxes that have never run are stolen. Compiled WebAssembly keeps addresses and values of the worker's
+ * local_sandbox_context_cache in registers across preemption points, so a sandbox that has run cannot resume on
+ * another worker. A sandbox that has never run has also not yet attached its client socket to an I/O engine.
+ */
+
+struct work_stealing_worker {
+	_Atomic int               thief;    /* Index of the worker requesting a sandbox from this worker, or -1 */
+	_Atomic(struct sandbox *) transfer; /* Response to this worker's outstanding request, or NULL if pending */
+	uint64_t                  stolen;   /* Sandboxes received */
+	uint64_t                  donated;  /* Sandboxes given to thieves */
+} CACHE_ALIGNED;
+
+extern struct work_stealing_worker work_stealing_workers[RUNTIME_MAX_WORKER_COUNT];
+
+void work_stealing_initialize(void);
+void work_stealing_request(void);
+void work_stealing_poll(void);
+void work_stealing_stats_print(void);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include "module.h"
+#include "runtime.h"
+
+/*
+ * Per-worker accept path, used in place of the listener thread when SLEDGE_WORKER_ACCEPT is set
+ *
+ * Each worker owns a SO_REUSEPORT socket per module, registered on a per-worker accept epoll instance. A classic BPF
+ * program attached to each reuseport group steers a connection to the socket of the worker pinned to the core that
+ * processed the packet, so the accepting core is also the executing core. Workers accept from their scheduler loop
+ * and place sandboxes directly on their local runqueue, bypassing the global request scheduler.
+ */
+
+extern int worker_listener_epoll_file_descriptors[RUNTIME_MAX_WORKER_COUNT];
+
+void worker_listener_initialize(void);
+int  worker_listener_register_module(struct module *module, int (*create_socket)(struct module *module));
+void worker_listener_accept(void);
+void worker_listener_dispatch(struct module *module, int client_socket, struct sockaddr *client_address,
+                              uint64_t request_arrival_timestamp, uint32_t connection_request_count);
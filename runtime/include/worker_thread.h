@@ -9,6 +9,7 @@ extern thread_local struct arch_context worker_thread_base_context;
 extern thread_local int                 worker_thread_epoll_file_descriptor;
 extern thread_local int                 worker_thread_idx;
 extern thread_local bool                worker_waiting_for_alrm;
+extern thread_local uint32_t            worker_thread_asleep_count;
 
 void *worker_thread_main(void *return_code);
 
@@ -0,0 +1,73 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include "admissions_codel.h"
+#include "arch/getcycles.h"
+#include "debuglog.h"
+#include "worker_thread.h"
+
+struct admissions_codel_stats admissions_codel_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+/**
+ * @param self
+ * @param relative_deadline of the module in cycles
+ */
+void
+admissions_codel_initialize(struct admissions_codel *self, uint64_t relative_deadline)
+{
+	assert(self != NULL);
+
+	self->interval = relative_deadline;
+	self->target   = relative_deadline * runtime_admissions_codel_target_percent / 100;
+	atomic_init(&self->interval_start, __getcycles());
+	atomic_init(&self->interval_min, UINT64_MAX);
+	atomic_init(&self->is_dropping, false);
+}
+
+/**
+ * Records the sojourn of a request leaving the global request scheduler, and decides whether to shed it
+ * @param self the state of the request's module
+ * @param request_arrival_timestamp
+ * @returns true if the request should be failed rather than executed
+ */
+bool
+admissions_codel_should_shed(struct admissions_codel *self, uint64_t request_arrival_timestamp)
+{
+	assert(self != NULL);
+
+	uint64_t now     = __getcycles();
+	uint64_t sojourn = now - request_arrival_timestamp;
+
+	admissions_codel_stats[worker_thread_idx].dequeued++;
+
+	uint64_t min = atomic_load_explicit(&self->interval_min, memory_order_relaxed);
+	while (sojourn < min && !atomic_compare_exchange_weak(&self->interval_min, &min, sojourn))
+		;
+
+	/* The first worker to observe the end of an interval evaluates it. An interval without dequeues has no minimum,
+	 * and does not start dropping */
+	uint64_t start = atomic_load_explicit(&self->interval_start, memory_order_relaxed);
+	if (now - start >= self->interval && atomic_compare_exchange_strong(&self->interval_start, &start, now)) {
+		uint64_t observed = atomic_exchange(&self->interval_min, UINT64_MAX);
+		atomic_store(&self->is_dropping, observed != UINT64_MAX && observed > self->target);
+#ifdef LOG_ADMISSIONS_CONTROL
+		debuglog("Minimum sojourn %lu cycles against target %lu cycles\n", observed, self->target);
+#endif
+	}
+
+	if (sojourn <= self->target || !atomic_load_explicit(&self->is_dropping, memory_order_relaxed)) return false;
+
+	admissions_codel_stats[worker_thread_idx].shed++;
+	return true;
+}
+
+void
+admissions_codel_stats_print()
+{
+	printf("Admissions CoDel\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu dequeued, %lu shed\n", i, admissions_codel_stats[i].dequeued,
+		       admissions_codel_stats[i].shed);
+	}
+	fflush(stdout);
+}
@@ -4,6 +4,8 @@
 #include "admissions_control.h"
 #include "debuglog.h"
 #include "client_socket.h"
+#include "runtime.h"
+#include "worker_thread.h"
 
 /*
  * Unitless estimate of the instantaneous fraction of system capacity required to complete all previously
@@ -16,17 +18,94 @@
  * success or failure)
  */
 _Atomic uint64_t admissions_control_admitted;
-uint64_t         admissions_control_capacity;
+_Atomic uint64_t admissions_control_capacity;
 
-const double admissions_control_overhead = 0.2;
+/*
+ * Fraction of worker capacity withheld from admissions to account for runtime overhead. Static unless
+ * SLEDGE_ADMISSIONS_ADAPTIVE_OVERHEAD is set, in which case the perf window aggregator adapts it to the observed
+ * deadline miss rate of completed requests: additively increasing it while misses exceed
+ * ADMISSIONS_CONTROL_MISS_RATE_TARGET, and slowly decreasing it while no requests miss
+ */
+double admissions_control_overhead = ADMISSIONS_CONTROL_OVERHEAD_INITIAL;
+
+struct admissions_control_stats admissions_control_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+static inline uint64_t
+admissions_control_calculate_capacity(double overhead)
+{
+	return runtime_worker_threads_count * ADMISSIONS_CONTROL_GRANULARITY * ((double)1.0 - overhead);
+}
 
 void
 admissions_control_initialize()
 {
 #ifdef ADMISSIONS_CONTROL
 	atomic_init(&admissions_control_admitted, 0);
-	admissions_control_capacity = runtime_worker_threads_count * ADMISSIONS_CONTROL_GRANULARITY
-	                              * ((double)1.0 - admissions_control_overhead);
+	atomic_init(&admissions_control_capacity, admissions_control_calculate_capacity(admissions_control_overhead));
+#endif
+}
+
+/**
+ * Records whether a completed request met its deadline
+ * Called by the worker that completed the request
+ * @param missed_deadline
+ */
+void
+admissions_control_record_completion(bool missed_deadline)
+{
+#ifdef ADMISSIONS_CONTROL
+	struct admissions_control_stats *stats = &admissions_control_stats[worker_thread_idx];
+	atomic_store_explicit(&stats->completions, atomic_load_explicit(&stats->completions, memory_order_relaxed) + 1,
+	                      memory_order_relaxed);
+	if (missed_deadline)
+		atomic_store_explicit(&stats->deadline_misses,
+		                      atomic_load_explicit(&stats->deadline_misses, memory_order_relaxed) + 1,
+		                      memory_order_relaxed);
+#endif
+}
+
+/**
+ * Adapts the overhead factor to the deadline miss rate of requests completed since the last adaptation, and
+ * recalculates capacity. Does nothing until ADMISSIONS_CONTROL_ADAPT_MIN_COMPLETIONS requests have completed
+ * Only called by the perf window aggregator
+ */
+void
+admissions_control_adapt_overhead(void)
+{
+#ifdef ADMISSIONS_CONTROL
+	static uint64_t last_completions = 0;
+	static uint64_t last_misses      = 0;
+
+	uint64_t completions = 0;
+	uint64_t misses      = 0;
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		completions += atomic_load_explicit(&admissions_control_stats[i].completions, memory_order_relaxed);
+		misses += atomic_load_explicit(&admissions_control_stats[i].deadline_misses, memory_order_relaxed);
+	}
+
+	if (completions - last_completions < ADMISSIONS_CONTROL_ADAPT_MIN_COMPLETIONS) return;
+
+	double miss_rate = (double)(misses - last_misses) / (completions - last_completions);
+	last_completions = completions;
+	last_misses      = misses;
+
+	double overhead = admissions_control_overhead;
+	if (miss_rate > ADMISSIONS_CONTROL_MISS_RATE_TARGET) {
+		overhead += ADMISSIONS_CONTROL_OVERHEAD_INCREASE;
+	} else if (miss_rate == 0) {
+		overhead -= ADMISSIONS_CONTROL_OVERHEAD_DECREASE;
+	}
+
+	if (overhead < ADMISSIONS_CONTROL_OVERHEAD_MIN) overhead = ADMISSIONS_CONTROL_OVERHEAD_MIN;
+	if (overhead > ADMISSIONS_CONTROL_OVERHEAD_MAX) overhead = ADMISSIONS_CONTROL_OVERHEAD_MAX;
+	if (overhead == admissions_control_overhead) return;
+
+	admissions_control_overhead = overhead;
+	atomic_store(&admissions_control_capacity, admissions_control_calculate_capacity(overhead));
+
+#ifdef LOG_ADMISSIONS_CONTROL
+	debuglog("Miss rate %f, Overhead: %f, Capacity: %lu\n", miss_rate, overhead, admissions_control_capacity);
+#endif
 #endif
 }
 
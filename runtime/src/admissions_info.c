@@ -1,5 +1,7 @@
+#include "admissions_control.h"
 #include "admissions_info.h"
 #include "debuglog.h"
+#include "perf_window.h"
 
 /**
  * Initializes perf window
@@ -9,6 +11,9 @@ void
 admissions_info_initialize(struct admissions_info *self, int percentile, uint64_t expected_execution,
                            uint64_t relative_deadline)
 {
+	/* Seeds the execution estimate of domain affinity and early rejection, regardless of admissions control */
+	self->estimated_execution = expected_execution;
+
 #ifdef ADMISSIONS_CONTROL
 	assert(relative_deadline > 0);
 	assert(expected_execution > 0);
@@ -22,30 +27,41 @@ admissions_info_initialize(struct admissions_info *self, int percentile, uint64_
 	if (unlikely(percentile < 50 || percentile > 99)) panic("Invalid admissions percentile");
 	self->percentile = percentile;
 
-	self->control_index = PERF_WINDOW_BUFFER_SIZE * percentile / 100;
 #ifdef LOG_ADMISSIONS_CONTROL
 	debuglog("Percentile: %d\n", self->percentile);
-	debuglog("Control Index: %d\n", self->control_index);
 #endif
 #endif
 }
 
 
 /*
- * Adds an execution value to the perf window and calculates and caches and updated estimate
+ * Adds an execution value to the calling worker's shard of the perf window. The estimate is updated when the perf
+ * window aggregator next merges the shards
  * @param self
  * @param execution_duration
  */
 void
 admissions_info_update(struct admissions_info *self, uint64_t execution_duration)
 {
+#ifdef ADMISSIONS_CONTROL
+	perf_window_add(&self->perf_window, execution_duration);
+#endif
+}
+
+/*
+ * Merges the perf window and caches an updated estimate if any executions were merged
+ * Only called by the perf window aggregator
+ * @param self
+ */
+void
+admissions_info_refresh(struct admissions_info *self)
+{
 #ifdef ADMISSIONS_CONTROL
 	struct perf_window *perf_window = &self->perf_window;
 
-	LOCK_LOCK(&self->perf_window.lock);
-	perf_window_add(perf_window, execution_duration);
-	uint64_t estimated_execution = perf_window_get_percentile(perf_window, self->percentile, self->control_index);
-	self->estimate = admissions_control_calculate_estimate(estimated_execution, self->relative_deadline);
-	LOCK_UNLOCK(&self->perf_window.lock);
+	if (perf_window_merge(perf_window) == 0) return;
+
+	self->estimated_execution = perf_window_get_percentile(perf_window, self->percentile);
+	self->estimate = admissions_control_calculate_estimate(self->estimated_execution, self->relative_deadline);
 #endif
 }
@@ -1,3 +1,25 @@
+#include <stdio.h>
+#include <threads.h>
+
 #include "cache_protection.h"
 
 enum CACHE_PROTECTION cache_protection = CACHE_PROTECTION_NONE;
+
+struct cache_protection_stats cache_protection_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+thread_local struct cache_protection_last cache_protection_last = { .is_valid = false };
+
+void
+cache_protection_stats_print()
+{
+	printf("Cache Protection\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		struct cache_protection_stats *stats = &cache_protection_stats[i];
+		printf("Worker %d: %lu flushes (%lu us), %lu avoided, %lu affinity picks, %lu us slack used, %lu completions "
+		       "(%lu us executing)\n",
+		       i, stats->flushes, stats->flush_cycles / runtime_processor_speed_MHz, stats->flushes_avoided,
+		       stats->affinity_picks, stats->slack_used / runtime_processor_speed_MHz, stats->completions,
+		       stats->execution_cycles / runtime_processor_speed_MHz);
+	}
+	fflush(stdout);
+}
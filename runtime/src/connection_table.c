@@ -0,0 +1,187 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "arch/getcycles.h"
+#include "client_socket.h"
+#include "connection_table.h"
+#include "debuglog.h"
+#include "panic.h"
+#include "worker_listener.h"
+#include "worker_thread.h"
+
+struct connection {
+	struct module * module; /* NULL if the slot is free */
+	int             socket_descriptor;
+	struct sockaddr client_address;
+	uint32_t        request_count; /* Requests already served on this connection */
+	uint64_t        idle_since;    /* cycles */
+};
+
+static thread_local struct connection connection_table[CONNECTION_TABLE_CAPACITY];
+static thread_local uint32_t          connection_table_free_slots[CONNECTION_TABLE_CAPACITY];
+static thread_local uint32_t          connection_table_free_count = 0;
+static thread_local int               connection_table_epoll_file_descriptor;
+static thread_local uint64_t          connection_table_next_sweep = 0;
+
+struct connection_table_stats connection_table_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+/**
+ * Creates the calling worker's connection table and the epoll instance watching it
+ */
+void
+connection_table_initialize(void)
+{
+	connection_table_epoll_file_descriptor = epoll_create1(EPOLL_CLOEXEC);
+	if (unlikely(connection_table_epoll_file_descriptor < 0)) panic_err();
+
+	for (uint32_t i = 0; i < CONNECTION_TABLE_CAPACITY; i++) {
+		connection_table[i].module                                 = NULL;
+		connection_table_free_slots[connection_table_free_count++] = CONNECTION_TABLE_CAPACITY - 1 - i;
+	}
+}
+
+/**
+ * @returns true if the calling worker can park another connection
+ */
+bool
+connection_table_has_space(void)
+{
+	return connection_table_free_count > 0;
+}
+
+/**
+ * Unregisters a connection from epoll and frees its slot
+ * @param slot
+ * @param should_close if true, closes the client socket
+ */
+static inline void
+connection_table_remove(uint32_t slot, bool should_close)
+{
+	struct connection *connection = &connection_table[slot];
+	assert(connection->module != NULL);
+
+	int rc = epoll_ctl(connection_table_epoll_file_descriptor, EPOLL_CTL_DEL, connection->socket_descriptor, NULL);
+	if (unlikely(rc < 0)) panic_err();
+
+	if (should_close) client_socket_close(connection->socket_descriptor, &connection->client_address);
+
+	connection->module                                         = NULL;
+	connection_table_free_slots[connection_table_free_count++] = slot;
+}
+
+/**
+ * Parks the client socket of a completed sandbox until the client sends its next request
+ * The socket is closed if the table is full
+ * @param module the module the connection was accepted on
+ * @param socket_descriptor nonblocking client socket, no longer registered with the I/O engine
+ * @param client_address
+ * @param request_count requests served on the connection so far
+ */
+void
+connection_table_add(struct module *module, int socket_descriptor, struct sockaddr *client_address,
+                     uint32_t request_count)
+{
+	assert(module != NULL);
+
+	if (unlikely(connection_table_free_count == 0)) {
+		client_socket_close(socket_descriptor, client_address);
+		return;
+	}
+
+	uint32_t           slot       = connection_table_free_slots[--connection_table_free_count];
+	struct connection *connection = &connection_table[slot];
+	connection->module            = module;
+	connection->socket_descriptor = socket_descriptor;
+	connection->request_count     = request_count;
+	connection->idle_since        = __getcycles();
+	memcpy(&connection->client_address, client_address, sizeof(struct sockaddr));
+
+	struct epoll_event connection_evt;
+	connection_evt.data.u32 = slot;
+	connection_evt.events   = EPOLLIN | EPOLLRDHUP;
+	int rc = epoll_ctl(connection_table_epoll_file_descriptor, EPOLL_CTL_ADD, socket_descriptor, &connection_evt);
+	if (unlikely(rc < 0)) panic_err();
+}
+
+/**
+ * Closes connections that have been idle for longer than the keep-alive timeout
+ * Sweeps are spaced a quarter of the timeout apart, so a connection is closed within 1.25x the timeout
+ * @param now cycles
+ */
+static inline void
+connection_table_sweep(uint64_t now)
+{
+	uint64_t timeout = (uint64_t)runtime_keepalive_timeout_us * runtime_processor_speed_MHz;
+	if (now < connection_table_next_sweep) return;
+	connection_table_next_sweep = now + timeout / 4;
+
+	for (uint32_t slot = 0; slot < CONNECTION_TABLE_CAPACITY; slot++) {
+		struct connection *connection = &connection_table[slot];
+		if (connection->module == NULL || now - connection->idle_since < timeout) continue;
+
+		connection_table_remove(slot, true);
+		connection_table_stats[worker_thread_idx].expired++;
+	}
+}
+
+/**
+ * Creates sandboxes for the requests that arrived on the calling worker's parked connections and expires idle
+ * connections
+ */
+void
+connection_table_poll(void)
+{
+	struct epoll_event epoll_events[RUNTIME_MAX_EPOLL_EVENTS];
+
+	int descriptor_count = epoll_wait(connection_table_epoll_file_descriptor, epoll_events,
+	                                  RUNTIME_MAX_EPOLL_EVENTS, 0);
+	if (descriptor_count < 0) {
+		if (errno == EINTR) return;
+		panic_err();
+	}
+
+	uint64_t now = __getcycles();
+	for (int i = 0; i < descriptor_count; i++) {
+		uint32_t           slot       = epoll_events[i].data.u32;
+		struct connection *connection = &connection_table[slot];
+		assert(connection->module != NULL);
+
+		/* Distinguish the next request from an orderly shutdown by the client, which is also readable */
+		char    byte;
+		ssize_t rc = recv(connection->socket_descriptor, &byte, 1, MSG_PEEK);
+		if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+		if (rc <= 0) {
+			connection_table_remove(slot, true);
+			connection_table_stats[worker_thread_idx].closed++;
+			continue;
+		}
+
+		struct module * module            = connection->module;
+		int             socket_descriptor = connection->socket_descriptor;
+		uint32_t        request_count     = connection->request_count;
+		struct sockaddr client_address;
+		memcpy(&client_address, &connection->client_address, sizeof(struct sockaddr));
+		connection_table_remove(slot, false);
+
+		connection_table_stats[worker_thread_idx].reused++;
+		worker_listener_dispatch(module, socket_descriptor, &client_address, now, request_count);
+	}
+
+	connection_table_sweep(now);
+}
+
+void
+connection_table_stats_print()
+{
+	printf("Connection Table\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu reused, %lu expired, %lu closed\n", i, connection_table_stats[i].reused,
+		       connection_table_stats[i].expired, connection_table_stats[i].closed);
+	}
+	fflush(stdout);
+}
@@ -2,6 +2,7 @@
 
 #include "current_sandbox.h"
 #include "sandbox_functions.h"
+#include "sandbox_pipeline.h"
 #include "sandbox_receive_request.h"
 #include "sandbox_send_response.h"
 #include "sandbox_set_as_asleep.h"
@@ -110,7 +111,8 @@ current_sandbox_init()
 
 	sandbox_open_http(sandbox);
 
-	rc = sandbox_receive_request(sandbox);
+	/* Later stages of a pipeline were handed their request body by the prior stage */
+	if (sandbox->pipeline_stage == 0) rc = sandbox_receive_request(sandbox);
 	if (rc == -2) {
 		/* Request size exceeded Buffer, send 413 Payload Too Large */
 		client_socket_send(sandbox->client_socket_descriptor, 413);
@@ -120,11 +122,19 @@ current_sandbox_init()
 		goto err;
 	}
 
-	/* Initialize sandbox memory */
+	/* Initialize sandbox memory, mapping the module snapshot if one has been captured */
 	struct module *current_module = sandbox_get_module(sandbox);
 	module_initialize_globals(current_module);
-	module_initialize_memory(current_module);
-	sandbox_setup_arguments(sandbox);
+	if (module_snapshot_is_ready(&current_module->snapshot)) {
+		module_snapshot_restore(&current_module->snapshot, &sandbox->memory, &sandbox->arguments_offset);
+		local_sandbox_context_cache.memory.size = sandbox->memory.size;
+		sandbox->memory_is_snapshot             = true;
+	} else {
+		module_initialize_memory(current_module);
+		sandbox_setup_arguments(sandbox);
+		module_snapshot_capture(&current_module->snapshot, current_module->name, &sandbox->memory,
+		                        sandbox->arguments_offset);
+	}
 	sandbox_return(sandbox);
 
 	return sandbox;
@@ -147,14 +157,27 @@ current_sandbox_fini()
 
 	sandbox->timestamp_of.completion = __getcycles();
 
+	/* Hand the result to the next stage of the pipeline, which takes over the client socket */
+	if (sandbox->module->next_stage != NULL) {
+		int status_code = sandbox_pipeline_handoff(sandbox);
+		if (status_code != 0) {
+			client_socket_send(sandbox->client_socket_descriptor, status_code);
+			error_message = "Unable to hand off to the next stage\n";
+			goto err;
+		}
+
+		sandbox->timestamp_of.response = __getcycles();
+		io_engine_release(sandbox);
+		sandbox_set_as_returned(sandbox, SANDBOX_RUNNING_SYS);
+		goto done;
+	}
+
 	/* Retrieve the result, construct the HTTP response, and send to client */
 	if (sandbox_send_response(sandbox) < 0) {
 		error_message = "Unable to build and send client response\n";
 		goto err;
 	};
 
-	http_total_increment_2xx();
-
 	sandbox->timestamp_of.response = __getcycles();
 
 	assert(sandbox->state == SANDBOX_RUNNING_SYS);
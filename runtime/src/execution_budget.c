@@ -0,0 +1,44 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include "debuglog.h"
+#include "execution_budget.h"
+
+struct execution_budget_stats execution_budget_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+/* Modules with a budget. Budget statistics are only printed if this is nonzero */
+uint32_t execution_budget_module_count = 0;
+
+/**
+ * @param self
+ * @param deadline_multiple multiple of the relative deadline after request arrival at which a sandbox overruns. 0 is
+ * unlimited
+ * @param max_cpu_us execution time at which a sandbox overruns. 0 is unlimited
+ * @param policy what to do with a sandbox that overruns
+ * @param relative_deadline of the module in cycles
+ */
+void
+execution_budget_initialize(struct execution_budget *self, uint32_t deadline_multiple, uint32_t max_cpu_us,
+                            enum execution_budget_policy policy, uint64_t relative_deadline)
+{
+	assert(self != NULL);
+	assert(deadline_multiple == 0 || relative_deadline != 0);
+
+	self->deadline_multiple = deadline_multiple;
+	self->max_cpu           = (uint64_t)max_cpu_us * runtime_processor_speed_MHz;
+	self->max_elapsed       = (uint64_t)deadline_multiple * relative_deadline;
+	self->policy            = policy;
+
+	if (execution_budget_is_enabled(self)) execution_budget_module_count++;
+}
+
+void
+execution_budget_stats_print()
+{
+	printf("Execution Budgets\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu aborts, %lu demotions\n", i, execution_budget_stats[i].aborts,
+		       execution_budget_stats[i].demotions);
+	}
+	fflush(stdout);
+}
@@ -19,10 +19,14 @@
 
 int btbf = -1;
 
+enum FLUSH_BACKEND flush_backend = FLUSH_BACKEND_KERNEL;
+
 /**
- * Opens the flush ko device. Returns true on success, false on failure
+ * Initializes the selected flush backend. Returns true on success, false on failure
  */
 bool flush_init() {
+    if (flush_backend == FLUSH_BACKEND_USERSPACE) return flush_userspace_initialize();
+
     if(btbf < 0) {
         btbf = open(COOL_DEVICE_PATH, 0);
         if(btbf < 0) {
@@ -54,4 +58,20 @@ void cflush() {
         printf("Failed to execute cflsh.\n");
         abort();
     }
-} 
+}
+
+/**
+ * Flushes the state a sandbox may have left in the core's caches and branch predictors
+ * @param outgoing the sandbox that last ran, or NULL if unknown or no longer mapped
+ */
+void flush(struct sandbox *outgoing) {
+    switch (flush_backend) {
+        case FLUSH_BACKEND_KERNEL:
+            btb_flush();
+            cflush();
+            break;
+        case FLUSH_BACKEND_USERSPACE:
+            flush_userspace(outgoing);
+            break;
+    }
+}
@@ -0,0 +1,245 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <threads.h>
+
+#if defined(X86_64) || defined(x86_64)
+#include <cpuid.h>
+#endif
+
+#include "flush.h"
+#include "likely.h"
+#include "panic.h"
+#include "runtime.h"
+#include "sandbox_types.h"
+#include "types.h"
+
+/*
+ * A flush backend that needs no kernel module
+ *
+ * Data caches are flushed in two steps. First, the resident pages of the outgoing sandbox's linear memory and stack
+ * are written back and invalidated line by line (clflushopt, or clflush on older x86, or dc civac on aarch64). Pages
+ * that are not resident were not touched since they were last dropped, so they cannot be cached, and naming their
+ * lines would fault them in. Second, a per-worker eviction buffer sized from the cache geometry is swept, displacing
+ * lines of the caches up to SLEDGE_FLUSH_EVICT_LEVEL that the first step could not name, such as the runtime's own
+ * state touched by the sandbox.
+ *
+ * Branch predictors cannot be flushed from userspace, as IBPB is a privileged MSR write. Instead, initialization asks
+ * the kernel to restrict indirect branch speculation for the process, which protects against SMT siblings and other
+ * processes but not between sandboxes sharing a core.
+ */
+
+#define FLUSH_USERSPACE_CACHE_PATH        "/sys/devices/system/cpu/cpu0/cache"
+#define FLUSH_USERSPACE_MAX_CACHE_INDICES 8
+#define FLUSH_USERSPACE_DEFAULT_LINE_SIZE 64
+
+/* Eviction buffers span this multiple of the caches they evict, as replacement policies are not true LRU */
+#define FLUSH_USERSPACE_EVICTION_FACTOR 2
+
+/* Pages whose residency is queried per mincore call. Flushes run in the SIGALRM handler, so nothing is allocated */
+#define FLUSH_USERSPACE_RESIDENCY_PAGES 4096
+
+static size_t flush_userspace_line_size   = FLUSH_USERSPACE_DEFAULT_LINE_SIZE;
+static size_t flush_userspace_buffer_size = 0;
+static bool   flush_userspace_has_clflushopt;
+
+static thread_local char *        flush_userspace_buffer = NULL;
+static thread_local unsigned char flush_userspace_residency[FLUSH_USERSPACE_RESIDENCY_PAGES];
+
+/**
+ * Reads a single line of a sysfs cache attribute
+ * @returns 0 on success, -1 if the attribute is missing
+ */
+static inline int
+flush_userspace_read_attribute(int index, const char *attribute, char *buffer, size_t buffer_size)
+{
+	char path[128];
+	snprintf(path, sizeof(path), FLUSH_USERSPACE_CACHE_PATH "/index%d/%s", index, attribute);
+
+	FILE *file = fopen(path, "r");
+	if (file == NULL) return -1;
+
+	char *line = fgets(buffer, buffer_size, file);
+	fclose(file);
+	if (line == NULL) return -1;
+
+	buffer[strcspn(buffer, "\n")] = '\0';
+	return 0;
+}
+
+/**
+ * Sums the sizes of the data and unified caches of cpu0 up to and including a level
+ * @param level the outermost level to evict
+ * @returns the total size in bytes, or 0 if the geometry could not be detected
+ */
+static size_t
+flush_userspace_detect_geometry(uint32_t level)
+{
+	size_t total = 0;
+	char   buffer[64];
+	char   type[32];
+
+	for (int i = 0; i < FLUSH_USERSPACE_MAX_CACHE_INDICES; i++) {
+		if (flush_userspace_read_attribute(i, "level", buffer, sizeof(buffer)) < 0) break;
+		uint32_t cache_level = (uint32_t)atoi(buffer);
+
+		if (flush_userspace_read_attribute(i, "type", type, sizeof(type)) < 0) continue;
+		if (strcmp(type, "Instruction") == 0) continue;
+
+		if (flush_userspace_read_attribute(i, "coherency_line_size", buffer, sizeof(buffer)) == 0) {
+			size_t line_size = (size_t)atol(buffer);
+			if (line_size > 0) flush_userspace_line_size = line_size;
+		}
+
+		if (cache_level > level) continue;
+		if (flush_userspace_read_attribute(i, "size", buffer, sizeof(buffer)) < 0) continue;
+
+		char * suffix = NULL;
+		size_t size   = (size_t)strtoul(buffer, &suffix, 10);
+		if (*suffix == 'K') size *= 1024;
+		if (*suffix == 'M') size *= 1024 * 1024;
+
+		printf("\tL%u %s Cache: %zu bytes\n", cache_level, type, size);
+		total += size;
+	}
+
+	return total;
+}
+
+/**
+ * Detects the cache geometry and restricts indirect branch speculation
+ * Assumption: Called once by the main thread before workers start
+ * @returns true on success, false if the cache geometry could not be detected
+ */
+bool
+flush_userspace_initialize(void)
+{
+	uint32_t level     = 2;
+	char *   level_raw = getenv("SLEDGE_FLUSH_EVICT_LEVEL");
+	if (level_raw != NULL) {
+		level = (uint32_t)atoi(level_raw);
+		if (unlikely(level < 1 || level > 3)) panic("SLEDGE_FLUSH_EVICT_LEVEL must be 1, 2, or 3\n");
+	}
+	printf("\tFlush Eviction Level: L%u\n", level);
+
+	size_t cache_size = flush_userspace_detect_geometry(level);
+	if (cache_size == 0) return false;
+	flush_userspace_buffer_size = cache_size * FLUSH_USERSPACE_EVICTION_FACTOR;
+	printf("\tFlush Eviction Buffer: %zu bytes, %zu byte lines\n", flush_userspace_buffer_size,
+	       flush_userspace_line_size);
+
+#if defined(X86_64) || defined(x86_64)
+	uint32_t eax, ebx, ecx, edx;
+	flush_userspace_has_clflushopt = __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_CLFLUSHOPT);
+#endif
+
+#ifdef PR_SPEC_INDIRECT_BRANCH
+	if (prctl(PR_SET_SPECULATION_CTRL, PR_SPEC_INDIRECT_BRANCH, PR_SPEC_DISABLE, 0, 0) < 0)
+		fprintf(stderr, "Unable to restrict indirect branch speculation: %s\n", strerror(errno));
+#endif
+
+	return true;
+}
+
+/**
+ * Writes back and invalidates every cache line of a region
+ * @param start
+ * @param size
+ */
+static inline void
+flush_userspace_region(void *start, size_t size)
+{
+	if (start == NULL || size == 0) return;
+
+	uintptr_t line = (uintptr_t)start & ~(flush_userspace_line_size - 1);
+	uintptr_t end  = (uintptr_t)start + size;
+
+#if defined(X86_64) || defined(x86_64)
+	if (flush_userspace_has_clflushopt) {
+		for (; line < end; line += flush_userspace_line_size)
+			/* clflushopt is clflush with a 0x66 prefix, which avoids requiring assembler support */
+			__asm__ volatile(".byte 0x66; clflush %0" : "+m"(*(volatile char *)line));
+		__asm__ volatile("sfence" ::: "memory");
+	} else {
+		for (; line < end; line += flush_userspace_line_size)
+			__asm__ volatile("clflush %0" : "+m"(*(volatile char *)line));
+		__asm__ volatile("mfence" ::: "memory");
+	}
+#elif defined(AARCH64) || defined(aarch64)
+	for (; line < end; line += flush_userspace_line_size) __asm__ volatile("dc civac, %0" ::"r"(line) : "memory");
+	__asm__ volatile("dsb ish" ::: "memory");
+#endif
+}
+
+/**
+ * Writes back and invalidates the cache lines of the resident pages of a region
+ * If residency cannot be queried, the region is left to the eviction sweep
+ * @param start page aligned
+ * @param size
+ */
+static inline void
+flush_userspace_resident_region(void *start, size_t size)
+{
+	if (start == NULL || size == 0) return;
+
+	char * base       = start;
+	size_t page_count = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+	for (size_t chunk = 0; chunk < page_count; chunk += FLUSH_USERSPACE_RESIDENCY_PAGES) {
+		size_t chunk_pages = page_count - chunk;
+		if (chunk_pages > FLUSH_USERSPACE_RESIDENCY_PAGES) chunk_pages = FLUSH_USERSPACE_RESIDENCY_PAGES;
+
+		char *chunk_start = base + chunk * PAGE_SIZE;
+		if (unlikely(mincore(chunk_start, chunk_pages * PAGE_SIZE, flush_userspace_residency) == -1)) continue;
+
+		/* Flush runs of resident pages */
+		size_t i = 0;
+		while (i < chunk_pages) {
+			if (!(flush_userspace_residency[i] & 1)) {
+				i++;
+				continue;
+			}
+
+			size_t run_start = i;
+			while (i < chunk_pages && (flush_userspace_residency[i] & 1)) i++;
+			flush_userspace_region(chunk_start + run_start * PAGE_SIZE, (i - run_start) * PAGE_SIZE);
+		}
+	}
+}
+
+/**
+ * Sweeps this worker's eviction buffer, allocating it on first use
+ */
+static inline void
+flush_userspace_evict(void)
+{
+	if (unlikely(flush_userspace_buffer == NULL)) {
+		void *buffer = mmap(NULL, flush_userspace_buffer_size, PROT_READ | PROT_WRITE,
+		                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+		if (unlikely(buffer == MAP_FAILED)) panic("flush_userspace_evict - mmap failed: %s\n", strerror(errno));
+		flush_userspace_buffer = buffer;
+	}
+
+	/* Writing, rather than reading, leaves lines modified, so they also displace lines in exclusive states */
+	for (size_t offset = 0; offset < flush_userspace_buffer_size; offset += flush_userspace_line_size)
+		((volatile char *)flush_userspace_buffer)[offset]++;
+}
+
+/**
+ * @param outgoing the sandbox that last ran, or NULL if unknown or no longer mapped
+ */
+void
+flush_userspace(struct sandbox *outgoing)
+{
+	if (outgoing != NULL) {
+		flush_userspace_resident_region(outgoing->memory.start, outgoing->memory.size);
+		flush_userspace_resident_region(outgoing->stack.start, outgoing->stack.size);
+	}
+
+	flush_userspace_evict();
+}
@@ -0,0 +1,90 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "debuglog.h"
+#include "gang_domain.h"
+#include "likely.h"
+#include "panic.h"
+
+struct gang_domain {
+	int32_t          id;
+	_Atomic uint32_t weight;
+	bool             is_weight_set; /* Whether a module set the weight explicitly */
+};
+
+static struct gang_domain gang_domains[MAX_DOMAINS];
+static _Atomic uint32_t   gang_domains_count        = 0;
+static _Atomic uint32_t   gang_domains_weight_total = 0;
+
+/**
+ * Registers the domain of a module, assigning a slot on the first registration of the domain
+ * Assumption: Called by the main thread as modules are loaded
+ * @param domain the domain ID from the module JSON
+ * @param weight the weight from the module JSON, or 0 if not set
+ * @returns the slot of the domain
+ */
+uint32_t
+gang_domain_register(int32_t domain, uint32_t weight)
+{
+	if (unlikely(domain < 0)) panic("The GANG scheduler requires every module to set a domain >= 0\n");
+	assert(weight <= GANG_DOMAIN_WEIGHT_MAX);
+
+	uint32_t count = atomic_load(&gang_domains_count);
+	for (uint32_t slot = 0; slot < count; slot++) {
+		struct gang_domain *entry = &gang_domains[slot];
+		if (entry->id != domain) continue;
+		if (weight == 0) return slot;
+
+		uint32_t previous = atomic_load(&entry->weight);
+		if (unlikely(entry->is_weight_set && previous != weight))
+			panic("Modules of domain %d set conflicting weights %u and %u\n", domain, previous, weight);
+
+		entry->is_weight_set = true;
+		atomic_store(&entry->weight, weight);
+		atomic_fetch_add(&gang_domains_weight_total, weight - previous);
+		return slot;
+	}
+
+	if (unlikely(count == MAX_DOMAINS)) panic("The GANG scheduler supports at most %d domains\n", MAX_DOMAINS);
+
+	struct gang_domain *entry = &gang_domains[count];
+	entry->id                 = domain;
+	entry->is_weight_set      = weight != 0;
+	atomic_init(&entry->weight, weight == 0 ? GANG_DOMAIN_WEIGHT_DEFAULT : weight);
+	atomic_fetch_add(&gang_domains_weight_total, atomic_load(&entry->weight));
+	atomic_store(&gang_domains_count, count + 1);
+
+#ifdef LOG_MODULE_LOADING
+	debuglog("Registered domain %d in slot %u\n", domain, count);
+#endif
+
+	return count;
+}
+
+uint32_t
+gang_domain_count(void)
+{
+	return atomic_load(&gang_domains_count);
+}
+
+int32_t
+gang_domain_id(uint32_t slot)
+{
+	assert(slot < gang_domain_count());
+	return gang_domains[slot].id;
+}
+
+uint32_t
+gang_domain_weight(uint32_t slot)
+{
+	assert(slot < gang_domain_count());
+	return atomic_load(&gang_domains[slot].weight);
+}
+
+uint32_t
+gang_domain_weight_total(void)
+{
+	return atomic_load(&gang_domains_weight_total);
+}
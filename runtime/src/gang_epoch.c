@@ -0,0 +1,105 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <threads.h>
+#include <time.h>
+
+#include "gang_domain.h"
+#include "gang_epoch.h"
+#include "panic.h"
+#include "software_interrupt.h"
+#include "worker_thread.h"
+
+struct gang_epoch_stats gang_epoch_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+/* The last epoch observed by this worker, its domain slot, and whether the worker ran a sandbox during it */
+static thread_local uint64_t gang_epoch_last      = UINT64_MAX;
+static thread_local uint32_t gang_epoch_last_slot = 0;
+static thread_local bool     gang_epoch_last_busy = false;
+
+/**
+ * @returns the index of the current epoch
+ */
+static inline uint64_t
+gang_epoch_current(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	uint64_t elapsed_ns = (uint64_t)(now.tv_sec - software_interrupt_timer_epoch.tv_sec) * 1000000000
+	                      + now.tv_nsec - software_interrupt_timer_epoch.tv_nsec;
+	return elapsed_ns / ((uint64_t)runtime_quantum_us * 1000);
+}
+
+/**
+ * Maps an epoch to a domain slot. Each domain is given weight consecutive epochs of every round
+ * @param epoch
+ * @param count the number of registered domains
+ * @returns domain slot
+ */
+static inline uint32_t
+gang_epoch_slot(uint64_t epoch, uint32_t count)
+{
+	uint32_t slot     = 0;
+	uint64_t position = epoch % gang_domain_weight_total();
+
+	/* A domain may register during the walk, so the walk is bounded by the count read by the caller */
+	for (; slot < count - 1; slot++) {
+		uint32_t weight = gang_domain_weight(slot);
+		if (position < weight) break;
+		position -= weight;
+	}
+
+	return slot;
+}
+
+/**
+ * Determines the domain of the calling worker's group in the current epoch, accounting the epoch if it is new to
+ * this worker. Groups are offset from one another, so distinct groups run distinct domains when enough exist
+ * @returns the slot of the domain the calling worker should run
+ */
+uint32_t
+gang_epoch_domain(void)
+{
+	uint32_t count = gang_domain_count();
+	if (unlikely(count == 0)) return 0;
+
+	uint64_t epoch = gang_epoch_current();
+	if (epoch != gang_epoch_last) {
+		gang_epoch_stats[worker_thread_idx].epochs += gang_epoch_last == UINT64_MAX ? 1 : epoch - gang_epoch_last;
+		gang_epoch_last      = epoch;
+		gang_epoch_last_busy = false;
+
+		uint32_t group       = worker_thread_idx / runtime_gang_group_size;
+		gang_epoch_last_slot = (gang_epoch_slot(epoch, count) + group) % count;
+	}
+
+	return gang_epoch_last_slot;
+}
+
+/**
+ * Records that the calling worker ran a sandbox during its current epoch
+ */
+void
+gang_epoch_mark_busy(void)
+{
+	if (gang_epoch_last_busy) return;
+
+	gang_epoch_stats[worker_thread_idx].busy_epochs++;
+	gang_epoch_last_busy = true;
+}
+
+void
+gang_epoch_stats_print()
+{
+	printf("Gang Epoch\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		struct gang_epoch_stats *stats       = &gang_epoch_stats[i];
+		double                   utilization = stats->epochs == 0
+		                                         ? 0
+		                                         : (double)stats->busy_epochs / stats->epochs * 100;
+		printf("Worker %d: %lu epochs, %lu busy (%.2f%% utilization), %lu parked\n", i, stats->epochs,
+		       stats->busy_epochs, utilization, stats->parked);
+	}
+	fflush(stdout);
+}
@@ -7,6 +7,7 @@
 
 #include "current_sandbox.h"
 #include "debuglog.h"
+#include "global_request_scheduler_domain.h"
 #include "local_runqueue.h"
 #include "panic.h"
 
@@ -35,7 +36,13 @@ local_runqueue_gang_get_head()
 void
 local_runqueue_gang_remove(struct sandbox *sandbox_to_remove)
 {
+    uint32_t domain = sandbox_to_remove->module->domain_slot;
 	ps_list_rem_d(sandbox_to_remove);
+    assert(runqueue_gang.num_sandboxes > 0);
+    runqueue_gang.num_sandboxes--;
+
+    if (ps_list_head_empty(&runqueue_gang.domain_lists[domain]))
+        runqueue_gang.nonempty[domain / 64] &= ~(1ULL << (domain % 64));
 }
 
 struct sandbox *
@@ -43,7 +50,7 @@ local_runqueue_gang_remove_and_return()
 {
     uint32_t domain = runqueue_gang.current_domain;
 	struct sandbox *sandbox_to_remove = ps_list_head_first_d(&runqueue_gang.domain_lists[domain], struct sandbox);
-	ps_list_rem_d(sandbox_to_remove);
+	local_runqueue_gang_remove(sandbox_to_remove);
 	return sandbox_to_remove;
 }
 
@@ -57,13 +64,11 @@ local_runqueue_gang_append(struct sandbox *sandbox_to_append)
 	assert(sandbox_to_append != NULL);
 	assert(ps_list_singleton_d(sandbox_to_append));
 
-    uint32_t domain = sandbox_to_append->module->domain;
-    assert(domain < MAX_DOMAINS);
-    assert(domain < runqueue_gang.num_domains + 1);
+    uint32_t domain = sandbox_to_append->module->domain_slot;
+    assert(domain < gang_domain_count());
 
-    // if its a new domain, increment num_domains...
-    runqueue_gang.num_domains += (domain == runqueue_gang.num_domains);
     ps_list_head_append_d(&runqueue_gang.domain_lists[domain], sandbox_to_append);
+    runqueue_gang.nonempty[domain / 64] |= 1ULL << (domain % 64);
     runqueue_gang.num_sandboxes++;
 }
 
@@ -96,12 +101,40 @@ local_runqueue_gang_get_next()
 }
 
 /**
- * Swap to the next domain
+ * Called on each time slice. Once the current domain has run for its weight in time slices or has run out of work,
+ * swaps to the next domain with sandboxes on this runqueue or requests in the global request scheduler, skipping
+ * empty domains. The current domain is kept if no other domain has work.
  */
 void
 local_runqueue_gang_next_domain()
 {
-    runqueue_gang.current_domain = (runqueue_gang.current_domain + 1) % runqueue_gang.num_domains;
+    uint64_t candidates[GANG_DOMAIN_BITMAP_WORDS];
+    for (uint32_t i = 0; i < GANG_DOMAIN_BITMAP_WORDS; i++) candidates[i] = runqueue_gang.nonempty[i];
+    global_request_scheduler_domain_pending(candidates);
+
+    uint32_t current = runqueue_gang.current_domain;
+    bool has_work = (candidates[current / 64] >> (current % 64)) & 1;
+    if (has_work && runqueue_gang.slices_remaining > 1) {
+        runqueue_gang.slices_remaining--;
+        return;
+    }
+
+    int32_t next = gang_domain_bitmap_next(candidates, runqueue_gang.current_domain);
+    if (next >= 0) runqueue_gang.current_domain = (uint32_t)next;
+
+    runqueue_gang.slices_remaining = gang_domain_count() == 0 ? 0
+                                                                : gang_domain_weight(runqueue_gang.current_domain);
+}
+
+/**
+ * Sets the domain directly, as directed by the gang epoch
+ * @param domain slot of the domain
+ */
+void
+local_runqueue_gang_set_domain(uint32_t domain)
+{
+	assert(domain < MAX_DOMAINS);
+	runqueue_gang.current_domain = domain;
 }
 
 uint32_t
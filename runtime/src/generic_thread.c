@@ -1,24 +1,34 @@
+#include <assert.h>
 #include <stdint.h>
 #include <threads.h>
 
 #include "arch/getcycles.h"
 #include "debuglog.h"
+#include "generic_thread.h"
 
 extern uint32_t runtime_processor_speed_MHz;
 extern uint32_t runtime_quantum_us;
 
 /* Implemented by listener and workers */
 
-thread_local uint64_t generic_thread_lock_duration   = 0;
+thread_local int      generic_thread_idx             = GENERIC_THREAD_OTHER_IDX;
 thread_local uint64_t generic_thread_lock_longest    = 0;
 thread_local uint64_t generic_thread_start_timestamp = 0;
 
+struct generic_thread_stats generic_thread_stats[GENERIC_THREAD_MAX_COUNT] = { 0 };
+
+/**
+ * @param idx the index of the shard of the thread. The worker index for workers, or GENERIC_THREAD_LISTENER_IDX
+ */
 void
-generic_thread_initialize()
+generic_thread_initialize(int idx)
 {
+	assert(idx >= 0 && idx < GENERIC_THREAD_MAX_COUNT);
+
+	generic_thread_idx             = idx;
 	generic_thread_start_timestamp = __getcycles();
 	generic_thread_lock_longest    = 0;
-	generic_thread_lock_duration   = 0;
+	atomic_store(&generic_thread_stats[idx].lock_duration, 0);
 }
 
 /**
@@ -29,9 +39,10 @@ generic_thread_dump_lock_overhead()
 {
 #ifndef NDEBUG
 #ifdef LOG_LOCK_OVERHEAD
-	uint64_t duration = __getcycles() - generic_thread_start_timestamp;
-	debuglog("Locks consumed %lu / %lu cycles, or %f%%\n", generic_thread_lock_duration, duration,
-	         (double)generic_thread_lock_duration / duration * 100);
+	uint64_t duration      = __getcycles() - generic_thread_start_timestamp;
+	uint64_t lock_duration = atomic_load(&generic_thread_stats[generic_thread_idx].lock_duration);
+	debuglog("Locks consumed %lu / %lu cycles, or %f%%\n", lock_duration, duration,
+	         (double)lock_duration / duration * 100);
 	debuglog("Longest Held Lock was %lu cycles, or %f quantums\n", generic_thread_lock_longest,
 	         (double)generic_thread_lock_longest / ((uint64_t)runtime_processor_speed_MHz * runtime_quantum_us));
 #endif
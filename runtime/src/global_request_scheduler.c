@@ -3,6 +3,10 @@
 #include "global_request_scheduler.h"
 #include "panic.h"
 
+enum GLOBAL_QUEUE global_queue = GLOBAL_QUEUE_MINHEAP;
+
+struct global_request_scheduler_stats global_request_scheduler_stats[GENERIC_THREAD_MAX_COUNT] = { 0 };
+
 /* Default uninitialized implementations of the polymorphic interface */
 noreturn static struct sandbox_request *
 uninitialized_add(void *arg)
@@ -48,7 +52,9 @@ struct sandbox_request *
 global_request_scheduler_add(struct sandbox_request *sandbox_request)
 {
 	assert(sandbox_request != NULL);
-	return global_request_scheduler.add_fn(sandbox_request);
+	struct sandbox_request *added = global_request_scheduler.add_fn(sandbox_request);
+	if (added != NULL) generic_thread_counter_add(&global_request_scheduler_stats[generic_thread_idx].added, 1);
+	return added;
 }
 
 /**
@@ -60,7 +66,9 @@ int
 global_request_scheduler_remove(struct sandbox_request **removed_sandbox)
 {
 	assert(removed_sandbox != NULL);
-	return global_request_scheduler.remove_fn(removed_sandbox);
+	int rc = global_request_scheduler.remove_fn(removed_sandbox);
+	if (rc == 0) global_request_scheduler_record_removal(*removed_sandbox);
+	return rc;
 }
 
 /**
@@ -74,7 +82,9 @@ int
 global_request_scheduler_remove_if_earlier(struct sandbox_request **removed_sandbox, uint64_t target_deadline)
 {
 	assert(removed_sandbox != NULL);
-	return global_request_scheduler.remove_if_earlier_fn(removed_sandbox, target_deadline);
+	int rc = global_request_scheduler.remove_if_earlier_fn(removed_sandbox, target_deadline);
+	if (rc == 0) global_request_scheduler_record_removal(*removed_sandbox);
+	return rc;
 }
 
 /**
@@ -86,3 +96,15 @@ global_request_scheduler_peek()
 {
 	return global_request_scheduler.peek_fn();
 }
+
+/**
+ * @returns the number of requests in the scheduler. This is approximate while requests are concurrently added or
+ * removed
+ */
+uint64_t
+global_request_scheduler_depth()
+{
+	uint64_t added   = GENERIC_THREAD_COUNTER_SUM(global_request_scheduler_stats, added);
+	uint64_t removed = GENERIC_THREAD_COUNTER_SUM(global_request_scheduler_stats, removed);
+	return added > removed ? added - removed : 0;
+}
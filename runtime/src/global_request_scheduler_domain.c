@@ -0,0 +1,157 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+
+#include "gang_scheduler.h"
+#include "global_request_scheduler.h"
+#include "global_request_scheduler_domain.h"
+#include "listener_thread.h"
+#include "panic.h"
+#include "runtime.h"
+#include "worker_thread.h"
+
+/* Deques are indexed by domain slot, and are allocated by the listener on the first request of a domain, as each
+ * reserves DEQUE_MAX_SZ entries */
+static _Atomic(struct deque_sandbox *) global_request_scheduler_domain_deques[MAX_DOMAINS];
+
+/* One past the highest domain slot with a deque */
+static _Atomic uint32_t global_request_scheduler_domain_count = 0;
+
+/* Bit per domain slot whose deque may hold requests. Set by the listener after a push and cleared by a worker that
+ * finds the deque empty, so a set bit may be stale, but a non-empty deque always has its bit set */
+static _Atomic uint64_t global_request_scheduler_domain_pending_bitmap[GANG_DOMAIN_BITMAP_WORDS];
+
+/* Domain at which this worker starts its next scan of other domains, so scans do not favor low domains */
+static thread_local uint32_t global_request_scheduler_domain_cursor = 0;
+
+struct global_request_scheduler_domain_stats global_request_scheduler_domain_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+/**
+ * Pushes a sandbox request to the deque of its module's domain
+ * @param sandbox_request
+ * @returns pointer to request if added. NULL otherwise
+ */
+static struct sandbox_request *
+global_request_scheduler_domain_add(void *sandbox_request_raw)
+{
+	struct sandbox_request *sandbox_request = (struct sandbox_request *)sandbox_request_raw;
+	assert(sandbox_request);
+	if (unlikely(!listener_thread_is_running())) panic("%s is only callable by the listener thread\n", __func__);
+
+	uint32_t domain = sandbox_request->module->domain_slot;
+	assert(domain < gang_domain_count());
+
+	struct deque_sandbox *deque = atomic_load(&global_request_scheduler_domain_deques[domain]);
+	if (unlikely(deque == NULL)) {
+		deque = (struct deque_sandbox *)malloc(sizeof(struct deque_sandbox));
+		if (unlikely(deque == NULL)) return NULL;
+		/* Note: Below is a Macro */
+		deque_init_sandbox(deque, RUNTIME_MAX_SANDBOX_REQUEST_COUNT);
+
+		atomic_store(&global_request_scheduler_domain_deques[domain], deque);
+		if (domain >= atomic_load(&global_request_scheduler_domain_count))
+			atomic_store(&global_request_scheduler_domain_count, domain + 1);
+	}
+
+	if (deque_push_sandbox(deque, &sandbox_request) != 0) return NULL;
+	atomic_fetch_or(&global_request_scheduler_domain_pending_bitmap[domain / 64], 1ULL << (domain % 64));
+	return sandbox_request_raw;
+}
+
+/**
+ * Steals a request of a specific domain
+ * @param domain slot of the domain
+ * @param removed_sandbox_request pointer to set to removed sandbox request
+ * @returns 0 if successful, -ENOENT if empty, -EAGAIN if atomic instruction unsuccessful
+ */
+int
+global_request_scheduler_domain_remove_from(uint32_t domain, struct sandbox_request **removed_sandbox_request)
+{
+	assert(domain < MAX_DOMAINS);
+
+	struct deque_sandbox *deque = atomic_load(&global_request_scheduler_domain_deques[domain]);
+	if (deque == NULL) return -ENOENT;
+
+	int rc = deque_steal_sandbox(deque, removed_sandbox_request);
+	if (rc == -ENOENT) {
+		/* Clear the pending bit, then restore it if the listener pushed in the meantime */
+		uint64_t bit = 1ULL << (domain % 64);
+		atomic_fetch_and(&global_request_scheduler_domain_pending_bitmap[domain / 64], ~bit);
+		if (deque->top < deque->bottom)
+			atomic_fetch_or(&global_request_scheduler_domain_pending_bitmap[domain / 64], bit);
+	}
+
+	return rc;
+}
+
+/**
+ * Adds the domain slots that may have requests to a bitmap
+ * @param bitmap
+ */
+void
+global_request_scheduler_domain_pending(uint64_t bitmap[GANG_DOMAIN_BITMAP_WORDS])
+{
+	for (uint32_t i = 0; i < GANG_DOMAIN_BITMAP_WORDS; i++)
+		bitmap[i] |= atomic_load_explicit(&global_request_scheduler_domain_pending_bitmap[i], memory_order_relaxed);
+}
+
+/**
+ * Steals a request of any domain, scanning domain slots from this worker's cursor
+ * @param removed_sandbox_request pointer to set to removed sandbox request
+ * @returns 0 if successful, -ENOENT if every deque is empty or contended
+ */
+static int
+global_request_scheduler_domain_remove(struct sandbox_request **removed_sandbox_request)
+{
+	uint32_t count = atomic_load(&global_request_scheduler_domain_count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t domain = (global_request_scheduler_domain_cursor + i) % count;
+		if (global_request_scheduler_domain_remove_from(domain, removed_sandbox_request) == 0) {
+			global_request_scheduler_domain_cursor = domain + 1;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+static int
+global_request_scheduler_domain_remove_if_earlier(struct sandbox_request **removed_sandbox_request,
+                                                  uint64_t                 target_deadline)
+{
+	panic("Domain variant does not support this call\n");
+	return -1;
+}
+
+void
+global_request_scheduler_domain_stats_print()
+{
+	printf("Global Request Scheduler Domains\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu same domain pulls, %lu cross domain pulls\n", i,
+		       global_request_scheduler_domain_stats[i].same_domain_pulls,
+		       global_request_scheduler_domain_stats[i].cross_domain_pulls);
+	}
+	fflush(stdout);
+}
+
+void
+global_request_scheduler_domain_initialize()
+{
+	for (int i = 0; i < MAX_DOMAINS; i++) atomic_init(&global_request_scheduler_domain_deques[i], NULL);
+	for (int i = 0; i < GANG_DOMAIN_BITMAP_WORDS; i++)
+		atomic_init(&global_request_scheduler_domain_pending_bitmap[i], 0);
+
+	/* Register Function Pointers for Abstract Scheduling API */
+	struct global_request_scheduler_config config = {
+		.add_fn               = global_request_scheduler_domain_add,
+		.remove_fn            = global_request_scheduler_domain_remove,
+		.remove_if_earlier_fn = global_request_scheduler_domain_remove_if_earlier
+	};
+
+	global_request_scheduler_initialize(&config);
+}
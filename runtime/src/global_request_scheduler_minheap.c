@@ -2,6 +2,7 @@
 #include <errno.h>
 
 #include "global_request_scheduler.h"
+#include "global_request_scheduler_minheap.h"
 #include "listener_thread.h"
 #include "panic.h"
 #include "priority_queue.h"
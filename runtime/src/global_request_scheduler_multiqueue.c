@@ -0,0 +1,171 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <threads.h>
+
+#include "arch/getcycles.h"
+#include "global_request_scheduler.h"
+#include "global_request_scheduler_minheap.h"
+#include "global_request_scheduler_multiqueue.h"
+#include "listener_thread.h"
+#include "panic.h"
+#include "priority_queue.h"
+#include "runtime.h"
+
+static struct priority_queue **global_request_scheduler_multiqueue;
+static uint32_t                global_request_scheduler_multiqueue_count;
+
+static thread_local uint64_t global_request_scheduler_multiqueue_random_state = 0;
+
+/* The heap selected by the last peek on this thread, so a following remove_if_earlier targets the peeked head */
+static thread_local int global_request_scheduler_multiqueue_peeked = -1;
+
+/**
+ * xorshift64 generator, seeded per thread on first use
+ * @returns index of a heap chosen uniformly at random
+ */
+static inline uint32_t
+global_request_scheduler_multiqueue_random_index(void)
+{
+	uint64_t x = global_request_scheduler_multiqueue_random_state;
+	if (unlikely(x == 0)) x = __getcycles() | 1;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	global_request_scheduler_multiqueue_random_state = x;
+	return x % global_request_scheduler_multiqueue_count;
+}
+
+/**
+ * Samples two heaps without locking them
+ * @returns the index of the sampled heap with the earlier head
+ */
+static inline uint32_t
+global_request_scheduler_multiqueue_choose(void)
+{
+	uint32_t first  = global_request_scheduler_multiqueue_random_index();
+	uint32_t second = global_request_scheduler_multiqueue_random_index();
+
+	return priority_queue_peek(global_request_scheduler_multiqueue[first])
+	           <= priority_queue_peek(global_request_scheduler_multiqueue[second])
+	         ? first
+	         : second;
+}
+
+/**
+ * Scans the heads of all heaps without locking them. Used when sampling only found empty heaps, so that a lightly
+ * loaded system does not strand a request
+ * @returns the index of the heap with the earliest head
+ */
+static inline uint32_t
+global_request_scheduler_multiqueue_scan(void)
+{
+	uint32_t earliest = 0;
+	for (uint32_t i = 1; i < global_request_scheduler_multiqueue_count; i++) {
+		if (priority_queue_peek(global_request_scheduler_multiqueue[i])
+		    < priority_queue_peek(global_request_scheduler_multiqueue[earliest]))
+			earliest = i;
+	}
+	return earliest;
+}
+
+/**
+ * Pushes a sandbox request to a random heap, trying others if it is full
+ * @param sandbox_request
+ * @returns pointer to request if added. NULL otherwise
+ */
+static struct sandbox_request *
+global_request_scheduler_multiqueue_add(void *sandbox_request)
+{
+	assert(sandbox_request);
+	if (unlikely(!listener_thread_is_running())) panic("%s is only callable by the listener thread\n", __func__);
+
+	uint32_t index = global_request_scheduler_multiqueue_random_index();
+	for (uint32_t i = 0; i < global_request_scheduler_multiqueue_count; i++) {
+		struct priority_queue *queue =
+		  global_request_scheduler_multiqueue[(index + i) % global_request_scheduler_multiqueue_count];
+		if (priority_queue_enqueue(queue, sandbox_request) == 0) return sandbox_request;
+	}
+
+	/* TODO: Propagate -1 to caller. Issue #91 */
+	panic("Request Queue is full\n");
+}
+
+/**
+ * @param removed_sandbox_request pointer to set to removed sandbox request
+ * @param target_deadline the deadline that the request must be earlier than to dequeue
+ * @returns 0 if successful, -ENOENT if the chosen heap is empty or its head isn't earlier than target_deadline
+ */
+static int
+global_request_scheduler_multiqueue_remove_if_earlier(struct sandbox_request **removed_sandbox_request,
+                                                      uint64_t                 target_deadline)
+{
+	int index = global_request_scheduler_multiqueue_peeked;
+	if (index < 0) index = global_request_scheduler_multiqueue_choose();
+	global_request_scheduler_multiqueue_peeked = -1;
+
+	struct priority_queue *queue = global_request_scheduler_multiqueue[index];
+	if (priority_queue_peek(queue) >= target_deadline) return -ENOENT;
+
+	return priority_queue_dequeue_if_earlier(queue, (void **)removed_sandbox_request, target_deadline);
+}
+
+/**
+ * @param removed_sandbox_request pointer to set to removed sandbox request
+ * @returns 0 if successful, -ENOENT if empty
+ */
+static int
+global_request_scheduler_multiqueue_remove(struct sandbox_request **removed_sandbox_request)
+{
+	global_request_scheduler_multiqueue_peeked = -1;
+
+	uint32_t index = global_request_scheduler_multiqueue_choose();
+	if (priority_queue_peek(global_request_scheduler_multiqueue[index]) == ULONG_MAX)
+		index = global_request_scheduler_multiqueue_scan();
+
+	return priority_queue_dequeue(global_request_scheduler_multiqueue[index], (void **)removed_sandbox_request);
+}
+
+/**
+ * Peeks at the earlier head of two sampled heaps, falling back to a scan of all heads if both are empty
+ * @returns the deadline of the request at the head of the selected heap or ULONG_MAX if empty
+ */
+static uint64_t
+global_request_scheduler_multiqueue_peek(void)
+{
+	uint32_t index = global_request_scheduler_multiqueue_choose();
+	if (priority_queue_peek(global_request_scheduler_multiqueue[index]) == ULONG_MAX)
+		index = global_request_scheduler_multiqueue_scan();
+
+	global_request_scheduler_multiqueue_peeked = index;
+	return priority_queue_peek(global_request_scheduler_multiqueue[index]);
+}
+
+/**
+ * Initializes the variant and registers against the polymorphic interface
+ * Assumption: runtime_worker_threads_count is configured
+ */
+void
+global_request_scheduler_multiqueue_initialize()
+{
+	global_request_scheduler_multiqueue_count = GLOBAL_REQUEST_SCHEDULER_MULTIQUEUE_FACTOR
+	                                            * runtime_worker_threads_count;
+	global_request_scheduler_multiqueue = calloc(global_request_scheduler_multiqueue_count,
+	                                             sizeof(struct priority_queue *));
+	assert(global_request_scheduler_multiqueue);
+
+	for (uint32_t i = 0; i < global_request_scheduler_multiqueue_count; i++) {
+		global_request_scheduler_multiqueue[i] =
+		  priority_queue_initialize(GLOBAL_REQUEST_SCHEDULER_MULTIQUEUE_CAPACITY, true,
+		                            sandbox_request_get_priority_fn);
+	}
+
+	struct global_request_scheduler_config config = {
+		.add_fn               = global_request_scheduler_multiqueue_add,
+		.remove_fn            = global_request_scheduler_multiqueue_remove,
+		.remove_if_earlier_fn = global_request_scheduler_multiqueue_remove_if_earlier,
+		.peek_fn              = global_request_scheduler_multiqueue_peek
+	};
+
+	global_request_scheduler_initialize(&config);
+}
@@ -180,6 +180,14 @@ http_parser_settings_on_body(http_parser *parser, const char *at, size_t length)
 	assert(sandbox->http_request.header_end);
 	assert(!sandbox->http_request.message_end);
 
+	/* Bytes of a streamed body follow their position in the bytes received, so they are compacted in place */
+	if (sandbox->request_stream.base != NULL) {
+		struct sandbox_request_stream *stream = &sandbox->request_stream;
+		assert(stream->length + length <= stream->capacity);
+		memmove(&stream->base[stream->length], at, length);
+		stream->length += length;
+		return 0;
+	}
 
 	/* Assumption: We should never exceed the buffer we're reusing */
 	assert(http_request->body_length + length <= sandbox->module->max_request_size);
@@ -4,32 +4,20 @@
 #include "http_total.h"
 
 /* 2XX + 4XX should equal sandboxes */
-/* Listener Core Bookkeeping */
-_Atomic uint32_t http_total_requests = 0;
-_Atomic uint32_t http_total_5XX      = 0;
-
-#ifdef LOG_TOTAL_REQS_RESPS
-_Atomic uint32_t http_total_2XX = 0;
-_Atomic uint32_t http_total_4XX = 0;
-#endif
+struct http_total http_totals[GENERIC_THREAD_MAX_COUNT] = { 0 };
 
 /* Primarily intended to be called via GDB */
 void
 http_total_log()
 {
-	uint32_t total_reqs = atomic_load(&http_total_requests);
-	uint32_t total_5XX  = atomic_load(&http_total_5XX);
-
-#ifdef LOG_TOTAL_REQS_RESPS
-	uint32_t total_2XX = atomic_load(&http_total_2XX);
-	uint32_t total_4XX = atomic_load(&http_total_4XX);
+	uint64_t total_reqs = GENERIC_THREAD_COUNTER_SUM(http_totals, requests);
+	uint64_t total_2XX  = GENERIC_THREAD_COUNTER_SUM(http_totals, responses_2XX);
+	uint64_t total_4XX  = GENERIC_THREAD_COUNTER_SUM(http_totals, responses_4XX);
+	uint64_t total_5XX  = GENERIC_THREAD_COUNTER_SUM(http_totals, responses_5XX);
 
-	int64_t total_responses      = total_2XX + total_4XX + total_5XX;
-	int64_t outstanding_requests = (int64_t)total_reqs - total_responses;
+	uint64_t total_responses      = total_2XX + total_4XX + total_5XX;
+	int64_t  outstanding_requests = (int64_t)total_reqs - (int64_t)total_responses;
 
-	debuglog("Requests: %u (%ld outstanding)\n\tResponses: %ld\n\t\t2XX: %u\n\t\t4XX: %u\n\t\t5XX: %u\n",
+	debuglog("Requests: %lu (%ld outstanding)\n\tResponses: %lu\n\t\t2XX: %lu\n\t\t4XX: %lu\n\t\t5XX: %lu\n",
 	         total_reqs, outstanding_requests, total_responses, total_2XX, total_4XX, total_5XX);
-#else
-	debuglog("Requests: %u\n\tResponses:\n\t\t\t5XX: %u\n", total_reqs, total_5XX);
-#endif
 };
@@ -0,0 +1,96 @@
+#include <assert.h>
+#include <string.h>
+
+#include "io_engine.h"
+
+enum IO_ENGINE io_engine = IO_ENGINE_EPOLL;
+
+static struct io_engine_config io_engine_config;
+
+/* Initializes a concrete implementation of the I/O engine interface */
+void
+io_engine_initialize(struct io_engine_config *config)
+{
+	memcpy(&io_engine_config, config, sizeof(struct io_engine_config));
+}
+
+/**
+ * Initializes the engine state of the calling worker thread
+ */
+void
+io_engine_thread_initialize(void)
+{
+	assert(io_engine_config.thread_initialize_fn != NULL);
+	io_engine_config.thread_initialize_fn();
+}
+
+/**
+ * Prepares a sandbox's client socket for I/O
+ * @param sandbox
+ */
+void
+io_engine_open(struct sandbox *sandbox)
+{
+	assert(io_engine_config.open_fn != NULL);
+	io_engine_config.open_fn(sandbox);
+}
+
+/**
+ * Receives from a sandbox's client socket, sleeping the sandbox until data is available
+ * @param sandbox the current sandbox
+ * @param buffer
+ * @param length
+ * @returns bytes received, 0 on EOF, or -1 on error with errno set
+ */
+ssize_t
+io_engine_recv(struct sandbox *sandbox, void *buffer, size_t length)
+{
+	assert(io_engine_config.recv_fn != NULL);
+	return io_engine_config.recv_fn(sandbox, buffer, length);
+}
+
+/**
+ * Sends an entire buffer to a sandbox's client socket, sleeping the sandbox while the socket is full
+ * @param sandbox the current sandbox
+ * @param buffer
+ * @param length
+ * @returns bytes sent or -1 on error with errno set
+ */
+ssize_t
+io_engine_send(struct sandbox *sandbox, const void *buffer, size_t length)
+{
+	assert(io_engine_config.send_fn != NULL);
+	return io_engine_config.send_fn(sandbox, buffer, length);
+}
+
+/**
+ * Closes a sandbox's client socket
+ * @param sandbox
+ */
+void
+io_engine_close(struct sandbox *sandbox)
+{
+	assert(io_engine_config.close_fn != NULL);
+	io_engine_config.close_fn(sandbox);
+}
+
+/**
+ * Detaches a sandbox from its client socket without closing it, so the connection can outlive the sandbox
+ * @param sandbox
+ */
+void
+io_engine_release(struct sandbox *sandbox)
+{
+	assert(io_engine_config.release_fn != NULL);
+	io_engine_config.release_fn(sandbox);
+}
+
+/**
+ * Processes completed I/O on the calling worker, waking sandboxes whose I/O completed
+ */
+void
+io_engine_poll(void)
+{
+	assert(io_engine_config.poll_fn != NULL);
+	io_engine_config.poll_fn();
+}
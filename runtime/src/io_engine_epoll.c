@@ -0,0 +1,95 @@
+#include <assert.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "client_socket.h"
+#include "current_sandbox.h"
+#include "io_engine.h"
+#include "panic.h"
+#include "scheduler_execute_epoll_loop.h"
+#include "worker_thread.h"
+
+/*
+ * I/O engine using non-blocking sockets registered on the worker's epoll instance. A sandbox that would block sleeps
+ * until scheduler_execute_epoll_loop observes its socket become ready
+ */
+
+static void
+io_engine_epoll_thread_initialize(void)
+{
+	/* The worker epoll instance is created by worker_thread_main */
+	assert(worker_thread_epoll_file_descriptor >= 0);
+}
+
+static void
+io_engine_epoll_open(struct sandbox *sandbox)
+{
+	/* Freshly allocated sandbox going runnable for first time, so register client socket with epoll */
+	struct epoll_event accept_evt;
+	accept_evt.data.ptr = (void *)sandbox;
+	accept_evt.events   = EPOLLIN | EPOLLOUT | EPOLLET;
+	int rc = epoll_ctl(worker_thread_epoll_file_descriptor, EPOLL_CTL_ADD, sandbox->client_socket_descriptor,
+	                   &accept_evt);
+	if (unlikely(rc < 0)) panic_err();
+}
+
+static ssize_t
+io_engine_epoll_recv(struct sandbox *sandbox, void *buffer, size_t length)
+{
+	while (true) {
+		ssize_t bytes_received = recv(sandbox->client_socket_descriptor, buffer, length, 0);
+		if (bytes_received >= 0 || errno != EAGAIN) return bytes_received;
+
+		current_sandbox_sleep();
+	}
+}
+
+static ssize_t
+io_engine_epoll_send(struct sandbox *sandbox, const void *buffer, size_t length)
+{
+	size_t sent = 0;
+	while (sent < length) {
+		ssize_t rc = write(sandbox->client_socket_descriptor, (const char *)buffer + sent, length - sent);
+		if (rc < 0) {
+			if (errno != EAGAIN) return -1;
+
+			current_sandbox_sleep();
+			continue;
+		}
+		sent += rc;
+	}
+
+	return sent;
+}
+
+static void
+io_engine_epoll_release(struct sandbox *sandbox)
+{
+	int rc = epoll_ctl(worker_thread_epoll_file_descriptor, EPOLL_CTL_DEL, sandbox->client_socket_descriptor, NULL);
+	if (unlikely(rc < 0)) panic_err();
+}
+
+static void
+io_engine_epoll_close(struct sandbox *sandbox)
+{
+	io_engine_epoll_release(sandbox);
+	client_socket_close(sandbox->client_socket_descriptor, &sandbox->client_address);
+}
+
+void
+io_engine_epoll_initialize(void)
+{
+	struct io_engine_config config = {
+		.thread_initialize_fn = io_engine_epoll_thread_initialize,
+		.open_fn              = io_engine_epoll_open,
+		.recv_fn              = io_engine_epoll_recv,
+		.send_fn              = io_engine_epoll_send,
+		.close_fn             = io_engine_epoll_close,
+		.release_fn           = io_engine_epoll_release,
+		.poll_fn              = scheduler_execute_epoll_loop,
+	};
+
+	io_engine_initialize(&config);
+}
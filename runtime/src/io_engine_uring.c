@@ -0,0 +1,208 @@
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "client_socket.h"
+#include "current_sandbox.h"
+#include "io_engine.h"
+#include "panic.h"
+#include "sandbox_set_as_runnable.h"
+#include "uring.h"
+
+/*
+ * I/O engine using a per-worker io_uring instance. A sandbox prepares an operation, submits it, and sleeps until
+ * io_engine_uring_poll reaps its completion from the completion queue, which does not require a system call.
+ * Receives complete directly into the sandbox request buffer, and the response send is linked with the close of
+ * the client socket, so both are submitted with a single system call.
+ */
+
+#define IO_ENGINE_URING_ENTRIES 256
+
+/* struct sandbox is page-aligned, so the low bits of user_data are free to tag the operation */
+#define IO_ENGINE_URING_TAG_CLOSE 1UL
+#define IO_ENGINE_URING_TAG_MASK  1UL
+
+static thread_local struct uring io_engine_uring_ring;
+
+static void
+io_engine_uring_thread_initialize(void)
+{
+	/* Avoid interrupting a worker running a sandbox to post completions. Task work runs on the next poll */
+	unsigned flags = IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG | IORING_SETUP_SINGLE_ISSUER;
+
+	int rc = uring_initialize(&io_engine_uring_ring, IO_ENGINE_URING_ENTRIES, flags);
+	/* Kernels older than 6.0 reject these setup flags */
+	if (rc < 0 && errno == EINVAL) rc = uring_initialize(&io_engine_uring_ring, IO_ENGINE_URING_ENTRIES, 0);
+	if (unlikely(rc < 0)) panic("io_uring setup failed: %s\n", strerror(errno));
+}
+
+/**
+ * Reserves count contiguous submission queue entries, submitting outstanding entries to make room if needed
+ * @returns the first entry
+ */
+static inline struct io_uring_sqe *
+io_engine_uring_get_sqe(unsigned count)
+{
+	if (uring_sq_space_left(&io_engine_uring_ring) < count) {
+		if (unlikely(uring_submit(&io_engine_uring_ring, 0) < 0)) panic_err();
+	}
+
+	struct io_uring_sqe *sqe = uring_get_sqe(&io_engine_uring_ring);
+	assert(sqe != NULL);
+	return sqe;
+}
+
+/**
+ * Records the results of completed operations and wakes sandboxes with no outstanding operations
+ */
+static inline void
+io_engine_uring_reap(void)
+{
+	struct io_uring_cqe *cqe;
+	while ((cqe = uring_peek_cqe(&io_engine_uring_ring)) != NULL) {
+		uint64_t user_data = cqe->user_data;
+		int32_t  result    = cqe->res;
+		uring_cqe_seen(&io_engine_uring_ring);
+
+		struct sandbox *sandbox = (struct sandbox *)(user_data & ~IO_ENGINE_URING_TAG_MASK);
+		assert(sandbox != NULL);
+
+		if (user_data & IO_ENGINE_URING_TAG_CLOSE) {
+			/* A linked close is cancelled if the send before it failed or was short */
+			if (result == -ECANCELED)
+				client_socket_close(sandbox->client_socket_descriptor, &sandbox->client_address);
+		} else {
+			sandbox->io_result = result;
+		}
+
+		assert(sandbox->io_pending > 0);
+		if (--sandbox->io_pending == 0 && sandbox->state == SANDBOX_ASLEEP) sandbox_wakeup(sandbox);
+	}
+}
+
+/**
+ * Submits prepared operations and sleeps the current sandbox until all of its operations complete
+ * Operations that complete inline during submission are reaped immediately without sleeping
+ */
+static inline ssize_t
+io_engine_uring_wait(struct sandbox *sandbox)
+{
+	if (unlikely(uring_submit(&io_engine_uring_ring, 0) < 0)) panic_err();
+	io_engine_uring_reap();
+
+	while (sandbox->io_pending > 0) current_sandbox_sleep();
+
+	if (sandbox->io_result < 0) {
+		errno = -sandbox->io_result;
+		return -1;
+	}
+	return sandbox->io_result;
+}
+
+static void
+io_engine_uring_open(struct sandbox *sandbox)
+{
+	/* Sockets do not need to be registered */
+	sandbox->io_pending = 0;
+}
+
+static ssize_t
+io_engine_uring_recv(struct sandbox *sandbox, void *buffer, size_t length)
+{
+	struct io_uring_sqe *sqe = io_engine_uring_get_sqe(1);
+	sqe->opcode              = IORING_OP_RECV;
+	sqe->fd                  = sandbox->client_socket_descriptor;
+	sqe->addr                = (uint64_t)buffer;
+	sqe->len                 = length;
+	sqe->user_data           = (uint64_t)sandbox;
+	sandbox->io_pending++;
+
+	return io_engine_uring_wait(sandbox);
+}
+
+/**
+ * Sends the response. Unless the connection is kept alive, the send is linked with a close of the client socket
+ */
+static ssize_t
+io_engine_uring_send(struct sandbox *sandbox, const void *buffer, size_t length)
+{
+	struct io_uring_sqe *send = io_engine_uring_get_sqe(2);
+	send->opcode              = IORING_OP_SEND;
+	send->fd                  = sandbox->client_socket_descriptor;
+	send->addr                = (uint64_t)buffer;
+	send->len                 = length;
+	send->msg_flags           = MSG_WAITALL | MSG_NOSIGNAL;
+	send->user_data           = (uint64_t)sandbox;
+	sandbox->io_pending++;
+
+	ssize_t rc;
+	if (sandbox->keep_alive) {
+		rc = io_engine_uring_wait(sandbox);
+		goto done;
+	}
+
+	send->flags = IOSQE_IO_LINK;
+
+	struct io_uring_sqe *close = io_engine_uring_get_sqe(1);
+	close->opcode              = IORING_OP_CLOSE;
+	close->fd                  = sandbox->client_socket_descriptor;
+	close->user_data           = (uint64_t)sandbox | IO_ENGINE_URING_TAG_CLOSE;
+	sandbox->io_pending++;
+
+	rc = io_engine_uring_wait(sandbox);
+
+	/* The socket was closed by the linked close, or by the reaper if the close was cancelled */
+	sandbox->client_socket_descriptor = -1;
+
+done:
+	if (rc >= 0 && rc < length) {
+		errno = EPIPE;
+		rc    = -1;
+	}
+	return rc;
+}
+
+static void
+io_engine_uring_close(struct sandbox *sandbox)
+{
+	/* Already closed if the response was sent */
+	if (sandbox->client_socket_descriptor < 0) return;
+
+	client_socket_close(sandbox->client_socket_descriptor, &sandbox->client_address);
+	sandbox->client_socket_descriptor = -1;
+}
+
+static void
+io_engine_uring_release(struct sandbox *sandbox)
+{
+	/* Sockets are not registered, and all operations on them completed before the sandbox could finish */
+	assert(sandbox->io_pending == 0);
+}
+
+static void
+io_engine_uring_poll(void)
+{
+	if (uring_needs_enter(&io_engine_uring_ring)) {
+		if (unlikely(uring_submit(&io_engine_uring_ring, 0) < 0)) panic_err();
+	}
+	io_engine_uring_reap();
+}
+
+void
+io_engine_uring_initialize(void)
+{
+	struct io_engine_config config = {
+		.thread_initialize_fn = io_engine_uring_thread_initialize,
+		.open_fn              = io_engine_uring_open,
+		.recv_fn              = io_engine_uring_recv,
+		.send_fn              = io_engine_uring_send,
+		.close_fn             = io_engine_uring_close,
+		.release_fn           = io_engine_uring_release,
+		.poll_fn              = io_engine_uring_poll,
+	};
+
+	io_engine_initialize(&config);
+}
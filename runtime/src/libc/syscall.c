@@ -13,6 +13,9 @@
 #include "current_sandbox.h"
 #include "scheduler.h"
 #include "sandbox_functions.h"
+#include "sandbox_receive_request.h"
+#include "sandbox_set_as_running_sys.h"
+#include "sandbox_set_as_running_user.h"
 #include "worker_thread.h"
 
 // What should we tell the child program its UID and GID are?
@@ -76,6 +79,35 @@ stub_init(int32_t offset)
 
 // Emulated syscall implementations
 
+/**
+ * Copies body bytes received after the headers of a request whose module streams request bodies. Once those received
+ * are consumed, blocks the sandbox until the client sends more
+ * @param sandbox the current sandbox
+ * @param buffer in linear memory
+ * @param nbyte number of bytes to read
+ * @returns bytes read, 0 at the end of the body, or -EIO if the body could not be received
+ */
+static inline int32_t
+wasm_read_request_stream(struct sandbox *sandbox, char *buffer, int32_t nbyte)
+{
+	struct sandbox_request_stream *stream = &sandbox->request_stream;
+	if (stream->base == NULL) return 0;
+
+	if (stream->length == 0 && !sandbox->http_request.message_end) {
+		/* Receiving may sleep, which is only possible from the running sys state */
+		sandbox_interrupt(sandbox);
+		int rc = sandbox_receive_request_stream(sandbox);
+		sandbox_return(sandbox);
+		if (rc < 0) return -EIO;
+	}
+
+	int32_t bytes_to_read = (size_t)nbyte > stream->length ? stream->length : nbyte;
+	memcpy(buffer, &stream->base[stream->read], bytes_to_read);
+	stream->read += bytes_to_read;
+	stream->length -= bytes_to_read;
+	return bytes_to_read;
+}
+
 // We define our own syscall numbers, because WASM uses x86_64 values even on systems that are not x86_64
 #define SYS_READ 0
 
@@ -90,11 +122,11 @@ wasm_read(int32_t filedes, int32_t buf_offset, int32_t nbyte)
 {
 	struct sandbox *current_sandbox = current_sandbox_get();
 
-	/* Non-blocking copy on stdin */
+	/* Copy the request body on stdin */
 	if (filedes == 0) {
 		char *               buffer          = worker_thread_get_memory_ptr_void(buf_offset, nbyte);
 		struct http_request *current_request = &current_sandbox->http_request;
-		if (current_request->body_length <= 0) return 0;
+		if (current_request->body_length <= 0) return wasm_read_request_stream(current_sandbox, buffer, nbyte);
 		int bytes_to_read = nbyte > current_request->body_length ? current_request->body_length : nbyte;
 		memcpy(buffer, current_request->body + current_request->body_read_length, bytes_to_read);
 		current_request->body_read_length += bytes_to_read;
@@ -220,7 +252,7 @@ wasm_mmap(int32_t addr, int32_t len, int32_t prot, int32_t flags, int32_t fd, in
 	assert(len % WASM_PAGE_SIZE == 0);
 
 	int32_t result = local_sandbox_context_cache.memory.size;
-	for (int i = 0; i < len / WASM_PAGE_SIZE; i++) { expand_memory(); }
+	expand_memory_pages(len / WASM_PAGE_SIZE);
 
 	return result;
 }
@@ -322,7 +354,7 @@ wasm_mremap(int32_t offset, int32_t old_size, int32_t new_size, int32_t flags)
 		int32_t amount_to_expand  = new_size - old_size;
 		int32_t pages_to_allocate = amount_to_expand / WASM_PAGE_SIZE;
 		if (amount_to_expand % WASM_PAGE_SIZE > 0) pages_to_allocate++;
-		for (int i = 0; i < pages_to_allocate; i++) expand_memory();
+		expand_memory_pages(pages_to_allocate);
 
 		return offset;
 	}
@@ -331,7 +363,7 @@ wasm_mremap(int32_t offset, int32_t old_size, int32_t new_size, int32_t flags)
 	int32_t pages_to_allocate = new_size / WASM_PAGE_SIZE;
 	if (new_size % WASM_PAGE_SIZE > 0) pages_to_allocate++;
 	int32_t new_offset = local_sandbox_context_cache.memory.size;
-	for (int i = 0; i < pages_to_allocate; i++) expand_memory();
+	expand_memory_pages(pages_to_allocate);
 
 	// Get pointer of old offset and pointer of new offset
 	char *linear_mem = local_sandbox_context_cache.memory.start;
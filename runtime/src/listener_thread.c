@@ -1,3 +1,4 @@
+#include <pthread.h>
 #include <stdint.h>
 #include <unistd.h>
 
@@ -5,8 +6,13 @@
 #include "client_socket.h"
 #include "global_request_scheduler.h"
 #include "generic_thread.h"
+#include "io_engine.h"
 #include "listener_thread.h"
 #include "runtime.h"
+#include "software_interrupt.h"
+#include "uring.h"
+
+#define LISTENER_THREAD_URING_ENTRIES 64
 
 /*
  * Descriptor of the epoll instance used to monitor the socket descriptors of registered
@@ -14,6 +20,14 @@
  */
 int listener_thread_epoll_file_descriptor;
 
+/*
+ * When the io_uring I/O engine is selected, the listener instead holds a multishot accept on the socket of each
+ * registered module, so a single completion is posted per client without a readiness notification or accept4 call.
+ * Modules are registered from the main thread, so preparing and submitting entries is serialized by the lock
+ */
+static struct uring    listener_thread_uring;
+static pthread_mutex_t listener_thread_uring_lock = PTHREAD_MUTEX_INITIALIZER;
+
 pthread_t listener_thread_id;
 
 /**
@@ -33,6 +47,11 @@ listener_thread_initialize(void)
 	printf("~~~~~~~~~~~~~~~Listener FD: %p \n", &listener_thread_epoll_file_descriptor);
 	assert(listener_thread_epoll_file_descriptor >= 0);
 
+	if (io_engine == IO_ENGINE_URING) {
+		if (unlikely(uring_initialize(&listener_thread_uring, LISTENER_THREAD_URING_ENTRIES, 0) < 0))
+			panic("io_uring setup failed: %s\n", strerror(errno));
+	}
+
 	int ret = pthread_create(&listener_thread_id, NULL, listener_thread_main, NULL);
 	assert(ret == 0);
 	ret = pthread_setaffinity_np(listener_thread_id, sizeof(cpu_set_t), &cs);
@@ -44,7 +63,38 @@ listener_thread_initialize(void)
 }
 
 /**
- * @brief Registers a serverless module on the listener thread's epoll descriptor
+ * Submits a multishot accept on the socket of a module. Completions carry the module as user data
+ * @param mod
+ * @returns 0 on success, -1 on error with errno set
+ */
+static inline int
+listener_thread_uring_accept(struct module *mod)
+{
+	pthread_mutex_lock(&listener_thread_uring_lock);
+
+	int                  rc  = -1;
+	struct io_uring_sqe *sqe = uring_get_sqe(&listener_thread_uring);
+	if (unlikely(sqe == NULL)) {
+		errno = EBUSY;
+		goto done;
+	}
+
+	sqe->opcode       = IORING_OP_ACCEPT;
+	sqe->fd           = mod->socket_descriptor;
+	sqe->ioprio       = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_NONBLOCK;
+	sqe->user_data    = (uint64_t)mod;
+
+	rc = uring_submit(&listener_thread_uring, 0) < 0 ? -1 : 0;
+
+done:
+	pthread_mutex_unlock(&listener_thread_uring_lock);
+	return rc;
+}
+
+/**
+ * @brief Registers a serverless module on the listener thread's epoll descriptor, or with a multishot accept when
+ * the io_uring I/O engine is selected
  **/
 int
 listener_thread_register_module(struct module *mod)
@@ -54,6 +104,8 @@ listener_thread_register_module(struct module *mod)
 		panic("Attempting to register a module before listener thread initialization");
 	}
 
+	if (io_engine == IO_ENGINE_URING) return listener_thread_uring_accept(mod);
+
 	int                rc = 0;
 	struct epoll_event accept_evt;
 	accept_evt.data.ptr = (void *)mod;
@@ -63,6 +115,90 @@ listener_thread_register_module(struct module *mod)
 	return rc;
 }
 
+/**
+ * Performs admissions control on an accepted client and hands admitted work to the global request scheduler
+ * @param module the module the client connected to
+ * @param client_socket nonblocking client socket
+ * @param client_address
+ * @param request_arrival_timestamp
+ */
+static inline void
+listener_thread_dispatch(struct module *module, int client_socket, struct sockaddr_in *client_address,
+                         uint64_t request_arrival_timestamp)
+{
+	/* We should never have accepted on fd 0, 1, or 2 */
+	assert(client_socket != STDIN_FILENO);
+	assert(client_socket != STDOUT_FILENO);
+	assert(client_socket != STDERR_FILENO);
+
+	http_total_increment_request();
+
+	/*
+	 * Perform admissions control.
+	 * If 0, workload was rejected, so close with 503 and continue
+	 */
+	uint64_t work_admitted = admissions_control_decide(module->admissions_info.estimate);
+	if (work_admitted == 0) {
+		client_socket_send(client_socket, 503);
+		if (unlikely(close(client_socket) < 0)) debuglog("Error closing client socket - %s", strerror(errno));
+
+		return;
+	}
+
+	/* Allocate a Sandbox Request */
+	struct sandbox_request *sandbox_request = sandbox_request_allocate(module, client_socket,
+	                                                                   (const struct sockaddr *)client_address,
+	                                                                   request_arrival_timestamp, work_admitted);
+
+	/* Add to the Global Sandbox Request Scheduler */
+	global_request_scheduler_add(sandbox_request);
+
+	/* Tickless workers are not periodically interrupted, so preempt one if the request should run now */
+	if (runtime_sigalrm_timer == RUNTIME_SIGALRM_TIMER_TICKLESS)
+		software_interrupt_tickless_notify(sandbox_request->absolute_deadline);
+}
+
+/**
+ * Execution loop of the listener core when the io_uring I/O engine is selected. Reaps multishot accept completions
+ * Does not return
+ */
+static void
+listener_thread_uring_main(void)
+{
+	/* Multishot accept does not return the client address */
+	struct sockaddr_in client_address = { 0 };
+
+	while (true) {
+		if (unlikely(uring_wait(&listener_thread_uring, 1) < 0)) {
+			if (errno == EINTR) continue;
+
+			panic("io_uring_enter: %s", strerror(errno));
+		}
+
+		uint64_t             request_arrival_timestamp = __getcycles();
+		struct io_uring_cqe *cqe;
+		while ((cqe = uring_peek_cqe(&listener_thread_uring)) != NULL) {
+			struct module *module        = (struct module *)cqe->user_data;
+			int            client_socket = cqe->res;
+			bool           is_armed      = cqe->flags & IORING_CQE_F_MORE;
+			uring_cqe_seen(&listener_thread_uring);
+			assert(module);
+
+			if (client_socket >= 0) {
+				listener_thread_dispatch(module, client_socket, &client_address,
+				                         request_arrival_timestamp);
+			} else if (client_socket != -EAGAIN && client_socket != -EINTR) {
+				debuglog("accept: %s", strerror(-client_socket));
+			}
+
+			/* The kernel terminates a multishot accept on error or CQ overflow, so rearm it */
+			if (!is_armed && unlikely(listener_thread_uring_accept(module) < 0))
+				panic("Failed to rearm accept for %s: %s\n", module->name, strerror(errno));
+		}
+		generic_thread_dump_lock_overhead();
+	}
+}
+
 /**
  * @brief Execution Loop of the listener core, io_handles HTTP requests, allocates sandbox request objects, and
  * pushes the sandbox object to the global dequeue
@@ -78,12 +214,14 @@ listener_thread_main(void *dummy)
 {
 	struct epoll_event epoll_events[RUNTIME_MAX_EPOLL_EVENTS];
 
-	generic_thread_initialize();
+	generic_thread_initialize(GENERIC_THREAD_LISTENER_IDX);
 
 	/* Set my priority */
 	// runtime_set_pthread_prio(pthread_self(), 2);
 	pthread_setschedprio(pthread_self(), -20);
 
+	if (io_engine == IO_ENGINE_URING) listener_thread_uring_main();
+
 	while (true) {
 		/*
 		 * Block indefinitely on the epoll file descriptor, waiting on up to a max number of events
@@ -146,11 +284,6 @@ listener_thread_main(void *dummy)
 					panic("accept4: %s", strerror(errno));
 				}
 
-				/* We should never have accepted on fd 0, 1, or 2 */
-				assert(client_socket != STDIN_FILENO);
-				assert(client_socket != STDOUT_FILENO);
-				assert(client_socket != STDERR_FILENO);
-
 				/*
 				 * According to accept(2), it is possible that the the sockaddr structure
 				 * client_address may be too small, resulting in data being truncated to fit.
@@ -161,30 +294,8 @@ listener_thread_main(void *dummy)
 					         module->name);
 				}
 
-				http_total_increment_request();
-
-				/*
-				 * Perform admissions control.
-				 * If 0, workload was rejected, so close with 503 and continue
-				 */
-				uint64_t work_admitted = admissions_control_decide(module->admissions_info.estimate);
-				if (work_admitted == 0) {
-					client_socket_send(client_socket, 503);
-					if (unlikely(close(client_socket) < 0))
-						debuglog("Error closing client socket - %s", strerror(errno));
-
-					continue;
-				}
-
-				/* Allocate a Sandbox Request */
-				struct sandbox_request *sandbox_request =
-				  sandbox_request_allocate(module, client_socket,
-				                           (const struct sockaddr *)&client_address,
-				                           request_arrival_timestamp, work_admitted);
-
-				/* Add to the Global Sandbox Request Scheduler */
-				global_request_scheduler_add(sandbox_request);
-
+				listener_thread_dispatch(module, client_socket, &client_address,
+				                         request_arrival_timestamp);
 			} /* while true */
 		}         /* for loop */
 		generic_thread_dump_lock_overhead();
@@ -5,9 +5,12 @@
 #include <threads.h>
 
 #include "local_runqueue.h"
+#include "worker_thread.h"
 
 static struct local_runqueue_config local_runqueue;
 
+struct local_runqueue_length local_runqueue_lengths[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
 #ifdef LOG_LOCAL_RUNQUEUE
 thread_local uint32_t local_runqueue_count = 0;
 #endif
@@ -30,6 +33,7 @@ local_runqueue_add(struct sandbox *sandbox)
 #ifdef LOG_LOCAL_RUNQUEUE
 	local_runqueue_count++;
 #endif
+	atomic_fetch_add_explicit(&local_runqueue_lengths[worker_thread_idx].value, 1, memory_order_relaxed);
 	return local_runqueue.add_fn(sandbox);
 }
 
@@ -44,6 +48,7 @@ local_runqueue_delete(struct sandbox *sandbox)
 #ifdef LOG_LOCAL_RUNQUEUE
 	local_runqueue_count--;
 #endif
+	atomic_fetch_sub_explicit(&local_runqueue_lengths[worker_thread_idx].value, 1, memory_order_relaxed);
 	local_runqueue.delete_fn(sandbox);
 }
 
@@ -68,3 +73,35 @@ local_runqueue_get_next()
 	assert(local_runqueue.get_next_fn != NULL);
 	return local_runqueue.get_next_fn();
 };
+
+/**
+ * Removes a sandbox that another worker may run in place of this one. The variant chooses the sandbox it would run
+ * last among those that have never run
+ * @returns the removed sandbox, or NULL if none is eligible or the variant does not support stealing
+ */
+struct sandbox *
+local_runqueue_steal(void)
+{
+	if (local_runqueue.steal_fn == NULL) return NULL;
+
+	struct sandbox *sandbox = local_runqueue.steal_fn();
+	if (sandbox != NULL) {
+#ifdef LOG_LOCAL_RUNQUEUE
+		local_runqueue_count--;
+#endif
+		atomic_fetch_sub_explicit(&local_runqueue_lengths[worker_thread_idx].value, 1, memory_order_relaxed);
+	}
+	return sandbox;
+}
+
+/**
+ * Gets the sandbox the variant would run next among those of a single domain. The running sandbox is eligible
+ * @param domain
+ * @returns the sandbox, or NULL if none is in the domain or the variant is not domain aware
+ */
+struct sandbox *
+local_runqueue_get_next_in_domain(int32_t domain)
+{
+	if (local_runqueue.get_next_in_domain_fn == NULL) return NULL;
+	return local_runqueue.get_next_in_domain_fn(domain);
+}
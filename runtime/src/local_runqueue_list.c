@@ -77,15 +77,60 @@ local_runqueue_list_get_next()
 	return local_runqueue_list_get_head();
 }
 
+/**
+ * Removes the sandbox closest to the tail that has never run
+ * @returns the removed sandbox or NULL if none is eligible
+ */
+static struct sandbox *
+local_runqueue_list_steal()
+{
+	struct sandbox *current = current_sandbox_get();
+
+	for (struct sandbox *sandbox = ps_list_head_last_d(&local_runqueue_list, struct sandbox);
+	     !ps_list_is_head_d(&local_runqueue_list, sandbox); sandbox = ps_list_prev_d(sandbox)) {
+		if (sandbox == current) continue;
+		if (sandbox->state != SANDBOX_RUNNABLE || sandbox->has_run) continue;
+
+		local_runqueue_list_remove(sandbox);
+		return sandbox;
+	}
+
+	return NULL;
+}
+
+/**
+ * Finds the sandbox nearest the head in a domain
+ * @param domain
+ * @returns the sandbox or NULL if none is eligible
+ */
+static struct sandbox *
+local_runqueue_list_get_next_in_domain(int32_t domain)
+{
+	struct sandbox *current = current_sandbox_get();
+
+	for (struct sandbox *sandbox = ps_list_head_first_d(&local_runqueue_list, struct sandbox);
+	     !ps_list_is_head_d(&local_runqueue_list, sandbox); sandbox = ps_list_next_d(sandbox)) {
+		if (sandbox->module->domain != domain) continue;
+		if (sandbox != current && sandbox->state != SANDBOX_RUNNABLE && sandbox->state != SANDBOX_PREEMPTED)
+			continue;
+
+		return sandbox;
+	}
+
+	return NULL;
+}
+
 void
 local_runqueue_list_initialize()
 {
 	ps_list_head_init(&local_runqueue_list);
 
 	/* Register Function Pointers for Abstract Scheduling API */
-	struct local_runqueue_config config = { .add_fn      = local_runqueue_list_append,
-		                                .is_empty_fn = local_runqueue_list_is_empty,
-		                                .delete_fn   = local_runqueue_list_remove,
-		                                .get_next_fn = local_runqueue_list_get_next };
+	struct local_runqueue_config config = { .add_fn                = local_runqueue_list_append,
+		                                .is_empty_fn           = local_runqueue_list_is_empty,
+		                                .delete_fn             = local_runqueue_list_remove,
+		                                .get_next_fn           = local_runqueue_list_get_next,
+		                                .steal_fn              = local_runqueue_list_steal,
+		                                .get_next_in_domain_fn = local_runqueue_list_get_next_in_domain };
 	local_runqueue_initialize(&config);
 };
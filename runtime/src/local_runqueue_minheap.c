@@ -71,6 +71,51 @@ local_runqueue_minheap_get_next()
 	return next;
 }
 
+/**
+ * Removes the sandbox with the latest deadline that has never run
+ * @returns the removed sandbox or NULL if none is eligible
+ */
+static struct sandbox *
+local_runqueue_minheap_steal()
+{
+	struct sandbox *current = current_sandbox_get();
+	struct sandbox *latest  = NULL;
+
+	/* Items are stored starting at index 1 */
+	for (size_t i = 1; i <= local_runqueue_minheap->size; i++) {
+		struct sandbox *sandbox = (struct sandbox *)local_runqueue_minheap->items[i];
+		if (sandbox == current) continue;
+		if (sandbox->state != SANDBOX_RUNNABLE || sandbox->has_run) continue;
+		if (latest == NULL || sandbox->absolute_deadline > latest->absolute_deadline) latest = sandbox;
+	}
+
+	if (latest != NULL) local_runqueue_minheap_delete(latest);
+	return latest;
+}
+
+/**
+ * Finds the sandbox with the earliest deadline in a domain
+ * @param domain
+ * @returns the sandbox or NULL if none is eligible
+ */
+static struct sandbox *
+local_runqueue_minheap_get_next_in_domain(int32_t domain)
+{
+	struct sandbox *current  = current_sandbox_get();
+	struct sandbox *earliest = NULL;
+
+	/* Items are stored starting at index 1 */
+	for (size_t i = 1; i <= local_runqueue_minheap->size; i++) {
+		struct sandbox *sandbox = (struct sandbox *)local_runqueue_minheap->items[i];
+		if (sandbox->module->domain != domain) continue;
+		if (sandbox != current && sandbox->state != SANDBOX_RUNNABLE && sandbox->state != SANDBOX_PREEMPTED)
+			continue;
+		if (earliest == NULL || sandbox->absolute_deadline < earliest->absolute_deadline) earliest = sandbox;
+	}
+
+	return earliest;
+}
+
 /**
  * Registers the PS variant with the polymorphic interface
  */
@@ -81,10 +126,12 @@ local_runqueue_minheap_initialize()
 	local_runqueue_minheap = priority_queue_initialize(256, false, sandbox_get_priority);
 
 	/* Register Function Pointers for Abstract Scheduling API */
-	struct local_runqueue_config config = { .add_fn      = local_runqueue_minheap_add,
-		                                .is_empty_fn = local_runqueue_minheap_is_empty,
-		                                .delete_fn   = local_runqueue_minheap_delete,
-		                                .get_next_fn = local_runqueue_minheap_get_next };
+	struct local_runqueue_config config = { .add_fn                = local_runqueue_minheap_add,
+		                                .is_empty_fn           = local_runqueue_minheap_is_empty,
+		                                .delete_fn             = local_runqueue_minheap_delete,
+		                                .get_next_fn           = local_runqueue_minheap_get_next,
+		                                .steal_fn              = local_runqueue_minheap_steal,
+		                                .get_next_in_domain_fn = local_runqueue_minheap_get_next_in_domain };
 
 	local_runqueue_initialize(&config);
 }
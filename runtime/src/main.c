@@ -16,14 +16,18 @@
 
 #include "debuglog.h"
 #include "flush.h"
+#include "io_engine.h"
 #include "listener_thread.h"
+#include "metrics.h"
 #include "module.h"
 #include "panic.h"
+#include "perf_window_aggregator.h"
 #include "runtime.h"
 #include "sandbox_types.h"
 #include "scheduler.h"
 #include "cache_protection.h"
 #include "software_interrupt.h"
+#include "trace.h"
 #include "worker_thread.h"
 
 /* Conditionally used by debuglog when NDEBUG is not set */
@@ -34,13 +38,28 @@ uint32_t runtime_total_online_processors = 0;
 uint32_t runtime_worker_threads_count    = 0;
 
 enum RUNTIME_SIGALRM_HANDLER runtime_sigalrm_handler = RUNTIME_SIGALRM_HANDLER_BROADCAST;
+enum RUNTIME_SIGALRM_TIMER   runtime_sigalrm_timer   = RUNTIME_SIGALRM_TIMER_PROCESS;
 int                          runtime_worker_core_count;
 
 
-bool     runtime_preemption_enabled = true;
-uint32_t runtime_quantum_us         = 5000; /* 5ms */
-bool     runtime_sync_switches      = false;
-bool     runtime_domains            = false;
+bool     runtime_preemption_enabled                   = true;
+uint32_t runtime_quantum_us                           = 5000; /* 5ms */
+bool     runtime_sync_switches                        = false;
+bool     runtime_domains                              = false;
+bool     runtime_domain_affinity_enabled              = false;
+bool     runtime_sandbox_pool_enabled                 = false;
+bool     runtime_worker_accept_enabled                = false;
+bool     runtime_keepalive_enabled                    = false;
+uint32_t runtime_keepalive_timeout_us                 = 5000000; /* 5s */
+bool     runtime_work_stealing_enabled                = false;
+bool     runtime_gang_epoch_enabled                   = false;
+uint32_t runtime_gang_group_size                      = 0; /* 0 is a single group of all workers */
+bool     runtime_admissions_codel_enabled             = false;
+uint32_t runtime_admissions_codel_target_percent      = 20;
+bool     runtime_admissions_adaptive_overhead_enabled = false;
+bool     runtime_early_rejection_enabled              = false;
+int      runtime_early_rejection_status_code          = 503;
+uint16_t runtime_metrics_port                         = 0; /* 0 disables the metrics endpoint */
 
 /**
  * Returns instructions on use of CLI if used incorrectly
@@ -192,20 +211,48 @@ runtime_configure()
 	}
 	printf("\tScheduler Policy: %s\n", scheduler_print(scheduler));
 
+	/* Global Request Queue */
+	char *global_queue_policy = getenv("SLEDGE_GLOBAL_QUEUE");
+	if (global_queue_policy == NULL) global_queue_policy = "MINHEAP";
+	if (strcmp(global_queue_policy, "MINHEAP") == 0) {
+		global_queue = GLOBAL_QUEUE_MINHEAP;
+	} else if (strcmp(global_queue_policy, "MULTIQUEUE") == 0) {
+		if (unlikely(scheduler != SCHEDULER_EDF)) panic("SLEDGE_GLOBAL_QUEUE=MULTIQUEUE is only valid with EDF\n");
+		global_queue = GLOBAL_QUEUE_MULTIQUEUE;
+	} else {
+		panic("Invalid global queue: %s. Must be {MINHEAP|MULTIQUEUE}\n", global_queue_policy);
+	}
+	if (scheduler == SCHEDULER_EDF) printf("\tGlobal Queue: %s\n", global_queue_print(global_queue));
+
+	/* Cache Flush Backend */
+	char *flush_backend_raw = getenv("SLEDGE_FLUSH_BACKEND");
+	if (flush_backend_raw == NULL) flush_backend_raw = "KERNEL";
+	if (strcmp(flush_backend_raw, "KERNEL") == 0) {
+		flush_backend = FLUSH_BACKEND_KERNEL;
+	} else if (strcmp(flush_backend_raw, "USERSPACE") == 0) {
+		flush_backend = FLUSH_BACKEND_USERSPACE;
+	} else {
+		panic("Invalid flush backend: %s. Must be {KERNEL|USERSPACE}\n", flush_backend_raw);
+	}
+
     /* Cache Flush Policy */
     char *cache_policy = getenv("SLEDGE_CACHE_PROTECTION");
     if (cache_policy == NULL) cache_policy = "NONE";
 	if (strcmp(cache_policy, "NONE") == 0) {
 		cache_protection = CACHE_PROTECTION_NONE;
 	} else if (strcmp(cache_policy, "FLUSH") == 0) {
-        if (!flush_init()) {
+        if (flush_backend == FLUSH_BACKEND_KERNEL && !flush_init()) {
             panic("Cannot initialize flush module. Did you install the cool kernel module correctly?\n");
+        }
+        if (flush_backend == FLUSH_BACKEND_USERSPACE && !flush_init()) {
+            panic("Cannot initialize the userspace flush backend. Unable to detect the cache geometry\n");
         }
 		cache_protection = CACHE_PROTECTION_FLUSH;
 	} else {
 		panic("Invalid cache policy: %s. Must be {NONE|FLUSH}\n", cache_policy);
 	}
 	printf("\tCache Policy: %s\n", cache_protection_print(cache_protection));
+	if (cache_protection == CACHE_PROTECTION_FLUSH) printf("\tFlush Backend: %s\n", flush_backend_print(flush_backend));
 
 	/* Sigalrm Handler Technique */
 	char *sigalrm_policy = getenv("SLEDGE_SIGALRM_HANDLER");
@@ -220,6 +267,21 @@ runtime_configure()
 	}
 	printf("\tSigalrm Policy: %s\n", runtime_print_sigalrm_handler(runtime_sigalrm_handler));
 
+	/* Sigalrm Timer */
+	char *sigalrm_timer = getenv("SLEDGE_SIGALRM_TIMER");
+	if (sigalrm_timer == NULL) sigalrm_timer = "PROCESS";
+	if (strcmp(sigalrm_timer, "PROCESS") == 0) {
+		runtime_sigalrm_timer = RUNTIME_SIGALRM_TIMER_PROCESS;
+	} else if (strcmp(sigalrm_timer, "THREAD") == 0) {
+		runtime_sigalrm_timer = RUNTIME_SIGALRM_TIMER_THREAD;
+	} else if (strcmp(sigalrm_timer, "TICKLESS") == 0) {
+		if (unlikely(scheduler != SCHEDULER_EDF)) panic("tickless sigalrm timers are only valid with EDF\n");
+		runtime_sigalrm_timer = RUNTIME_SIGALRM_TIMER_TICKLESS;
+	} else {
+		panic("Invalid sigalrm timer: %s. Must be {PROCESS|THREAD|TICKLESS}\n", sigalrm_timer);
+	}
+	printf("\tSigalrm Timer: %s\n", runtime_print_sigalrm_timer(runtime_sigalrm_timer));
+
 	/* Runtime Preemption Toggle */
 	char *preempt_disable = getenv("SLEDGE_DISABLE_PREEMPTION");
 	if (preempt_disable != NULL && strcmp(preempt_disable, "false") != 0) runtime_preemption_enabled = false;
@@ -230,7 +292,11 @@ runtime_configure()
     // i.e. forces workers to wait when sandboxes complete or block till the
     // next quantum
     char *sync_switches = getenv("SLEDGE_SYNC_SWITCHES");
-	if (sync_switches != NULL && strcmp(sync_switches, "true") == 0) runtime_sync_switches = true;
+	if (sync_switches != NULL && strcmp(sync_switches, "true") == 0) {
+		if (runtime_sigalrm_timer == RUNTIME_SIGALRM_TIMER_TICKLESS)
+			panic("SLEDGE_SYNC_SWITCHES requires periodic SIGALRMs, so is invalid with a tickless timer\n");
+		runtime_sync_switches = true;
+	}
 	printf("\tSync Switches: %s\n", runtime_sync_switches ? "Enabled" : "Disabled");
 
     /* Runtime Module Domains */
@@ -239,6 +305,80 @@ runtime_configure()
 	if (domains != NULL && strcmp(domains, "true") == 0) runtime_domains = true;
 	printf("\tDomains: %s\n", runtime_domains ? "Enabled" : "Disabled");
 
+	/* Domain Affinity */
+	// prefers sandboxes of the domain that last ran when deadlines allow, and skips flushes between them
+	char *domain_affinity = getenv("SLEDGE_DOMAIN_AFFINITY");
+	if (domain_affinity != NULL && strcmp(domain_affinity, "true") == 0) {
+		if (!runtime_domains) panic("SLEDGE_DOMAIN_AFFINITY requires SLEDGE_DOMAINS\n");
+		if (scheduler == SCHEDULER_GANG) panic("SLEDGE_DOMAIN_AFFINITY is only valid with EDF or FIFO\n");
+		runtime_domain_affinity_enabled = true;
+	}
+	printf("\tDomain Affinity: %s\n", runtime_domain_affinity_enabled ? "Enabled" : "Disabled");
+
+	/* Per-Worker Accept */
+	char *worker_accept = getenv("SLEDGE_WORKER_ACCEPT");
+	if (worker_accept != NULL && strcmp(worker_accept, "true") == 0) runtime_worker_accept_enabled = true;
+	printf("\tWorker Accept: %s\n", runtime_worker_accept_enabled ? "Enabled" : "Disabled");
+
+	/* I/O Engine */
+	char *io_engine_policy = getenv("SLEDGE_IO_ENGINE");
+	if (io_engine_policy == NULL) io_engine_policy = "EPOLL";
+	if (strcmp(io_engine_policy, "EPOLL") == 0) {
+		io_engine = IO_ENGINE_EPOLL;
+	} else if (strcmp(io_engine_policy, "URING") == 0) {
+		io_engine = IO_ENGINE_URING;
+	} else {
+		panic("Invalid I/O engine: %s. Must be {EPOLL|URING}\n", io_engine_policy);
+	}
+	printf("\tI/O Engine: %s\n", io_engine_print(io_engine));
+
+	/* Sandbox Memory Pool */
+	char *sandbox_pool = getenv("SLEDGE_SANDBOX_POOL");
+	if (sandbox_pool != NULL && strcmp(sandbox_pool, "true") == 0) runtime_sandbox_pool_enabled = true;
+	printf("\tSandbox Pool: %s\n", runtime_sandbox_pool_enabled ? "Enabled" : "Disabled");
+
+	/* HTTP Keep-Alive */
+	char *keepalive = getenv("SLEDGE_KEEPALIVE");
+	if (keepalive != NULL && strcmp(keepalive, "true") == 0) runtime_keepalive_enabled = true;
+	printf("\tKeep-Alive: %s\n", runtime_keepalive_enabled ? "Enabled" : "Disabled");
+
+	char *keepalive_timeout_raw = getenv("SLEDGE_KEEPALIVE_TIMEOUT_US");
+	if (keepalive_timeout_raw != NULL) {
+		long keepalive_timeout = atol(keepalive_timeout_raw);
+		if (unlikely(keepalive_timeout <= 0 || keepalive_timeout > UINT32_MAX))
+			panic("SLEDGE_KEEPALIVE_TIMEOUT_US must be a positive 32-bit integer, saw %ld\n",
+			      keepalive_timeout);
+		runtime_keepalive_timeout_us = (uint32_t)keepalive_timeout;
+	}
+	if (runtime_keepalive_enabled) printf("\tKeep-Alive Timeout: %u us\n", runtime_keepalive_timeout_us);
+
+	/* Work Stealing */
+	char *work_stealing = getenv("SLEDGE_WORK_STEALING");
+	if (work_stealing != NULL && strcmp(work_stealing, "true") == 0) {
+		if (scheduler == SCHEDULER_GANG) panic("SLEDGE_WORK_STEALING is not supported by the GANG scheduler\n");
+		runtime_work_stealing_enabled = true;
+	}
+	printf("\tWork Stealing: %s\n", runtime_work_stealing_enabled ? "Enabled" : "Disabled");
+
+	/* Synchronized Gang Epochs */
+	char *gang_epoch = getenv("SLEDGE_GANG_EPOCH");
+	if (gang_epoch != NULL && strcmp(gang_epoch, "true") == 0) {
+		if (scheduler != SCHEDULER_GANG) panic("SLEDGE_GANG_EPOCH is only valid with the GANG scheduler\n");
+		runtime_gang_epoch_enabled = true;
+	}
+	printf("\tGang Epoch: %s\n", runtime_gang_epoch_enabled ? "Enabled" : "Disabled");
+
+	char *gang_group_size_raw = getenv("SLEDGE_GANG_GROUP_SIZE");
+	if (gang_group_size_raw != NULL) {
+		long gang_group_size = atol(gang_group_size_raw);
+		if (unlikely(gang_group_size <= 0 || gang_group_size > RUNTIME_MAX_WORKER_COUNT))
+			panic("SLEDGE_GANG_GROUP_SIZE must be between 1 and %d, saw %ld\n", RUNTIME_MAX_WORKER_COUNT,
+			      gang_group_size);
+		runtime_gang_group_size = (uint32_t)gang_group_size;
+	}
+	if (runtime_gang_group_size == 0) runtime_gang_group_size = runtime_worker_threads_count;
+	if (runtime_gang_epoch_enabled) printf("\tGang Group Size: %u workers\n", runtime_gang_group_size);
+
 	/* Runtime Quantum */
 	char *quantum_raw = getenv("SLEDGE_QUANTUM_US");
 	if (quantum_raw != NULL) {
@@ -250,7 +390,64 @@ runtime_configure()
 	}
 	printf("\tQuantum: %u us\n", runtime_quantum_us);
 
+	/* Queue Delay Load Shedding */
+	char *admissions_codel = getenv("SLEDGE_ADMISSIONS_CODEL");
+	if (admissions_codel != NULL && strcmp(admissions_codel, "true") == 0) runtime_admissions_codel_enabled = true;
+	printf("\tAdmissions CoDel: %s\n", runtime_admissions_codel_enabled ? "Enabled" : "Disabled");
+
+	char *admissions_codel_target_raw = getenv("SLEDGE_ADMISSIONS_CODEL_TARGET");
+	if (admissions_codel_target_raw != NULL) {
+		long admissions_codel_target = atol(admissions_codel_target_raw);
+		if (unlikely(admissions_codel_target <= 0 || admissions_codel_target > 100))
+			panic("SLEDGE_ADMISSIONS_CODEL_TARGET must be a percentage between 1 and 100, saw %ld\n",
+			      admissions_codel_target);
+		runtime_admissions_codel_target_percent = (uint32_t)admissions_codel_target;
+	}
+	if (runtime_admissions_codel_enabled)
+		printf("\tAdmissions CoDel Target: %u%% of relative deadline\n", runtime_admissions_codel_target_percent);
+
+	/* Early Rejection */
+	char *early_rejection = getenv("SLEDGE_EARLY_REJECTION");
+	if (early_rejection != NULL && strcmp(early_rejection, "true") == 0) runtime_early_rejection_enabled = true;
+	printf("\tEarly Rejection: %s\n", runtime_early_rejection_enabled ? "Enabled" : "Disabled");
+
+	char *early_rejection_status_code_raw = getenv("SLEDGE_EARLY_REJECTION_STATUS");
+	if (early_rejection_status_code_raw != NULL) {
+		int early_rejection_status_code = atoi(early_rejection_status_code_raw);
+		if (early_rejection_status_code != 429 && early_rejection_status_code != 503
+		    && early_rejection_status_code != 504)
+			panic("SLEDGE_EARLY_REJECTION_STATUS must be {429|503|504}, saw %s\n",
+			      early_rejection_status_code_raw);
+		runtime_early_rejection_status_code = early_rejection_status_code;
+	}
+	if (runtime_early_rejection_enabled)
+		printf("\tEarly Rejection Status: %d\n", runtime_early_rejection_status_code);
+
+	/* Adaptive Admissions Overhead */
+	char *adaptive_overhead = getenv("SLEDGE_ADMISSIONS_ADAPTIVE_OVERHEAD");
+	if (adaptive_overhead != NULL && strcmp(adaptive_overhead, "true") == 0) {
+#ifndef ADMISSIONS_CONTROL
+		panic("SLEDGE_ADMISSIONS_ADAPTIVE_OVERHEAD requires building with ADMISSIONS_CONTROL\n");
+#endif
+		runtime_admissions_adaptive_overhead_enabled = true;
+	}
+	printf("\tAdmissions Adaptive Overhead: %s\n",
+	       runtime_admissions_adaptive_overhead_enabled ? "Enabled" : "Disabled");
+
+	/* Metrics Endpoint */
+	char *metrics_port_raw = getenv("SLEDGE_METRICS_PORT");
+	if (metrics_port_raw != NULL) {
+		long metrics_port = atol(metrics_port_raw);
+		if (unlikely(metrics_port <= 0 || metrics_port > 65535))
+			panic("SLEDGE_METRICS_PORT must be between 1 and 65535, saw %s\n", metrics_port_raw);
+		runtime_metrics_port = (uint16_t)metrics_port;
+		printf("\tMetrics Port: %u\n", runtime_metrics_port);
+	} else {
+		printf("\tMetrics Port: Disabled\n");
+	}
+
 	sandbox_perf_log_init();
+	trace_init();
 }
 
 void
@@ -331,18 +528,6 @@ log_compiletime_config()
 	printf("\tLog Module Loading: Disabled\n");
 #endif
 
-#ifdef LOG_TOTAL_REQS_RESPS
-	printf("\tLog Total Reqs/Resps: Enabled\n");
-#else
-	printf("\tLog Total Reqs/Resps: Disabled\n");
-#endif
-
-#ifdef LOG_SANDBOX_COUNT
-	printf("\tLog Sandbox Count: Enabled\n");
-#else
-	printf("\tLog Sandbox Count: Disabled\n");
-#endif
-
 #ifdef LOG_LOCAL_RUNQUEUE
 	printf("\tLog Local Runqueue: Enabled\n");
 #else
@@ -379,6 +564,12 @@ main(int argc, char **argv)
 	software_interrupt_initialize();
 
 	listener_thread_initialize();
+#ifdef ADMISSIONS_CONTROL
+	perf_window_aggregator_initialize();
+#endif
+	if (runtime_metrics_port != 0) metrics_initialize();
+	if (sandbox_perf_log != NULL) sandbox_perf_log_writer_initialize();
+	if (trace_file != NULL) trace_writer_initialize();
 	runtime_start_runtime_worker_threads();
 	software_interrupt_arm_timer();
 
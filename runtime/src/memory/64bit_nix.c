@@ -1,3 +1,4 @@
+#include "arch/getcycles.h"
 #include "current_sandbox.h"
 #include "panic.h"
 #include "runtime.h"
@@ -7,43 +8,55 @@
 #include <sys/mman.h>
 
 /**
- * @brief Expand the linear memory of the active WebAssembly sandbox by a single page
+ * @brief Expand the linear memory of the active WebAssembly sandbox by a number of pages
  *
- * @return int
+ * The whole delta is made read/write with a single mprotect, so accesses beyond the new size still trap. The part of
+ * the delta below the module's memory high-water mark is prefaulted, since sandboxes of the module have grown to and
+ * used that much memory before.
+ *
+ * @param page_count number of WebAssembly pages to add
+ * @return 0 on success, -1 if the linear memory max would be exceeded or the pages could not be mapped
  */
 int
-expand_memory(void)
+expand_memory_pages(uint32_t page_count)
 {
 	struct sandbox *sandbox = current_sandbox_get();
 
 	assert(sandbox->state == SANDBOX_RUNNING_USER || sandbox->state == SANDBOX_RUNNING_SYS);
 	assert(local_sandbox_context_cache.memory.size % WASM_PAGE_SIZE == 0);
 
+	uint64_t new_size = (uint64_t)local_sandbox_context_cache.memory.size + (uint64_t)page_count * WASM_PAGE_SIZE;
+
 	/* Return -1 if we've hit the linear memory max */
-	if (unlikely(local_sandbox_context_cache.memory.size + WASM_PAGE_SIZE
-	             >= local_sandbox_context_cache.memory.max)) {
+	if (unlikely(new_size >= local_sandbox_context_cache.memory.max)) {
 		debuglog("expand_memory - Out of Memory!. %u out of %lu\n", local_sandbox_context_cache.memory.size,
 		         local_sandbox_context_cache.memory.max);
 		return -1;
 	}
 
-	// Remap the relevant wasm page to readable
-	char *mem_as_chars = local_sandbox_context_cache.memory.start;
-	char *page_address = &mem_as_chars[local_sandbox_context_cache.memory.size];
-	void *map_result   = mmap(page_address, WASM_PAGE_SIZE, PROT_READ | PROT_WRITE,
-                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
-	if (map_result == MAP_FAILED) {
+	// Set the pages between the current size and the new size as read/write
+	char * mem_as_chars = local_sandbox_context_cache.memory.start;
+	size_t old_size     = local_sandbox_context_cache.memory.size;
+	int    rc           = mprotect(&mem_as_chars[old_size], new_size - old_size, PROT_READ | PROT_WRITE);
+	if (rc == -1) {
 		debuglog("Mapping of new memory failed");
 		return -1;
 	}
 
-	local_sandbox_context_cache.memory.size += WASM_PAGE_SIZE;
+#ifdef MADV_POPULATE_WRITE
+	uint64_t prefault_end = atomic_load(&sandbox->module->memory_high_water_mark);
+	if (prefault_end > new_size) prefault_end = new_size;
+	/* Best effort. Kernels older than 5.14 reject MADV_POPULATE_WRITE with EINVAL, leaving the pages to fault in */
+	if (prefault_end > old_size) madvise(&mem_as_chars[old_size], prefault_end - old_size, MADV_POPULATE_WRITE);
+#endif
+
+	local_sandbox_context_cache.memory.size = new_size;
 
 #ifdef LOG_SANDBOX_MEMORY_PROFILE
-	// Cache the runtime of the first N page allocations
+	// Cache the runtime of the first N memory expansions
 	if (likely(sandbox->timestamp_of.page_allocations_size < SANDBOX_PAGE_ALLOCATION_TIMESTAMP_COUNT)) {
 		sandbox->timestamp_of.page_allocations[sandbox->timestamp_of.page_allocations_size++] =
-		  sandbox->duration_of_state.running
+		  sandbox->duration_of_state[SANDBOX_RUNNING_USER] + sandbox->duration_of_state[SANDBOX_RUNNING_SYS]
 		  + (uint32_t)(__getcycles() - sandbox->timestamp_of.last_state_change);
 	}
 #endif
@@ -53,6 +66,17 @@ expand_memory(void)
 	return 0;
 }
 
+/**
+ * @brief Expand the linear memory of the active WebAssembly sandbox by a single page
+ *
+ * @return int
+ */
+int
+expand_memory(void)
+{
+	return expand_memory_pages(1);
+}
+
 INLINE char *
 get_memory_ptr_for_runtime(uint32_t offset, uint32_t bounds_check)
 {
@@ -79,12 +103,7 @@ instruction_memory_grow(uint32_t count)
 {
 	int rc = local_sandbox_context_cache.memory.size / WASM_PAGE_SIZE;
 
-	for (int i = 0; i < count; i++) {
-		if (unlikely(expand_memory() != 0)) {
-			rc = -1;
-			break;
-		}
-	}
+	if (unlikely(expand_memory_pages(count) != 0)) rc = -1;
 
 	return rc;
 }
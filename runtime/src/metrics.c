@@ -0,0 +1,301 @@
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "admissions_control.h"
+#include "cache_protection.h"
+#include "debuglog.h"
+#include "global_request_scheduler.h"
+#include "http_total.h"
+#include "listener_thread.h"
+#include "local_runqueue.h"
+#include "metrics.h"
+#include "module.h"
+#include "module_database.h"
+#include "panic.h"
+#include "sandbox_perf_log.h"
+#include "sandbox_state.h"
+#include "software_interrupt.h"
+
+const uint32_t metrics_latency_bounds_us[METRICS_LATENCY_BUCKET_COUNT] = {
+	100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+
+pthread_t metrics_thread_id;
+
+static int metrics_socket_descriptor = -1;
+
+/**
+ * Writes the label identifying the thread of a shard
+ * @param buffer
+ * @param size
+ * @param idx the index of the shard
+ */
+static inline void
+metrics_thread_label(char *buffer, size_t size, int idx)
+{
+	if (idx == GENERIC_THREAD_LISTENER_IDX) {
+		snprintf(buffer, size, "listener");
+	} else if (idx == GENERIC_THREAD_OTHER_IDX) {
+		snprintf(buffer, size, "other");
+	} else {
+		snprintf(buffer, size, "%d", idx);
+	}
+}
+
+static inline void
+metrics_print_header(FILE *out, const char *name, const char *type, const char *help)
+{
+	fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void
+metrics_print_http(FILE *out)
+{
+	metrics_print_header(out, "sledge_http_requests_total", "counter", "Requests accepted");
+	fprintf(out, "sledge_http_requests_total %lu\n", GENERIC_THREAD_COUNTER_SUM(http_totals, requests));
+
+	metrics_print_header(out, "sledge_http_responses_total", "counter", "Responses by status code family");
+	fprintf(out, "sledge_http_responses_total{code=\"2XX\"} %lu\n",
+	        GENERIC_THREAD_COUNTER_SUM(http_totals, responses_2XX));
+	fprintf(out, "sledge_http_responses_total{code=\"4XX\"} %lu\n",
+	        GENERIC_THREAD_COUNTER_SUM(http_totals, responses_4XX));
+	fprintf(out, "sledge_http_responses_total{code=\"5XX\"} %lu\n",
+	        GENERIC_THREAD_COUNTER_SUM(http_totals, responses_5XX));
+}
+
+static void
+metrics_print_sandboxes(FILE *out)
+{
+	metrics_print_header(out, "sledge_sandboxes", "gauge",
+	                     "Sandboxes by state. Complete and Error are totals since startup");
+	for (int i = 0; i < SANDBOX_STATE_COUNT; i++) {
+		fprintf(out, "sledge_sandboxes{state=\"%s\"} %ld\n", sandbox_state_stringify(i),
+		        (int64_t)runtime_sandbox_total(i));
+	}
+}
+
+static void
+metrics_print_queues(FILE *out)
+{
+	metrics_print_header(out, "sledge_global_request_scheduler_depth", "gauge",
+	                     "Requests waiting in the global request scheduler");
+	fprintf(out, "sledge_global_request_scheduler_depth %lu\n", global_request_scheduler_depth());
+
+	metrics_print_header(out, "sledge_local_runqueue_depth", "gauge", "Sandboxes on the runqueue of a worker");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		fprintf(out, "sledge_local_runqueue_depth{worker=\"%d\"} %u\n", i,
+		        atomic_load_explicit(&local_runqueue_lengths[i].value, memory_order_relaxed));
+	}
+}
+
+static void
+metrics_print_threads(FILE *out)
+{
+	char label[16];
+
+	metrics_print_header(out, "sledge_lock_wait_cycles_total", "counter", "Cycles spent acquiring locks");
+	for (int i = 0; i < GENERIC_THREAD_MAX_COUNT; i++) {
+		if (i >= runtime_worker_threads_count && i < GENERIC_THREAD_LISTENER_IDX) continue;
+		metrics_thread_label(label, sizeof(label), i);
+		fprintf(out, "sledge_lock_wait_cycles_total{thread=\"%s\"} %lu\n", label,
+		        atomic_load_explicit(&generic_thread_stats[i].lock_duration, memory_order_relaxed));
+	}
+
+	metrics_print_header(out, "sledge_cache_flushes_total", "counter", "Cache flushes performed by a worker");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		fprintf(out, "sledge_cache_flushes_total{worker=\"%d\"} %lu\n", i, cache_protection_stats[i].flushes);
+	}
+
+	metrics_print_header(out, "sledge_cache_flush_cycles_total", "counter", "Cycles spent in the flush backend");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		fprintf(out, "sledge_cache_flush_cycles_total{worker=\"%d\"} %lu\n", i,
+		        cache_protection_stats[i].flush_cycles);
+	}
+
+	metrics_print_header(out, "sledge_deferred_sigalrms_total", "counter",
+	                     "SIGALRMs deferred because the worker was not preemptable");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		fprintf(out, "sledge_deferred_sigalrms_total{worker=\"%d\"} %lu\n", i,
+		        atomic_load_explicit(&software_interrupt_stats[i].deferred_sigalrms, memory_order_relaxed));
+	}
+
+	if (sandbox_perf_log_rings != NULL) {
+		metrics_print_header(out, "sledge_perf_log_dropped_total", "counter",
+		                     "Perf log records dropped because the ring of a worker was full");
+		for (int i = 0; i < runtime_worker_threads_count; i++) {
+			fprintf(out, "sledge_perf_log_dropped_total{worker=\"%d\"} %lu\n", i,
+			        atomic_load_explicit(&sandbox_perf_log_rings[i].dropped, memory_order_relaxed));
+		}
+	}
+
+#ifdef ADMISSIONS_CONTROL
+	metrics_print_header(out, "sledge_admissions_admitted", "gauge", "Sum of the estimates of admitted requests");
+	fprintf(out, "sledge_admissions_admitted %lu\n", atomic_load(&admissions_control_admitted));
+	metrics_print_header(out, "sledge_admissions_capacity", "gauge", "Capacity of admissions control");
+	fprintf(out, "sledge_admissions_capacity %lu\n", atomic_load(&admissions_control_capacity));
+#endif
+}
+
+static void
+metrics_print_modules(FILE *out)
+{
+	metrics_print_header(out, "sledge_module_latency_seconds", "histogram",
+	                     "Latency from request arrival to response of sandboxes that completed");
+
+	/* Modules are only ever appended, and a module is fully initialized before it is added */
+	size_t module_count = module_database_count;
+	for (size_t i = 0; i < module_count; i++) {
+		struct module *module     = module_database[i];
+		uint64_t       cumulative = 0;
+		uint64_t       sum        = 0;
+
+		for (int bucket = 0; bucket <= METRICS_LATENCY_BUCKET_COUNT; bucket++) {
+			for (int worker = 0; worker < runtime_worker_threads_count; worker++) {
+				cumulative += atomic_load_explicit(&module->latency[worker].buckets[bucket],
+				                                   memory_order_relaxed);
+			}
+
+			if (bucket < METRICS_LATENCY_BUCKET_COUNT) {
+				fprintf(out, "sledge_module_latency_seconds_bucket{module=\"%s\",le=\"%g\"} %lu\n",
+				        module->name, metrics_latency_bounds_us[bucket] / 1000000.0, cumulative);
+			} else {
+				fprintf(out, "sledge_module_latency_seconds_bucket{module=\"%s\",le=\"+Inf\"} %lu\n",
+				        module->name, cumulative);
+			}
+		}
+
+		for (int worker = 0; worker < runtime_worker_threads_count; worker++) {
+			sum += atomic_load_explicit(&module->latency[worker].sum, memory_order_relaxed);
+		}
+
+		fprintf(out, "sledge_module_latency_seconds_sum{module=\"%s\"} %g\n", module->name,
+		        (double)sum / runtime_processor_speed_MHz / 1000000.0);
+		fprintf(out, "sledge_module_latency_seconds_count{module=\"%s\"} %lu\n", module->name, cumulative);
+	}
+}
+
+/**
+ * @param client_socket
+ * @param buffer
+ * @param length
+ * @returns 0 on success, -1 if the client went away
+ */
+static int
+metrics_write(int client_socket, const char *buffer, size_t length)
+{
+	size_t total_sent = 0;
+	while (total_sent < length) {
+		ssize_t sent = write(client_socket, &buffer[total_sent], length - total_sent);
+		if (sent < 0) {
+			if (errno == EINTR) continue;
+			return -1;
+		}
+		total_sent += sent;
+	}
+	return 0;
+}
+
+/**
+ * Renders every metric and sends them to a client that scraped the endpoint
+ * @param client_socket
+ */
+static void
+metrics_respond(int client_socket)
+{
+	char   request[METRICS_REQUEST_BUFFER_SIZE];
+	char * body        = NULL;
+	size_t body_length = 0;
+
+	/* Drain the request, as closing a socket with unread data resets the connection */
+	if (read(client_socket, request, sizeof(request)) < 0) goto done;
+
+	FILE *out = open_memstream(&body, &body_length);
+	if (unlikely(out == NULL)) goto done;
+
+	metrics_print_http(out);
+	metrics_print_sandboxes(out);
+	metrics_print_queues(out);
+	metrics_print_threads(out);
+	metrics_print_modules(out);
+	fclose(out);
+
+	char header[128];
+	int  header_length = snprintf(header, sizeof(header),
+	                              "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+	                              "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+	                              body_length);
+
+	if (metrics_write(client_socket, header, header_length) < 0) goto done;
+	metrics_write(client_socket, body, body_length);
+
+done:
+	free(body);
+	return;
+}
+
+static void *
+metrics_main(void *dummy)
+{
+	while (true) {
+		int client_socket = accept(metrics_socket_descriptor, NULL, NULL);
+		if (client_socket < 0) {
+			if (errno != EINTR) debuglog("Metrics accept failed: %s\n", strerror(errno));
+			continue;
+		}
+
+		/* A scrape is served inline, so bound how long a slow client can stall the endpoint */
+		struct timeval timeout = { .tv_sec = 1, .tv_usec = 0 };
+		setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+		metrics_respond(client_socket);
+		close(client_socket);
+	}
+
+	panic("Metrics thread unexpectedly exited\n");
+	return NULL;
+}
+
+/**
+ * Listens on runtime_metrics_port and starts the metrics thread, sharing the listener's core so that it does not
+ * disturb workers
+ */
+void
+metrics_initialize(void)
+{
+	assert(runtime_metrics_port != 0);
+
+	metrics_socket_descriptor = socket(AF_INET, SOCK_STREAM, 0);
+	if (unlikely(metrics_socket_descriptor < 0)) panic_err();
+
+	int optval = 1;
+	if (unlikely(setsockopt(metrics_socket_descriptor, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0))
+		panic_err();
+
+	struct sockaddr_in address = { .sin_family      = AF_INET,
+		                       .sin_addr.s_addr = htonl(INADDR_ANY),
+		                       .sin_port        = htons(runtime_metrics_port) };
+	if (unlikely(bind(metrics_socket_descriptor, (struct sockaddr *)&address, sizeof(address)) < 0))
+		panic("Failed to bind the metrics port %u: %s\n", runtime_metrics_port, strerror(errno));
+	if (unlikely(listen(metrics_socket_descriptor, MODULE_MAX_PENDING_CLIENT_REQUESTS) < 0)) panic_err();
+
+	cpu_set_t cs;
+	CPU_ZERO(&cs);
+	CPU_SET(LISTENER_THREAD_CORE_ID, &cs);
+
+	int ret = pthread_create(&metrics_thread_id, NULL, metrics_main, NULL);
+	if (unlikely(ret != 0)) panic("Failed to start the metrics thread: %s\n", strerror(ret));
+
+	ret = pthread_setaffinity_np(metrics_thread_id, sizeof(cpu_set_t), &cs);
+	assert(ret == 0);
+
+	printf("\tMetrics thread: %lx\n", metrics_thread_id);
+}
@@ -8,6 +8,7 @@
 #include <unistd.h>
 
 #include "debuglog.h"
+#include "gang_domain.h"
 #include "http.h"
 #include "likely.h"
 #include "listener_thread.h"
@@ -15,7 +16,9 @@
 #include "module_database.h"
 #include "panic.h"
 #include "runtime.h"
+#include "sandbox_pipeline.h"
 #include "scheduler.h"
+#include "worker_listener.h"
 
 const int JSON_MAX_ELEMENT_COUNT = 16;
 const int JSON_MAX_ELEMENT_SIZE  = 1024;
@@ -25,12 +28,12 @@ const int JSON_MAX_ELEMENT_SIZE  = 1024;
  ************************/
 
 /**
- * Start the module as a server listening at module->port
+ * Creates a non-blocking SO_REUSEPORT socket listening at module->port
  * @param module
- * @returns 0 on success, -1 on error
+ * @returns socket descriptor on success, -1 on error
  */
-static inline int
-module_listen(struct module *module)
+static int
+module_create_listening_socket(struct module *module)
 {
 	int rc;
 
@@ -52,7 +55,6 @@ module_listen(struct module *module)
 	if (unlikely(rc < 0)) goto err_set_socket_option;
 
 	/* Bind name [all addresses]:[module->port] to socket */
-	module->socket_descriptor              = socket_descriptor;
 	module->socket_address.sin_family      = AF_INET;
 	module->socket_address.sin_addr.s_addr = htonl(INADDR_ANY);
 	module->socket_address.sin_port        = htons((unsigned short)module->port);
@@ -63,24 +65,48 @@ module_listen(struct module *module)
 	rc = listen(socket_descriptor, MODULE_MAX_PENDING_CLIENT_REQUESTS);
 	if (unlikely(rc < 0)) goto err_listen;
 
+done:
+	return socket_descriptor;
+err_listen:
+err_bind_socket:
+err_set_socket_option:
+	close(socket_descriptor);
+err_create_socket:
+	debuglog("Socket Error: %s", strerror(errno));
+	socket_descriptor = -1;
+	goto done;
+}
+
+/**
+ * Start the module as a server listening at module->port
+ * @param module
+ * @returns 0 on success, -1 on error
+ */
+static inline int
+module_listen(struct module *module)
+{
+	int rc;
+
+	/* Each worker accepts on its own socket, so the listener thread does not monitor the module */
+	if (runtime_worker_accept_enabled) return worker_listener_register_module(module, module_create_listening_socket);
+
+	int socket_descriptor = module_create_listening_socket(module);
+	if (unlikely(socket_descriptor < 0)) goto err;
 
 	/* Set the socket descriptor and register with our global epoll instance to monitor for incoming HTTP
 	requests */
-	rc = listener_thread_register_module(module);
+	module->socket_descriptor = socket_descriptor;
+	rc                        = listener_thread_register_module(module);
 	if (unlikely(rc < 0)) goto err_add_to_epoll;
 
 	rc = 0;
 done:
 	return rc;
 err_add_to_epoll:
-err_listen:
-err_bind_socket:
 	module->socket_descriptor = -1;
-err_set_socket_option:
 	close(socket_descriptor);
-err_create_socket:
-err:
 	debuglog("Socket Error: %s", strerror(errno));
+err:
 	rc = -1;
 	goto done;
 }
@@ -120,7 +146,11 @@ module_free(struct module *module)
 	/* Do not free if we still have oustanding references */
 	if (module->reference_count) return;
 
-	close(module->socket_descriptor);
+	if (runtime_worker_accept_enabled) {
+		for (int i = 0; i < runtime_worker_threads_count; i++) close(module->worker_socket_descriptors[i]);
+	} else {
+		close(module->socket_descriptor);
+	}
 	awsm_abi_deinit(&module->abi);
 	free(module);
 }
@@ -143,7 +173,8 @@ module_free(struct module *module)
 
 struct module *
 module_new(char *name, char *path, uint32_t stack_size, uint32_t max_memory, uint32_t relative_deadline_us, int port,
-           int request_size, int response_size, int admissions_percentile, uint32_t expected_execution_us, int32_t domain)
+           int request_size, int response_size, int admissions_percentile, uint32_t expected_execution_us, int32_t domain,
+           uint32_t domain_weight)
 {
 	int rc = 0;
 
@@ -181,6 +212,8 @@ module_new(char *name, char *path, uint32_t stack_size, uint32_t max_memory, uin
 	uint64_t expected_execution = (uint64_t)expected_execution_us * runtime_processor_speed_MHz;
 	admissions_info_initialize(&module->admissions_info, admissions_percentile, expected_execution,
 	                           module->relative_deadline);
+	admissions_codel_initialize(&module->admissions_codel, module->relative_deadline);
+	atomic_init(&module->early_rejection_count, 0);
 
 	/* Request Response Buffer */
 	if (request_size == 0) request_size = MODULE_DEFAULT_REQUEST_RESPONSE_SIZE;
@@ -189,6 +222,7 @@ module_new(char *name, char *path, uint32_t stack_size, uint32_t max_memory, uin
 	module->max_response_size = round_up_to_page(response_size);
 
     module->domain = domain;
+	if (scheduler == SCHEDULER_GANG) module->domain_slot = gang_domain_register(domain, domain_weight);
 
 	/* Table initialization calls a function that runs within the sandbox. Rather than setting the current sandbox,
 	 * we partially fake this out by only setting the module_indirect_table and then clearing after table
@@ -314,6 +348,8 @@ module_new_from_json(char *file_name)
 		char module_name[MODULE_MAX_NAME_LENGTH] = { 0 };
 		char module_path[MODULE_MAX_PATH_LENGTH] = { 0 };
 
+		struct module *next_stage = NULL;
+
 		int32_t  request_size                                        = 0;
 		int32_t  response_size                                       = 0;
 		uint32_t port                                                = 0;
@@ -324,6 +360,16 @@ module_new_from_json(char *file_name)
 		int      ntoks                                               = 2 * tokens[i].size;
 		char     response_content_type[HTTP_MAX_HEADER_VALUE_LENGTH] = { 0 };
         int32_t  domain                                              = -1;
+		uint32_t domain_weight                                       = 0;
+		bool     is_snapshot_enabled                                 = false;
+		bool     reuse_instances                                     = false;
+		bool     stream_request_body                                 = false;
+		uint32_t max_requests_per_connection                         = 0;
+		uint32_t kill_after_deadline_multiple                        = 0;
+		uint32_t max_cpu_us                                          = 0;
+		uint32_t trace_sample_percent                                = 100;
+
+		enum execution_budget_policy overrun_policy = EXECUTION_BUDGET_POLICY_KILL;
 
 		for (; j < ntoks;) {
 			int  ntks     = 1;
@@ -388,6 +434,65 @@ module_new_from_json(char *file_name)
 				int32_t buffer = strtol(val, NULL, 10);
                 if (buffer < -1) panic("buffer must be a value from -1 to INT32_MAX");
                 domain = (int32_t) buffer;
+			} else if (strcmp(key, "domain-weight") == 0) {
+				int64_t buffer = strtoll(val, NULL, 10);
+				if (buffer < 1 || buffer > GANG_DOMAIN_WEIGHT_MAX)
+					panic("domain-weight must be between 1 and %d, was %ld\n", GANG_DOMAIN_WEIGHT_MAX, buffer);
+				domain_weight = (uint32_t)buffer;
+			} else if (strcmp(key, "snapshot") == 0) {
+				if (strcmp(val, "true") == 0) {
+					is_snapshot_enabled = true;
+				} else if (strcmp(val, "false") != 0) {
+					panic("snapshot must be true or false, was %s\n", val);
+				}
+			} else if (strcmp(key, "next-stage") == 0) {
+				/* Stages must be declared before the modules that hand off to them, so pipelines are acyclic */
+				next_stage = module_database_find_by_name(val);
+				if (next_stage == NULL)
+					panic("next-stage %s must be declared before the modules that hand off to it\n", val);
+			} else if (strcmp(key, "reuse-instances") == 0) {
+				if (strcmp(val, "true") == 0) {
+					reuse_instances = true;
+				} else if (strcmp(val, "false") != 0) {
+					panic("reuse-instances must be true or false, was %s\n", val);
+				}
+			} else if (strcmp(key, "stream-request-body") == 0) {
+				if (strcmp(val, "true") == 0) {
+					stream_request_body = true;
+				} else if (strcmp(val, "false") != 0) {
+					panic("stream-request-body must be true or false, was %s\n", val);
+				}
+			} else if (strcmp(key, "max-requests-per-connection") == 0) {
+				int64_t buffer = strtoll(val, NULL, 10);
+				if (buffer < 0 || buffer > UINT32_MAX)
+					panic("max-requests-per-connection must be between 0 and %u, was %ld\n", UINT32_MAX,
+					      buffer);
+				max_requests_per_connection = (uint32_t)buffer;
+			} else if (strcmp(key, "kill-after-deadline-multiple") == 0) {
+				int64_t buffer = strtoll(val, NULL, 10);
+				if (buffer < 0 || buffer > UINT16_MAX)
+					panic("kill-after-deadline-multiple must be between 0 and %u, was %ld\n", UINT16_MAX,
+					      buffer);
+				kill_after_deadline_multiple = (uint32_t)buffer;
+			} else if (strcmp(key, "max-cpu-us") == 0) {
+				int64_t buffer = strtoll(val, NULL, 10);
+				if (buffer < 0 || buffer > (int64_t)RUNTIME_RELATIVE_DEADLINE_US_MAX)
+					panic("max-cpu-us must be between 0 and %ld, was %ld\n",
+					      (int64_t)RUNTIME_RELATIVE_DEADLINE_US_MAX, buffer);
+				max_cpu_us = (uint32_t)buffer;
+			} else if (strcmp(key, "overrun-policy") == 0) {
+				if (strcmp(val, "kill") == 0) {
+					overrun_policy = EXECUTION_BUDGET_POLICY_KILL;
+				} else if (strcmp(val, "demote") == 0) {
+					overrun_policy = EXECUTION_BUDGET_POLICY_DEMOTE;
+				} else {
+					panic("overrun-policy must be kill or demote, was %s\n", val);
+				}
+			} else if (strcmp(key, "trace-sample-percent") == 0) {
+				int64_t buffer = strtoll(val, NULL, 10);
+				if (buffer < 0 || buffer > 100)
+					panic("trace-sample-percent must be between 0 and 100, was %ld\n", buffer);
+				trace_sample_percent = (uint32_t)buffer;
 			} else {
 #ifdef LOG_MODULE_LOADING
 				debuglog("Invalid (%s,%s)\n", key, val);
@@ -421,14 +526,30 @@ module_new_from_json(char *file_name)
 			panic("relative_deadline_us is required\n");
 #endif
 
+		/* The deadline multiple budget is relative to the deadline, and only EDF has a background class to demote to */
+		if (kill_after_deadline_multiple != 0 && relative_deadline_us == 0)
+			panic("kill-after-deadline-multiple requires relative-deadline-us\n");
+		if (overrun_policy == EXECUTION_BUDGET_POLICY_DEMOTE && scheduler != SCHEDULER_EDF)
+			panic("overrun-policy demote requires the EDF scheduler\n");
+
 		/* Allocate a module based on the values from the JSON */
 		struct module *module = module_new(module_name, module_path, 0, 0, relative_deadline_us, port,
 		                                   request_size, response_size, admissions_percentile,
-		                                   expected_execution_us, domain);
+		                                   expected_execution_us, domain, domain_weight);
 		if (module == NULL) goto module_new_err;
 
 		assert(module);
 		module_set_http_info(module, response_content_type);
+		module_snapshot_initialize(&module->snapshot, is_snapshot_enabled);
+		module->max_requests_per_connection = max_requests_per_connection;
+		module->trace_sample_percent        = trace_sample_percent;
+		module->reuse_instances             = reuse_instances;
+		module->next_stage                  = next_stage;
+		module->stream_request_body         = stream_request_body;
+		if (next_stage != NULL) sandbox_pipeline_module_count++;
+		if (reuse_instances) sandbox_idle_list_module_count++;
+		execution_budget_initialize(&module->execution_budget, kill_after_deadline_multiple, max_cpu_us,
+		                            overrun_policy, module->relative_deadline);
 		module_count++;
 	}
 
@@ -0,0 +1,121 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "debuglog.h"
+#include "likely.h"
+#include "module_snapshot.h"
+#include "panic.h"
+#include "types.h"
+
+/**
+ * @param page page-aligned address
+ * @returns true if every byte of the page is zero
+ */
+static inline bool
+module_snapshot_page_is_zero(const char *page)
+{
+	const uint64_t *words = (const uint64_t *)page;
+	for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+		if (words[i] != 0) return false;
+	}
+	return true;
+}
+
+void
+module_snapshot_initialize(struct module_snapshot *snapshot, bool is_enabled)
+{
+	assert(snapshot != NULL);
+
+	snapshot->file_descriptor  = -1;
+	snapshot->memory_size      = 0;
+	snapshot->arguments_offset = 0;
+	atomic_init(&snapshot->state, is_enabled ? MODULE_SNAPSHOT_EMPTY : MODULE_SNAPSHOT_DISABLED);
+}
+
+/**
+ * Captures the linear memory of a freshly initialized sandbox as the module's template
+ * Only the first caller captures. Concurrent and later callers return immediately.
+ * Zero pages are skipped, leaving holes in the memfd that read back as zero without consuming memory
+ *
+ * Note that this freezes the AT_RANDOM auxiliary vector value written by stub_init across all later sandboxes
+ * @param snapshot
+ * @param name the module name, used to label the memfd
+ * @param memory linear memory immediately after initialization
+ * @param arguments_offset the sandbox's arguments offset, which later sandboxes inherit
+ */
+void
+module_snapshot_capture(struct module_snapshot *snapshot, char *name, struct wasm_memory *memory,
+                        int32_t arguments_offset)
+{
+	assert(snapshot != NULL);
+	assert(memory != NULL && memory->start != NULL);
+	assert(memory->size % PAGE_SIZE == 0);
+
+	enum module_snapshot_state expected = MODULE_SNAPSHOT_EMPTY;
+	if (!atomic_compare_exchange_strong(&snapshot->state, &expected, MODULE_SNAPSHOT_CAPTURING)) return;
+
+	int fd = memfd_create(name, MFD_CLOEXEC);
+	if (unlikely(fd < 0)) {
+		perror("module_snapshot_capture - memfd_create");
+		goto err_memfd;
+	}
+
+	if (unlikely(ftruncate(fd, memory->size) < 0)) {
+		perror("module_snapshot_capture - ftruncate");
+		goto err_write;
+	}
+
+	for (size_t offset = 0; offset < memory->size; offset += PAGE_SIZE) {
+		char *page = (char *)memory->start + offset;
+		if (module_snapshot_page_is_zero(page)) continue;
+
+		if (unlikely(pwrite(fd, page, PAGE_SIZE, offset) != PAGE_SIZE)) {
+			perror("module_snapshot_capture - pwrite");
+			goto err_write;
+		}
+	}
+
+	snapshot->file_descriptor  = fd;
+	snapshot->memory_size      = memory->size;
+	snapshot->arguments_offset = arguments_offset;
+	atomic_store(&snapshot->state, MODULE_SNAPSHOT_READY);
+
+#ifdef LOG_MODULE_LOADING
+	debuglog("Captured snapshot of %s (%u bytes)\n", name, memory->size);
+#endif
+
+done:
+	return;
+err_write:
+	close(fd);
+err_memfd:
+	/* Sandboxes of this module fall back to full initialization */
+	atomic_store(&snapshot->state, MODULE_SNAPSHOT_FAILED);
+	goto done;
+}
+
+/**
+ * Privately maps a module's template over a sandbox's linear memory. Writes fault in private copies of pages,
+ * leaving the template untouched.
+ * @param snapshot a snapshot in the READY state
+ * @param memory the linear memory of a sandbox that has not been initialized
+ * @param arguments_offset out parameter set to the arguments offset captured with the template
+ */
+void
+module_snapshot_restore(struct module_snapshot *snapshot, struct wasm_memory *memory, int32_t *arguments_offset)
+{
+	assert(module_snapshot_is_ready(snapshot));
+	assert(memory != NULL && memory->start != NULL);
+	assert(snapshot->memory_size < memory->max);
+
+	void *addr = mmap(memory->start, snapshot->memory_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+	                  snapshot->file_descriptor, 0);
+	if (unlikely(addr == MAP_FAILED)) panic("module_snapshot_restore - mmap failed: %s\n", strerror(errno));
+
+	memory->size      = snapshot->memory_size;
+	*arguments_offset = snapshot->arguments_offset;
+}
@@ -0,0 +1,66 @@
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "admissions_control.h"
+#include "admissions_info.h"
+#include "listener_thread.h"
+#include "module_database.h"
+#include "panic.h"
+#include "perf_window_aggregator.h"
+
+/*
+ * Workers record execution times into per-worker shards of each module's perf window without synchronization. The
+ * aggregator periodically merges the shards and caches each module's admissions estimate, so the completion path
+ * never sorts or takes a lock, and the listener reads the estimate in constant time. The aggregator also adapts the
+ * admissions overhead factor when SLEDGE_ADMISSIONS_ADAPTIVE_OVERHEAD is set.
+ */
+
+pthread_t perf_window_aggregator_thread_id;
+
+static void *
+perf_window_aggregator_main(void *dummy)
+{
+	struct timespec interval = { .tv_sec  = PERF_WINDOW_AGGREGATOR_INTERVAL_US / 1000000,
+		                     .tv_nsec = (PERF_WINDOW_AGGREGATOR_INTERVAL_US % 1000000) * 1000 };
+	uint32_t        ticks    = 0;
+
+	while (true) {
+		nanosleep(&interval, NULL);
+
+		/* Modules are only ever appended, and a module is fully initialized before it is added */
+		size_t module_count = module_database_count;
+		for (size_t i = 0; i < module_count; i++) {
+			admissions_info_refresh(&module_database[i]->admissions_info);
+		}
+
+		if (runtime_admissions_adaptive_overhead_enabled
+		    && ++ticks % (ADMISSIONS_CONTROL_ADAPT_INTERVAL_US / PERF_WINDOW_AGGREGATOR_INTERVAL_US) == 0)
+			admissions_control_adapt_overhead();
+	}
+
+	panic("Perf window aggregator unexpectedly exited\n");
+	return NULL;
+}
+
+/**
+ * Starts the perf window aggregator, sharing the listener's core so that it does not disturb workers
+ */
+void
+perf_window_aggregator_initialize(void)
+{
+	cpu_set_t cs;
+	CPU_ZERO(&cs);
+	CPU_SET(LISTENER_THREAD_CORE_ID, &cs);
+
+	int ret = pthread_create(&perf_window_aggregator_thread_id, NULL, perf_window_aggregator_main, NULL);
+	if (unlikely(ret != 0)) panic("Failed to start the perf window aggregator: %s\n", strerror(ret));
+
+	ret = pthread_setaffinity_np(perf_window_aggregator_thread_id, sizeof(cpu_set_t), &cs);
+	assert(ret == 0);
+
+	printf("\tPerf window aggregator thread: %lx\n", perf_window_aggregator_thread_id);
+}
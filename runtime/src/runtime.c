@@ -10,19 +10,31 @@
 #include <sys/resource.h>
 #include <pthread.h>
 
+#include "admissions_codel.h"
 #include "admissions_control.h"
 #include "arch/context.h"
+#include "cache_protection.h"
 #include "client_socket.h"
+#include "connection_table.h"
 #include "debuglog.h"
+#include "gang_epoch.h"
 #include "global_request_scheduler_deque.h"
+#include "global_request_scheduler_domain.h"
 #include "global_request_scheduler_minheap.h"
 #include "http_parser_settings.h"
+#include "io_engine.h"
 #include "listener_thread.h"
 #include "module.h"
 #include "runtime.h"
+#include "sandbox_idle_list.h"
+#include "sandbox_pipeline.h"
+#include "sandbox_pool.h"
 #include "sandbox_request.h"
 #include "scheduler.h"
 #include "software_interrupt.h"
+#include "trace.h"
+#include "work_stealing.h"
+#include "worker_listener.h"
 
 /***************************
  * Shared Process State    *
@@ -40,7 +52,11 @@ uint64_t *runtime_worker_threads_deadline;
 void
 runtime_cleanup()
 {
+	software_interrupt_disarm_timer();
+	software_interrupt_disarm_thread_timers();
+
 	sandbox_perf_log_cleanup();
+	trace_cleanup();
 
 	if (runtime_worker_threads_deadline) free(runtime_worker_threads_deadline);
 	if (runtime_worker_threads_argument) free(runtime_worker_threads_argument);
@@ -48,6 +64,18 @@ runtime_cleanup()
 
 	software_interrupt_deferred_sigalrm_max_print();
 	software_interrupt_deferred_sigalrm_max_free();
+	if (runtime_sandbox_pool_enabled) sandbox_pool_stats_print();
+	if (sandbox_idle_list_module_count > 0) sandbox_idle_list_stats_print();
+	if (sandbox_pipeline_module_count > 0) sandbox_pipeline_stats_print();
+	if (runtime_keepalive_enabled) connection_table_stats_print();
+	if (runtime_work_stealing_enabled) work_stealing_stats_print();
+	if (scheduler == SCHEDULER_GANG) global_request_scheduler_domain_stats_print();
+	if (runtime_gang_epoch_enabled) gang_epoch_stats_print();
+	/* Printed without cache protection too, as the baseline execution time of sandboxes */
+	cache_protection_stats_print();
+	if (runtime_admissions_codel_enabled) admissions_codel_stats_print();
+	if (runtime_early_rejection_enabled) scheduler_early_rejection_print();
+	if (execution_budget_module_count > 0) execution_budget_stats_print();
 	exit(EXIT_SUCCESS);
 }
 
@@ -101,12 +129,23 @@ runtime_initialize(void)
 	runtime_worker_threads_deadline = malloc(runtime_worker_threads_count * sizeof(uint64_t));
 	memset(runtime_worker_threads_deadline, UINT8_MAX, runtime_worker_threads_count * sizeof(uint64_t));
 
-	http_total_init();
 	sandbox_request_count_initialize();
-	sandbox_count_initialize();
 
 	/* Setup Scheduler */
 	scheduler_initialize();
+	if (runtime_worker_accept_enabled) worker_listener_initialize();
+
+	if (runtime_work_stealing_enabled) work_stealing_initialize();
+
+	/* Setup I/O Engine */
+	switch (io_engine) {
+	case IO_ENGINE_EPOLL:
+		io_engine_epoll_initialize();
+		break;
+	case IO_ENGINE_URING:
+		io_engine_uring_initialize();
+		break;
+	}
 
 	/* Configure Signals */
 	signal(SIGPIPE, SIG_IGN);
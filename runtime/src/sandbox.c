@@ -6,9 +6,46 @@
 #include "debuglog.h"
 #include "panic.h"
 #include "sandbox_functions.h"
+#include "sandbox_idle_list.h"
+#include "sandbox_pool.h"
 #include "sandbox_set_as_error.h"
 #include "sandbox_set_as_initialized.h"
 
+/**
+ * Populates the members of a struct sandbox describing the layout of its memory reservation
+ * struct sandbox | HTTP Req Buffer | HTTP Resp Buffer | 4GB of Wasm Linear Memory | Guard Page
+ * @param module the module that we want to run
+ * @param addr the start of the memory reservation, where struct sandbox resides
+ * @returns the resulting sandbox
+ */
+static inline struct sandbox *
+sandbox_set_memory_layout(struct module *module, void *addr)
+{
+	unsigned long page_aligned_sandbox_size = round_up_to_page(sizeof(struct sandbox));
+
+	struct sandbox *sandbox = (struct sandbox *)addr;
+
+	/* Populate Sandbox members */
+	sandbox->state  = SANDBOX_UNINITIALIZED;
+	sandbox->module = module;
+	module_acquire(module);
+
+	sandbox->request.base   = (char *)addr + page_aligned_sandbox_size;
+	sandbox->request.length = 0;
+
+	sandbox->response.base   = (char *)addr + page_aligned_sandbox_size + module->max_request_size;
+	sandbox->response.length = 0;
+
+	sandbox->memory.start = (char *)addr + page_aligned_sandbox_size + module->max_request_size
+	                        + module->max_response_size;
+	sandbox->memory.size = WASM_PAGE_SIZE * WASM_MEMORY_PAGES_INITIAL; /* The initial pages */
+	sandbox->memory.max  = (uint64_t)WASM_PAGE_SIZE * WASM_MEMORY_PAGES_MAX;
+
+	memset(&sandbox->duration_of_state, 0, SANDBOX_STATE_COUNT * sizeof(uint64_t));
+
+	return sandbox;
+}
+
 /**
  * Allocates a WebAssembly sandbox represented by the following layout
  * struct sandbox | HTTP Req Buffer | HTTP Resp Buffer | 4GB of Wasm Linear Memory | Guard Page
@@ -26,10 +63,10 @@ sandbox_allocate_memory(struct module *module)
 	struct sandbox *sandbox                   = NULL;
 	unsigned long   page_aligned_sandbox_size = round_up_to_page(sizeof(struct sandbox));
 
-	unsigned long size_to_alloc = page_aligned_sandbox_size + module->max_request_size + module->max_request_size
+	unsigned long size_to_alloc = page_aligned_sandbox_size + module->max_request_size + module->max_response_size
 	                              + memory_max + /* guard page */ PAGE_SIZE;
 	unsigned long size_to_read_write = page_aligned_sandbox_size + module->max_request_size
-	                                   + module->max_request_size + memory_size;
+	                                   + module->max_response_size + memory_size;
 
 	/*
 	 * Control information should be page-aligned
@@ -55,25 +92,7 @@ sandbox_allocate_memory(struct module *module)
 		goto set_rw_failed;
 	}
 
-	sandbox = (struct sandbox *)addr_rw;
-
-	/* Populate Sandbox members */
-	sandbox->state  = SANDBOX_UNINITIALIZED;
-	sandbox->module = module;
-	module_acquire(module);
-
-	sandbox->request.base   = (char *)addr + page_aligned_sandbox_size;
-	sandbox->request.length = 0;
-
-	sandbox->response.base  = (char *)addr + page_aligned_sandbox_size + module->max_request_size;
-	sandbox->request.length = 0;
-
-	sandbox->memory.start = (char *)addr + page_aligned_sandbox_size + module->max_request_size
-	                        + module->max_request_size;
-	sandbox->memory.size = memory_size;
-	sandbox->memory.max  = memory_max;
-
-	memset(&sandbox->duration_of_state, 0, SANDBOX_STATE_COUNT * sizeof(uint64_t));
+	sandbox = sandbox_set_memory_layout(module, addr_rw);
 
 done:
 	return sandbox;
@@ -88,6 +107,28 @@ err:
 	goto done;
 }
 
+/**
+ * Reuses a memory reservation and stack previously released into the worker's sandbox pool or idle list
+ * Linear memory was reset on release, so only struct sandbox needs to be cleared
+ * @param module the module that we want to run
+ * @param entry the recycled regions
+ * @returns the resulting sandbox
+ */
+static inline struct sandbox *
+sandbox_recycle_memory(struct module *module, struct sandbox_pool_entry *entry)
+{
+	assert(module != NULL);
+	assert(entry != NULL);
+
+	memset(entry->memory, 0, sizeof(struct sandbox));
+	struct sandbox *sandbox = sandbox_set_memory_layout(module, entry->memory);
+
+	sandbox->stack.start = entry->stack;
+	sandbox->stack.size  = module->stack_size;
+
+	return sandbox;
+}
+
 static inline int
 sandbox_allocate_stack(struct sandbox *sandbox)
 {
@@ -142,6 +183,24 @@ sandbox_allocate(struct sandbox_request *sandbox_request)
 	char *          error_message = "";
 	uint64_t        now           = __getcycles();
 
+	struct sandbox_pool_entry recycled;
+
+	/* Run in a warm sandbox of the module if the worker kept one */
+	if (sandbox_request->module->reuse_instances) {
+		struct sandbox *warm = sandbox_idle_list_remove(sandbox_request->module);
+		if (warm != NULL) {
+			recycled = (struct sandbox_pool_entry){ .memory = warm, .stack = warm->stack.start };
+			sandbox  = sandbox_recycle_memory(sandbox_request->module, &recycled);
+			goto allocated;
+		}
+	}
+
+	/* Recycle the memory of a previously completed sandbox if the worker has one with a matching layout */
+	if (runtime_sandbox_pool_enabled && sandbox_pool_remove(sandbox_request->module, &recycled) == 0) {
+		sandbox = sandbox_recycle_memory(sandbox_request->module, &recycled);
+		goto allocated;
+	}
+
 	/* Allocate Sandbox control structures, buffers, and linear memory in a 4GB address space */
 	sandbox = sandbox_allocate_memory(sandbox_request->module);
 	if (!sandbox) {
@@ -154,6 +213,8 @@ sandbox_allocate(struct sandbox_request *sandbox_request)
 		error_message = "failed to allocate sandbox stack";
 		goto err_stack_allocation_failed;
 	}
+
+allocated:
 	sandbox->state = SANDBOX_ALLOCATED;
 
 #ifdef LOG_STATE_CHANGES
@@ -200,8 +261,29 @@ sandbox_free(struct sandbox *sandbox)
 
 	int rc;
 
+	/* Completed sandboxes of modules that reuse instances keep their linear memory, and are kept warm if possible */
+	if (sandbox->memory.start != NULL) {
+		if (sandbox_idle_list_add(sandbox) == 0) return;
+		sandbox_free_linear_memory(sandbox);
+	}
+
 	module_release(sandbox->module);
 
+	/* Linear Memory and Guard Page should already have been munmaped (or reset if pooling) and set to NULL */
+	assert(sandbox->memory.start == NULL);
+
+	unsigned long size_to_unmap = round_up_to_page(sizeof(struct sandbox)) + sandbox->module->max_request_size
+	                              + sandbox->module->max_response_size;
+
+	/* Degenerate sandboxes without a stack are never pooled */
+	if (runtime_sandbox_pool_enabled && likely(sandbox->stack.size > 0)) {
+		struct sandbox_pool_entry entry = { .memory = sandbox, .stack = sandbox->stack.start };
+		if (sandbox_pool_add(sandbox->module, &entry) == 0) goto done;
+
+		/* The pool is full, so the reset linear memory and guard page are unmapped along with everything else */
+		size_to_unmap += sandbox->memory.max + /* guard page */ PAGE_SIZE;
+	}
+
 	/* Free Sandbox Stack if initial allocation was successful */
 	if (likely(sandbox->stack.size > 0)) {
 		assert(sandbox->stack.start != NULL);
@@ -219,14 +301,8 @@ sandbox_free(struct sandbox *sandbox)
 	 * struct sandbox | HTTP Request Buffer | HTTP Response Buffer | 4GB of Wasm Linear Memory | Guard Page
 	 * Allocated      | Allocated           | Allocated            | Freed                     | Freed
 	 */
-
-	/* Linear Memory and Guard Page should already have been munmaped and set to NULL */
-	assert(sandbox->memory.start == NULL);
 	errno = 0;
-
-	unsigned long size_to_unmap = round_up_to_page(sizeof(struct sandbox)) + sandbox->module->max_request_size
-	                              + sandbox->module->max_response_size;
-	munmap(sandbox, size_to_unmap);
+	rc    = munmap(sandbox, size_to_unmap);
 	if (rc == -1) {
 		debuglog("Failed to unmap Sandbox %lu\n", sandbox->id);
 		goto err_free_sandbox_failed;
@@ -0,0 +1,135 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <threads.h>
+
+#include "debuglog.h"
+#include "panic.h"
+#include "sandbox_idle_list.h"
+#include "sandbox_pool.h"
+#include "sandbox_types.h"
+#include "worker_thread.h"
+
+struct sandbox_idle_list_stats sandbox_idle_list_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+/* Modules that reuse instances. Idle list statistics are only printed if this is nonzero */
+uint32_t sandbox_idle_list_module_count = 0;
+
+/* Residency of the initial pages of linear memory, as reported by mincore */
+static thread_local unsigned char
+  sandbox_idle_list_residency[WASM_PAGE_SIZE * WASM_MEMORY_PAGES_INITIAL / PAGE_SIZE];
+
+/**
+ * Resets linear memory to the state of a freshly allocated sandbox while keeping its pages resident. Pages mapped
+ * beyond the initial linear memory are replaced with fresh inaccessible mappings. Initial pages that are resident are
+ * zeroed in place rather than dropped, so the next request does not fault them back in. All other initial pages are
+ * dropped, including pages that were swapped out. The initial pages of a module snapshot are replaced as on release to
+ * the sandbox pool.
+ * @param sandbox the sandbox whose linear memory we want to reset
+ */
+static inline void
+sandbox_idle_list_reset_linear_memory(struct sandbox *sandbox)
+{
+	assert(sandbox != NULL);
+	assert(sandbox->memory.start != NULL);
+
+	if (sandbox->memory_is_snapshot) {
+		sandbox_pool_reset_linear_memory(sandbox);
+		return;
+	}
+
+	unsigned long initial_size = WASM_PAGE_SIZE * WASM_MEMORY_PAGES_INITIAL;
+	char *        start        = sandbox->memory.start;
+
+	if (sandbox->memory.size > initial_size) {
+		void *addr = mmap(start + initial_size, sandbox->memory.size - initial_size, PROT_NONE,
+		                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+		if (unlikely(addr == MAP_FAILED)) panic("sandbox_idle_list_reset_linear_memory - mmap failed\n");
+	}
+
+	if (unlikely(mincore(start, initial_size, sandbox_idle_list_residency) == -1)) {
+		debuglog("mincore failed, so dropping the initial pages of Sandbox %lu\n", sandbox->id);
+		if (unlikely(madvise(start, initial_size, MADV_DONTNEED) == -1)) panic_err();
+	} else {
+		size_t page_count = sizeof(sandbox_idle_list_residency);
+		size_t i          = 0;
+		while (i < page_count) {
+			if (sandbox_idle_list_residency[i] & 1) {
+				memset(start + i * PAGE_SIZE, 0, PAGE_SIZE);
+				i++;
+				continue;
+			}
+
+			/* A page that is not resident may have been swapped out holding data, so runs of them are dropped */
+			size_t run_start = i;
+			while (i < page_count && !(sandbox_idle_list_residency[i] & 1)) i++;
+			if (unlikely(madvise(start + run_start * PAGE_SIZE, (i - run_start) * PAGE_SIZE, MADV_DONTNEED) == -1))
+				panic_err();
+		}
+	}
+
+	sandbox->memory.size = initial_size;
+}
+
+/**
+ * Resets a completed sandbox of a module that reuses instances and keeps it on the module's idle list for the calling
+ * worker. The memory reservation, stack, and HTTP buffers stay mapped
+ * @param sandbox a sandbox whose linear memory was kept on return
+ * @returns 0 on success, -1 if the sandbox cannot be reused or the idle list is full, in which case the caller frees it
+ */
+int
+sandbox_idle_list_add(struct sandbox *sandbox)
+{
+	assert(sandbox != NULL);
+
+	/* Sandboxes that failed may not have run to completion, and degenerate sandboxes have no stack */
+	if (!sandbox->module->reuse_instances || sandbox->state != SANDBOX_COMPLETE) return -1;
+
+	struct sandbox_idle_list *idle_list = &sandbox->module->idle_sandboxes[worker_thread_idx];
+	if (idle_list->count == SANDBOX_IDLE_LIST_CAPACITY) {
+		sandbox_idle_list_stats[worker_thread_idx].overflows++;
+		return -1;
+	}
+
+	sandbox_idle_list_reset_linear_memory(sandbox);
+	sandbox->request.length  = 0;
+	sandbox->response.length = 0;
+
+	/* An idle sandbox does not hold a reference to its module. Reuse acquires one as for any new sandbox */
+	module_release(sandbox->module);
+
+	idle_list->sandboxes[idle_list->count++] = sandbox;
+	return 0;
+}
+
+/**
+ * Takes a warm sandbox of the module from the calling worker's idle list
+ * @param module the module about to be executed
+ * @returns a sandbox to be initialized as by sandbox_allocate, or NULL if the worker has none
+ */
+struct sandbox *
+sandbox_idle_list_remove(struct module *module)
+{
+	assert(module != NULL);
+
+	struct sandbox_idle_list *idle_list = &module->idle_sandboxes[worker_thread_idx];
+	if (idle_list->count == 0) {
+		sandbox_idle_list_stats[worker_thread_idx].misses++;
+		return NULL;
+	}
+
+	sandbox_idle_list_stats[worker_thread_idx].hits++;
+	return idle_list->sandboxes[--idle_list->count];
+}
+
+void
+sandbox_idle_list_stats_print()
+{
+	printf("Sandbox Idle Lists\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu hits, %lu misses, %lu overflows\n", i, sandbox_idle_list_stats[i].hits,
+		       sandbox_idle_list_stats[i].misses, sandbox_idle_list_stats[i].overflows);
+	}
+	fflush(stdout);
+}
@@ -1,3 +1,158 @@
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "listener_thread.h"
+#include "panic.h"
 #include "sandbox_perf_log.h"
 
-FILE *sandbox_perf_log = NULL;
+FILE *                        sandbox_perf_log       = NULL;
+struct sandbox_perf_log_ring *sandbox_perf_log_rings = NULL;
+
+pthread_t sandbox_perf_log_writer_thread_id;
+
+/* Serializes draining between the writer thread and sandbox_perf_log_cleanup */
+static pthread_mutex_t sandbox_perf_log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Writes the records committed to every ring to the log
+ * @returns the number of records written
+ */
+static uint64_t
+sandbox_perf_log_drain(void)
+{
+	uint64_t written = 0;
+
+	pthread_mutex_lock(&sandbox_perf_log_lock);
+	if (sandbox_perf_log == NULL) goto done;
+
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		struct sandbox_perf_log_ring *ring = &sandbox_perf_log_rings[i];
+		uint64_t                      head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+		uint64_t                      tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+		/* Committed records wrap at most once, so they are written in at most two contiguous chunks */
+		while (head != tail) {
+			uint64_t offset = head & (SANDBOX_PERF_LOG_RING_CAPACITY - 1);
+			uint64_t count  = tail - head;
+			if (count > SANDBOX_PERF_LOG_RING_CAPACITY - offset) {
+				count = SANDBOX_PERF_LOG_RING_CAPACITY - offset;
+			}
+
+			fwrite(&ring->records[offset], sizeof(struct sandbox_perf_log_record), count, sandbox_perf_log);
+			head += count;
+			written += count;
+		}
+
+		/* Hands the slots back to the worker only after their records have been copied out */
+		atomic_store_explicit(&ring->head, head, memory_order_release);
+	}
+
+done:
+	pthread_mutex_unlock(&sandbox_perf_log_lock);
+	return written;
+}
+
+static void *
+sandbox_perf_log_writer_main(void *dummy)
+{
+	/* runtime_cleanup drains the rings from a signal handler, so it must not interrupt this thread mid-drain */
+	sigset_t set;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	struct timespec interval = { .tv_sec  = SANDBOX_PERF_LOG_WRITER_INTERVAL_US / 1000000,
+		                     .tv_nsec = (SANDBOX_PERF_LOG_WRITER_INTERVAL_US % 1000000) * 1000 };
+
+	while (true) {
+		if (sandbox_perf_log_drain() == 0) nanosleep(&interval, NULL);
+	}
+
+	panic("Sandbox perf log writer unexpectedly exited\n");
+	return NULL;
+}
+
+/**
+ * Opens the log named by SLEDGE_SANDBOX_PERF_LOG, writes its header, and allocates a ring per worker
+ * Must run after the processor speed and the worker count are known
+ */
+void
+sandbox_perf_log_init(void)
+{
+	char *sandbox_perf_log_path = getenv("SLEDGE_SANDBOX_PERF_LOG");
+	if (sandbox_perf_log_path == NULL) {
+		printf("\tSandbox Performance Log: Disabled\n");
+		return;
+	}
+
+	printf("\tSandbox Performance Log: %s\n", sandbox_perf_log_path);
+	sandbox_perf_log = fopen(sandbox_perf_log_path, "wb");
+	if (sandbox_perf_log == NULL) {
+		perror("sandbox_perf_log_init\n");
+		return;
+	}
+	setvbuf(sandbox_perf_log, NULL, _IOFBF, SANDBOX_PERF_LOG_BUFFER_SIZE);
+
+	struct sandbox_perf_log_header header = { .version             = SANDBOX_PERF_LOG_VERSION,
+		                                  .record_size         = sizeof(struct sandbox_perf_log_record),
+		                                  .processor_speed_MHz = runtime_processor_speed_MHz,
+		                                  .state_count         = SANDBOX_STATE_COUNT };
+	memcpy(header.magic, SANDBOX_PERF_LOG_MAGIC, sizeof(header.magic));
+	if (unlikely(fwrite(&header, sizeof(header), 1, sandbox_perf_log) != 1)) panic_err();
+
+	size_t rings_size = runtime_worker_threads_count * sizeof(struct sandbox_perf_log_ring);
+	sandbox_perf_log_rings = aligned_alloc(CACHE_LINE_SIZE, rings_size);
+	if (unlikely(sandbox_perf_log_rings == NULL)) panic_err();
+	memset(sandbox_perf_log_rings, 0, rings_size);
+}
+
+/**
+ * Starts the writer thread, sharing the listener's core so that it does not disturb workers
+ */
+void
+sandbox_perf_log_writer_initialize(void)
+{
+	assert(sandbox_perf_log_rings != NULL);
+
+	cpu_set_t cs;
+	CPU_ZERO(&cs);
+	CPU_SET(LISTENER_THREAD_CORE_ID, &cs);
+
+	int ret = pthread_create(&sandbox_perf_log_writer_thread_id, NULL, sandbox_perf_log_writer_main, NULL);
+	if (unlikely(ret != 0)) panic("Failed to start the sandbox perf log writer: %s\n", strerror(ret));
+
+	ret = pthread_setaffinity_np(sandbox_perf_log_writer_thread_id, sizeof(cpu_set_t), &cs);
+	assert(ret == 0);
+
+	printf("\tSandbox perf log writer thread: %lx\n", sandbox_perf_log_writer_thread_id);
+}
+
+/**
+ * Writes the records still in the rings and closes the log. Records committed afterwards are discarded
+ */
+void
+sandbox_perf_log_cleanup(void)
+{
+	if (sandbox_perf_log == NULL) return;
+
+	sandbox_perf_log_drain();
+
+	pthread_mutex_lock(&sandbox_perf_log_lock);
+	printf("Sandbox Perf Log\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu dropped records\n", i,
+		       atomic_load_explicit(&sandbox_perf_log_rings[i].dropped, memory_order_relaxed));
+	}
+	fflush(stdout);
+
+	fflush(sandbox_perf_log);
+	fclose(sandbox_perf_log);
+	sandbox_perf_log = NULL;
+	pthread_mutex_unlock(&sandbox_perf_log_lock);
+}
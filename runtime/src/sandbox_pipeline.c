@@ -0,0 +1,124 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "admissions_control.h"
+#include "debuglog.h"
+#include "panic.h"
+#include "sandbox_functions.h"
+#include "sandbox_pipeline.h"
+#include "sandbox_request.h"
+#include "sandbox_set_as_runnable.h"
+#include "sandbox_types.h"
+#include "worker_thread.h"
+
+struct sandbox_pipeline_stats sandbox_pipeline_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+/* Modules with a next stage. Pipeline statistics are only printed if this is nonzero */
+uint32_t sandbox_pipeline_module_count = 0;
+
+/**
+ * Moves the response of a stage into the request buffer of the next stage
+ * @param from the sandbox of the stage that returned
+ * @param to the sandbox of the next stage
+ * @param length of the response
+ */
+static inline void
+sandbox_pipeline_move(struct sandbox *from, struct sandbox *to, size_t length)
+{
+	/* Both buffers are page-aligned and sized in whole pages, so the pages of the response fit the request buffer */
+	size_t remap_length = round_up_to_page(length);
+	assert(remap_length <= to->module->max_request_size);
+
+	if (length >= SANDBOX_PIPELINE_REMAP_THRESHOLD) {
+		void *addr = mremap(from->response.base, remap_length, remap_length, MREMAP_MAYMOVE | MREMAP_FIXED,
+		                    to->request.base);
+		if (likely(addr != MAP_FAILED)) {
+			/* Fill the hole left in the reservation of the stage, as the reservation may be recycled */
+			addr = mmap(from->response.base, remap_length, PROT_READ | PROT_WRITE,
+			            MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+			if (unlikely(addr == MAP_FAILED)) panic("sandbox_pipeline_move - mmap failed\n");
+
+			sandbox_pipeline_stats[worker_thread_idx].remaps++;
+			return;
+		}
+		debuglog("Sandbox %lu: mremap failed, so copying the response - %s\n", from->id, strerror(errno));
+	}
+
+	memcpy(to->request.base, from->response.base, length);
+	sandbox_pipeline_stats[worker_thread_idx].copies++;
+}
+
+/**
+ * Hands the response of a sandbox to a new sandbox of the next stage of its module as the request body, and makes the
+ * new sandbox runnable on this worker. The new sandbox inherits the client socket, the arrival time, and the absolute
+ * deadline of the request
+ * @param sandbox a sandbox in the running sys state that finished executing
+ * @returns 0 on success, 413 if the response exceeds the request buffer of the next stage, or 503 if the next stage
+ * could not be allocated. The caller still owns the client socket on failure
+ */
+int
+sandbox_pipeline_handoff(struct sandbox *sandbox)
+{
+	assert(sandbox != NULL);
+	assert(sandbox->state == SANDBOX_RUNNING_SYS);
+
+	struct module *next_stage = sandbox->module->next_stage;
+	assert(next_stage != NULL);
+
+	if (unlikely(sandbox->response.length > next_stage->max_request_size)) {
+		debuglog("Sandbox %lu: response of %zu bytes exceeds the request buffer of %s\n", sandbox->id,
+		         sandbox->response.length, next_stage->name);
+		return 413;
+	}
+
+	struct sandbox_request *sandbox_request = (struct sandbox_request *)malloc(sizeof(struct sandbox_request));
+	if (unlikely(sandbox_request == NULL)) return 503;
+
+	sandbox_request->id                = sandbox->id;
+	sandbox_request->module            = next_stage;
+	sandbox_request->socket_descriptor = sandbox->client_socket_descriptor;
+	memcpy(&sandbox_request->socket_address, &sandbox->client_address, sizeof(struct sockaddr));
+	sandbox_request->request_arrival_timestamp = sandbox->timestamp_of.request_arrival;
+	sandbox_request->absolute_deadline         = sandbox->absolute_deadline;
+	sandbox_request->admissions_estimate       = sandbox->admissions_estimate;
+	sandbox_request->connection_request_count  = sandbox->connection_request_count;
+
+	/* Frees the sandbox request on success */
+	struct sandbox *next = sandbox_allocate(sandbox_request);
+	if (unlikely(next == NULL)) {
+		free(sandbox_request);
+		return 503;
+	}
+
+	sandbox_pipeline_move(sandbox, next, sandbox->response.length);
+
+	/* The request of the next stage is the body alone, so it is marked as already received and parsed */
+	next->pipeline_stage           = sandbox->pipeline_stage + 1;
+	next->request.length           = sandbox->response.length;
+	next->http_request.body        = next->request.base;
+	next->http_request.body_length = sandbox->response.length;
+	next->http_request.header_end  = true;
+	next->http_request.message_end = true;
+	sandbox->response.length       = 0;
+
+	/* The completion of this stage releases its estimate, so the next stage carries it for the rest of the pipeline */
+	admissions_control_add(next->admissions_estimate);
+
+	sandbox_set_as_runnable(next, SANDBOX_INITIALIZED);
+	return 0;
+}
+
+void
+sandbox_pipeline_stats_print()
+{
+	printf("Sandbox Pipelines\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu remaps, %lu copies\n", i, sandbox_pipeline_stats[i].remaps,
+		       sandbox_pipeline_stats[i].copies);
+	}
+	fflush(stdout);
+}
@@ -0,0 +1,167 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <threads.h>
+
+#include "debuglog.h"
+#include "panic.h"
+#include "sandbox_pool.h"
+#include "sandbox_types.h"
+#include "worker_thread.h"
+
+struct sandbox_pool_bucket {
+	size_t                    max_request_size;
+	size_t                    max_response_size;
+	uint32_t                  stack_size;
+	size_t                    count;
+	struct sandbox_pool_entry entries[SANDBOX_POOL_BUCKET_CAPACITY];
+};
+
+/* Buckets are claimed on first release of a layout and are never reclaimed */
+static thread_local struct sandbox_pool_bucket sandbox_pool_buckets[SANDBOX_POOL_BUCKET_COUNT];
+static thread_local size_t                     sandbox_pool_bucket_count = 0;
+
+struct sandbox_pool_stats sandbox_pool_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
+/**
+ * Finds the bucket matching the memory layout of a module
+ * @param module
+ * @param should_claim if true, claims a free bucket when no bucket matches
+ * @returns bucket or NULL if no bucket matches (and none could be claimed)
+ */
+static inline struct sandbox_pool_bucket *
+sandbox_pool_get_bucket(struct module *module, bool should_claim)
+{
+	for (size_t i = 0; i < sandbox_pool_bucket_count; i++) {
+		struct sandbox_pool_bucket *bucket = &sandbox_pool_buckets[i];
+		if (bucket->max_request_size == module->max_request_size
+		    && bucket->max_response_size == module->max_response_size
+		    && bucket->stack_size == module->stack_size)
+			return bucket;
+	}
+
+	if (!should_claim || sandbox_pool_bucket_count == SANDBOX_POOL_BUCKET_COUNT) return NULL;
+
+	struct sandbox_pool_bucket *bucket = &sandbox_pool_buckets[sandbox_pool_bucket_count++];
+	bucket->max_request_size           = module->max_request_size;
+	bucket->max_response_size          = module->max_response_size;
+	bucket->stack_size                 = module->stack_size;
+	bucket->count                      = 0;
+	return bucket;
+}
+
+/**
+ * Hints to the kernel that the contents of a region are no longer needed. The contents of the HTTP buffers and the
+ * stack are always overwritten before being read, so lazy reclamation via MADV_FREE is sufficient
+ * @param addr page-aligned start of the region
+ * @param length length of the region
+ */
+static inline void
+sandbox_pool_discard(void *addr, size_t length)
+{
+	if (length == 0) return;
+
+#ifdef MADV_FREE
+	if (madvise(addr, length, MADV_FREE) == 0) return;
+	/* Kernels older than 4.5 reject MADV_FREE with EINVAL */
+	if (errno != EINVAL) panic_err();
+#endif
+	if (unlikely(madvise(addr, length, MADV_DONTNEED) == -1)) panic_err();
+}
+
+/**
+ * Resets linear memory to the state of a freshly allocated sandbox. Pages beyond the initial linear memory are
+ * replaced with fresh inaccessible mappings, and the initial pages are dropped so they fault back in zero-filled,
+ * as required by WebAssembly semantics. Dropping the pages of a private mapping of a module snapshot would fault the
+ * snapshot contents back in, so such initial pages are instead replaced with fresh anonymous mappings
+ * @param sandbox the sandbox whose linear memory we want to reset
+ */
+void
+sandbox_pool_reset_linear_memory(struct sandbox *sandbox)
+{
+	assert(sandbox != NULL);
+	assert(sandbox->memory.start != NULL);
+
+	unsigned long initial_size = WASM_PAGE_SIZE * WASM_MEMORY_PAGES_INITIAL;
+	char *        start        = sandbox->memory.start;
+
+	if (sandbox->memory.size > initial_size) {
+		void *addr = mmap(start + initial_size, sandbox->memory.size - initial_size, PROT_NONE,
+		                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+		if (unlikely(addr == MAP_FAILED)) panic("sandbox_pool_reset_linear_memory - mmap failed\n");
+	}
+
+	if (sandbox->memory_is_snapshot) {
+		void *addr = mmap(start, initial_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+		                  -1, 0);
+		if (unlikely(addr == MAP_FAILED)) panic("sandbox_pool_reset_linear_memory - mmap failed\n");
+	} else {
+		int rc = madvise(start, initial_size, MADV_DONTNEED);
+		if (unlikely(rc == -1)) panic("sandbox_pool_reset_linear_memory - madvise failed\n");
+	}
+
+	sandbox->memory.size = initial_size;
+}
+
+/**
+ * Releases the memory of a completed sandbox into the calling worker's pool
+ * The linear memory is expected to have already been reset by sandbox_pool_reset_linear_memory
+ * @param module the module the sandbox executed. Determines the bucket
+ * @param entry the regions to cache
+ * @returns 0 on success, -1 if the pool is full and the caller retains ownership of the regions
+ */
+int
+sandbox_pool_add(struct module *module, struct sandbox_pool_entry *entry)
+{
+	assert(module != NULL);
+	assert(entry != NULL && entry->memory != NULL && entry->stack != NULL);
+
+	struct sandbox_pool_bucket *bucket = sandbox_pool_get_bucket(module, true);
+	if (bucket == NULL || bucket->count == SANDBOX_POOL_BUCKET_CAPACITY) {
+		sandbox_pool_stats[worker_thread_idx].overflows++;
+		return -1;
+	}
+
+	/* The struct sandbox page is zeroed on reuse, so only the HTTP buffers following it are discarded */
+	unsigned long sandbox_size = round_up_to_page(sizeof(struct sandbox));
+	sandbox_pool_discard((char *)entry->memory + sandbox_size, module->max_request_size + module->max_response_size);
+	sandbox_pool_discard(entry->stack, module->stack_size);
+
+	bucket->entries[bucket->count++] = *entry;
+	return 0;
+}
+
+/**
+ * Takes a cached region with a layout matching the module from the calling worker's pool
+ * @param module the module about to be executed
+ * @param entry out parameter populated on success
+ * @returns 0 on success, -1 if no matching region is cached
+ */
+int
+sandbox_pool_remove(struct module *module, struct sandbox_pool_entry *entry)
+{
+	assert(module != NULL);
+	assert(entry != NULL);
+
+	struct sandbox_pool_bucket *bucket = sandbox_pool_get_bucket(module, false);
+	if (bucket == NULL || bucket->count == 0) {
+		sandbox_pool_stats[worker_thread_idx].misses++;
+		return -1;
+	}
+
+	*entry = bucket->entries[--bucket->count];
+	sandbox_pool_stats[worker_thread_idx].hits++;
+	return 0;
+}
+
+void
+sandbox_pool_stats_print()
+{
+	printf("Sandbox Pool\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu hits, %lu misses, %lu overflows\n", i, sandbox_pool_stats[i].hits,
+		       sandbox_pool_stats[i].misses, sandbox_pool_stats[i].overflows);
+	}
+	fflush(stdout);
+}
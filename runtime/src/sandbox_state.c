@@ -22,9 +22,7 @@ const char *sandbox_state_labels[SANDBOX_STATE_COUNT] = {
 	[SANDBOX_ERROR]         = "Error"
 };
 
-#ifdef LOG_SANDBOX_COUNT
-_Atomic uint32_t sandbox_state_count[SANDBOX_STATE_COUNT];
-#endif
+struct sandbox_state_totals sandbox_state_totals[GENERIC_THREAD_MAX_COUNT] = { 0 };
 
 /*
  * Function intended to be interactively run in a debugger to look at sandbox totals
@@ -33,20 +31,13 @@ _Atomic uint32_t sandbox_state_count[SANDBOX_STATE_COUNT];
 void
 runtime_log_sandbox_states()
 {
-#ifdef LOG_SANDBOX_COUNT
-	const size_t buffer_size         = 1000;
-	char         buffer[buffer_size] = "";
+	char buffer[1000] = "";
 	for (int i = 0; i < SANDBOX_STATE_COUNT; i++) {
-		const size_t tiny_buffer_size              = 50;
-		char         tiny_buffer[tiny_buffer_size] = "";
-		snprintf(tiny_buffer, tiny_buffer_size - 1, "%s: %u\n\t", sandbox_state_stringify(i),
-		         atomic_load(&sandbox_state_count[i]));
-		strncat(buffer, tiny_buffer, buffer_size - 1 - strlen(buffer));
+		char tiny_buffer[50] = "";
+		snprintf(tiny_buffer, sizeof(tiny_buffer) - 1, "%s: %lu\n\t", sandbox_state_stringify(i),
+		         runtime_sandbox_total(i));
+		strncat(buffer, tiny_buffer, sizeof(buffer) - 1 - strlen(buffer));
 	}
 
 	debuglog("%s", buffer);
-
-#else
-	debuglog("Must compile with LOG_SANDBOX_COUNT for this functionality!\n");
-#endif
 };
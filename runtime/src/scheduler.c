@@ -1,3 +1,17 @@
+#include <stdio.h>
+
+#include "module_database.h"
 #include "scheduler.h"
 
 enum SCHEDULER scheduler = SCHEDULER_EDF;
+
+void
+scheduler_early_rejection_print()
+{
+	printf("Early Rejections\n");
+	for (size_t i = 0; i < module_database_count; i++) {
+		struct module *module = module_database[i];
+		printf("%s: %lu\n", module->name, atomic_load(&module->early_rejection_count));
+	}
+	fflush(stdout);
+}
@@ -1,11 +1,13 @@
 #include <errno.h>
 #include <pthread.h>
 #include <signal.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <threads.h>
+#include <time.h>
 #include <unistd.h>
 #include <ucontext.h>
 
@@ -28,6 +30,17 @@
 
 static uint64_t software_interrupt_interval_duration_in_cycles;
 
+/* Common start of the quanta of per-thread timers, keeping the ticks of all workers in phase */
+struct timespec software_interrupt_timer_epoch;
+
+/* Per-thread timers of all workers, so they can be deleted on exit */
+struct software_interrupt_thread_timer {
+	timer_t      id;
+	_Atomic bool is_created;
+};
+
+static struct software_interrupt_thread_timer software_interrupt_thread_timers[RUNTIME_MAX_WORKER_COUNT];
+
 /******************
  * Thread Globals *
  *****************/
@@ -38,8 +51,23 @@ thread_local _Atomic static volatile sig_atomic_t software_interrupt_SIGUSR_coun
 thread_local _Atomic volatile sig_atomic_t        software_interrupt_deferred_sigalrm     = 0;
 thread_local _Atomic volatile sig_atomic_t        software_interrupt_signal_depth         = 0;
 
+/* Only valid when runtime_sigalrm_timer is RUNTIME_SIGALRM_TIMER_THREAD or RUNTIME_SIGALRM_TIMER_TICKLESS */
+thread_local static timer_t software_interrupt_thread_timer;
+
+/* True if the one-shot timer of a tickless worker may still be pending */
+thread_local static bool software_interrupt_tickless_armed = false;
+
+/* Set by the listener when it signals a tickless worker and cleared by the worker when the signal is handled */
+struct software_interrupt_tickless_pending {
+	_Atomic bool value;
+} CACHE_ALIGNED;
+
+static struct software_interrupt_tickless_pending software_interrupt_tickless_pending[RUNTIME_MAX_WORKER_COUNT];
+
 _Atomic volatile sig_atomic_t *software_interrupt_deferred_sigalrm_max;
 
+struct software_interrupt_stats software_interrupt_stats[RUNTIME_MAX_WORKER_COUNT] = { 0 };
+
 void
 software_interrupt_deferred_sigalrm_max_alloc()
 {
@@ -79,7 +107,7 @@ extern pthread_t *runtime_worker_threads;
  *************************/
 
 /**
- * A POSIX signal is delivered to only one thread.
+ * A POSIX signal from the process-wide interval timer is delivered to only one thread.
  * This function broadcasts the sigalarm signal to all other worker threads
  */
 static inline void
@@ -115,6 +143,46 @@ sigalrm_propagate_workers(siginfo_t *signal_info)
 	}
 }
 
+/**
+ * Every worker owns a per-thread timer, so a tick is never forwarded. Instead, the SIGALRM handler policy is applied
+ * by each worker to its own tick
+ * @returns true if the tick should preempt the current sandbox
+ */
+static inline bool
+sigalrm_triage_self(siginfo_t *signal_info)
+{
+	assert(signal_info->si_code == SI_TIMER);
+	atomic_fetch_add(&software_interrupt_SIGALRM_kernel_count, 1);
+
+	switch (runtime_sigalrm_handler) {
+	case RUNTIME_SIGALRM_HANDLER_TRIAGED:
+		return scheduler_worker_would_preempt(worker_thread_idx);
+	case RUNTIME_SIGALRM_HANDLER_BROADCAST:
+		return true;
+	default:
+		panic("Unexpected SIGALRM Handler: %d\n", runtime_sigalrm_handler);
+	}
+}
+
+/**
+ * A tickless worker only receives SIGALRM from the expiry of its one-shot timer or from the listener, which targets it
+ * because it enqueued a request with an earlier deadline than the one the worker is running. Either way, preempt.
+ * SIGALRM is not queued, so a signal from the listener is lost if the timer's signal is already pending. The pending
+ * flag is thus cleared by either signal, which both preempt.
+ */
+static inline void
+sigalrm_tickless_self(siginfo_t *signal_info)
+{
+	if (signal_info->si_code == SI_TIMER) {
+		atomic_fetch_add(&software_interrupt_SIGALRM_kernel_count, 1);
+		software_interrupt_tickless_armed = false;
+	} else {
+		atomic_fetch_add(&software_interrupt_SIGALRM_thread_count, 1);
+		assert(signal_info->si_code == SI_TKILL);
+	}
+	atomic_store(&software_interrupt_tickless_pending[worker_thread_idx].value, false);
+}
+
 /**
  * Validates that the thread running the signal handler is a known worker thread
  */
@@ -152,7 +220,14 @@ software_interrupt_handle_signals(int signal_type, siginfo_t *signal_info, void
 
 	switch (signal_type) {
 	case SIGALRM: {
-		sigalrm_propagate_workers(signal_info);
+		bool should_preempt = true;
+		if (runtime_sigalrm_timer == RUNTIME_SIGALRM_TIMER_THREAD) {
+			should_preempt = sigalrm_triage_self(signal_info);
+		} else if (runtime_sigalrm_timer == RUNTIME_SIGALRM_TIMER_TICKLESS) {
+			sigalrm_tickless_self(signal_info);
+		} else {
+			sigalrm_propagate_workers(signal_info);
+		}
 
         // if looping for scheduling, do it here...
         // TODO: is this working?
@@ -162,9 +237,15 @@ software_interrupt_handle_signals(int signal_type, siginfo_t *signal_info, void
             goto done;
         }
 
+		if (!should_preempt) goto done;
+
 		/* Nonpreemptive, so defer */
 		if (!sandbox_is_preemptable(current_sandbox)) {
 			atomic_fetch_add(&software_interrupt_deferred_sigalrm, 1);
+			generic_thread_counter_add(&software_interrupt_stats[worker_thread_idx].deferred_sigalrms, 1);
+			/* No periodic tick would retry a deferred tickless preemption, so retry after a quantum */
+			if (runtime_sigalrm_timer == RUNTIME_SIGALRM_TIMER_TICKLESS && current_sandbox != NULL)
+				software_interrupt_tickless_arm(true);
 			goto done;
 		}
 
@@ -210,11 +291,12 @@ done:
 
 /**
  * Arms the Interval Timer to start in one quantum and then trigger a SIGALRM every quantum
+ * Per-thread timers are instead armed by each worker via software_interrupt_arm_thread_timer
  */
 void
 software_interrupt_arm_timer(void)
 {
-	if (!runtime_preemption_enabled) return;
+	if (!runtime_preemption_enabled || runtime_sigalrm_timer != RUNTIME_SIGALRM_TIMER_PROCESS) return;
 
 	struct itimerval interval_timer;
 
@@ -235,6 +317,8 @@ software_interrupt_arm_timer(void)
 void
 software_interrupt_disarm_timer(void)
 {
+	if (runtime_sigalrm_timer != RUNTIME_SIGALRM_TIMER_PROCESS) return;
+
 	struct itimerval interval_timer;
 
 	memset(&interval_timer, 0, sizeof(struct itimerval));
@@ -248,6 +332,121 @@ software_interrupt_disarm_timer(void)
 	}
 }
 
+/**
+ * Creates a CLOCK_MONOTONIC timer that delivers SIGALRM to the calling worker
+ * A THREAD timer fires every quantum, and all workers share the phase of software_interrupt_timer_epoch, so their
+ * quanta stay aligned. A TICKLESS timer is left disarmed until software_interrupt_tickless_arm
+ */
+void
+software_interrupt_arm_thread_timer(void)
+{
+	if (!runtime_preemption_enabled || runtime_sigalrm_timer == RUNTIME_SIGALRM_TIMER_PROCESS) return;
+
+	struct sigevent signal_event;
+	memset(&signal_event, 0, sizeof(struct sigevent));
+	signal_event.sigev_notify           = SIGEV_THREAD_ID;
+	signal_event.sigev_signo            = SIGALRM;
+	signal_event.sigev_notify_thread_id = syscall(SYS_gettid);
+
+	if (timer_create(CLOCK_MONOTONIC, &signal_event, &software_interrupt_thread_timer) < 0) {
+		perror("timer_create");
+		exit(1);
+	}
+	software_interrupt_thread_timers[worker_thread_idx].id = software_interrupt_thread_timer;
+	atomic_store(&software_interrupt_thread_timers[worker_thread_idx].is_created, true);
+
+	if (runtime_sigalrm_timer == RUNTIME_SIGALRM_TIMER_TICKLESS) return;
+
+	struct itimerspec interval_timer;
+	memset(&interval_timer, 0, sizeof(struct itimerspec));
+	interval_timer.it_interval.tv_nsec = (long)runtime_quantum_us * 1000;
+	interval_timer.it_value.tv_sec     = software_interrupt_timer_epoch.tv_sec;
+	interval_timer.it_value.tv_nsec    = software_interrupt_timer_epoch.tv_nsec + interval_timer.it_interval.tv_nsec;
+	if (interval_timer.it_value.tv_nsec >= 1000000000) {
+		interval_timer.it_value.tv_sec++;
+		interval_timer.it_value.tv_nsec -= 1000000000;
+	}
+
+	/* If the first expiration is already in the past, the timer fires immediately and then stays in phase */
+	if (timer_settime(software_interrupt_thread_timer, TIMER_ABSTIME, &interval_timer, NULL) < 0) {
+		perror("timer_settime");
+		exit(1);
+	}
+}
+
+/**
+ * Deletes the per-thread timers of all workers, so no further ticks interrupt the worker threads
+ * Called from runtime_cleanup, which may run on any thread
+ */
+void
+software_interrupt_disarm_thread_timers(void)
+{
+	if (!runtime_preemption_enabled || runtime_sigalrm_timer == RUNTIME_SIGALRM_TIMER_PROCESS) return;
+
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		if (!atomic_exchange(&software_interrupt_thread_timers[i].is_created, false)) continue;
+
+		if (timer_delete(software_interrupt_thread_timers[i].id) < 0) {
+			perror("timer_delete");
+			exit(1);
+		}
+	}
+}
+
+/**
+ * Arms the one-shot timer of a tickless worker to fire in one quantum, or disarms it
+ * Disarming a timer that is known to be disarmed is skipped, so idle workers make no system calls
+ * Called at every scheduling decision, which also clears a pending signal from the listener, since the listener
+ * compared against a deadline that the worker is about to replace
+ * @param should_arm
+ */
+void
+software_interrupt_tickless_arm(bool should_arm)
+{
+	assert(runtime_sigalrm_timer == RUNTIME_SIGALRM_TIMER_TICKLESS);
+	atomic_store_explicit(&software_interrupt_tickless_pending[worker_thread_idx].value, false, memory_order_relaxed);
+	if (!runtime_preemption_enabled || (!should_arm && !software_interrupt_tickless_armed)) return;
+
+	struct itimerspec interval_timer;
+	memset(&interval_timer, 0, sizeof(struct itimerspec));
+	if (should_arm) interval_timer.it_value.tv_nsec = (long)runtime_quantum_us * 1000;
+
+	if (unlikely(timer_settime(software_interrupt_thread_timer, 0, &interval_timer, NULL) < 0)) panic_err();
+	software_interrupt_tickless_armed = should_arm;
+}
+
+/**
+ * Called by the listener after adding a request to the global request scheduler. If every worker is executing a
+ * sandbox, signals the worker running the latest deadline if that deadline is later than the new request's
+ * Idle workers pull from the global request scheduler on their own, so nothing is signaled if any worker is idle
+ * @param absolute_deadline the deadline of the request just added
+ */
+void
+software_interrupt_tickless_notify(uint64_t absolute_deadline)
+{
+	assert(listener_thread_is_running());
+	if (!runtime_preemption_enabled) return;
+
+	int      target          = -1;
+	uint64_t target_deadline = absolute_deadline;
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		uint64_t worker_deadline = runtime_worker_threads_deadline[i];
+		if (worker_deadline == UINT64_MAX) return;
+
+		/* Skip workers that have not yet handled an earlier signal */
+		if (atomic_load(&software_interrupt_tickless_pending[i].value)) continue;
+
+		if (worker_deadline > target_deadline) {
+			target          = i;
+			target_deadline = worker_deadline;
+		}
+	}
+
+	if (target < 0) return;
+
+	atomic_store(&software_interrupt_tickless_pending[target].value, true);
+	pthread_kill(runtime_worker_threads[target], SIGALRM);
+}
 
 /**
  * Initialize software Interrupts
@@ -279,6 +478,11 @@ software_interrupt_initialize(void)
 		}
 	}
 
+	if (clock_gettime(CLOCK_MONOTONIC, &software_interrupt_timer_epoch) < 0) {
+		perror("clock_gettime");
+		exit(1);
+	}
+
 	software_interrupt_deferred_sigalrm_max_alloc();
 }
 
@@ -0,0 +1,269 @@
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "arch/getcycles.h"
+#include "listener_thread.h"
+#include "panic.h"
+#include "trace.h"
+
+#define TRACE_PID_WORKERS  1
+#define TRACE_PID_REQUESTS 2
+
+FILE *             trace_file  = NULL;
+struct trace_ring *trace_rings = NULL;
+
+pthread_t trace_writer_thread_id;
+
+/* Serializes draining between the writer thread and trace_cleanup */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Timestamps are relative to when tracing started, keeping them short and precise */
+static uint64_t trace_epoch;
+
+/**
+ * @param cycles a timestamp
+ * @returns microseconds since the epoch of the trace, the unit of the trace-event format
+ */
+static inline double
+trace_timestamp_us(uint64_t cycles)
+{
+	return (double)(cycles - trace_epoch) / runtime_processor_speed_MHz;
+}
+
+static inline double
+trace_duration_us(uint64_t cycles)
+{
+	return (double)cycles / runtime_processor_speed_MHz;
+}
+
+/**
+ * Writes a complete event, which spans [ts, ts + dur]
+ */
+static inline void
+trace_print_slice(const char *name, const char *category, int pid, uint64_t tid, double ts, double dur,
+                  struct trace_event *event)
+{
+	fprintf(trace_file,
+	        ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f,"
+	        "\"args\":{\"sandbox\":%lu,\"module\":\"%s\"}}",
+	        name, category, pid, tid, ts, dur, event->sandbox_id, event->module->name);
+}
+
+/**
+ * Writes an instant event scoped to the track of its thread
+ */
+static inline void
+trace_print_instant(const char *name, const char *category, int pid, uint64_t tid, double ts,
+                    struct trace_event *event)
+{
+	fprintf(trace_file,
+	        ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%lu,\"ts\":%.3f,"
+	        "\"args\":{\"sandbox\":%lu,\"module\":\"%s\"",
+	        name, category, pid, tid, ts, event->sandbox_id, event->module->name);
+	if (event->type == TRACE_EVENT_PREEMPTION && event->argument != TRACE_SANDBOX_ID_NONE) {
+		fprintf(trace_file, ",\"next\":%lu", event->argument);
+	}
+	fprintf(trace_file, "}}");
+}
+
+static inline void
+trace_print_thread_name(int pid, uint64_t tid, const char *format, const char *name, uint64_t id)
+{
+	fprintf(trace_file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%lu,\"args\":{\"name\":\"", pid,
+	        tid);
+	fprintf(trace_file, format, name, id);
+	fprintf(trace_file, "\"}}");
+}
+
+/**
+ * Writes an event to the track of its request, and to the track of the worker that recorded it if the worker was
+ * busy with the request for the duration of the event
+ * @param worker the index of the worker that recorded the event
+ * @param event
+ */
+static void
+trace_print_event(int worker, struct trace_event *event)
+{
+	double ts = trace_timestamp_us(event->timestamp);
+
+	switch (event->type) {
+	case TRACE_EVENT_STATE: {
+		const char *state = sandbox_state_stringify(event->argument);
+		double      dur   = trace_duration_us(event->duration);
+
+		/* A sandbox leaves Allocated exactly once, so this names the track of its request */
+		if (event->argument == SANDBOX_ALLOCATED) {
+			trace_print_thread_name(TRACE_PID_REQUESTS, event->sandbox_id, "%s #%lu", event->module->name,
+			                        event->sandbox_id);
+		}
+
+		trace_print_slice(state, "state", TRACE_PID_REQUESTS, event->sandbox_id, ts, dur, event);
+		if (event->argument == SANDBOX_RUNNING_USER || event->argument == SANDBOX_RUNNING_SYS) {
+			trace_print_slice(state, "state", TRACE_PID_WORKERS, worker, ts, dur, event);
+		}
+		break;
+	}
+	case TRACE_EVENT_DEQUEUE: {
+		double dequeued = trace_timestamp_us(event->timestamp + event->duration);
+		trace_print_slice("Queued", "scheduler", TRACE_PID_REQUESTS, event->sandbox_id, ts,
+		                  trace_duration_us(event->duration), event);
+		trace_print_instant("Dequeue", "scheduler", TRACE_PID_WORKERS, worker, dequeued, event);
+		break;
+	}
+	case TRACE_EVENT_PREEMPTION: {
+		const char *decision = event->argument == event->sandbox_id          ? "Resume"
+		                       : event->argument == TRACE_SANDBOX_ID_NONE ? "Idle"
+		                                                                  : "Preempt";
+		trace_print_instant(decision, "scheduler", TRACE_PID_WORKERS, worker, ts, event);
+		trace_print_instant(decision, "scheduler", TRACE_PID_REQUESTS, event->sandbox_id, ts, event);
+		break;
+	}
+	case TRACE_EVENT_CACHE_FLUSH: {
+		trace_print_slice("Cache Flush", "cache", TRACE_PID_WORKERS, worker, ts,
+		                  trace_duration_us(event->duration), event);
+		break;
+	}
+	default:
+		panic("Unexpected trace event type %u\n", event->type);
+	}
+}
+
+/**
+ * Writes the events committed to every ring to the trace
+ * @returns the number of events written
+ */
+static uint64_t
+trace_drain(void)
+{
+	uint64_t written = 0;
+
+	pthread_mutex_lock(&trace_lock);
+	if (trace_file == NULL) goto done;
+
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		struct trace_ring *ring = &trace_rings[i];
+		uint64_t           head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+		uint64_t           tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+		for (; head != tail; head++, written++) {
+			trace_print_event(i, &ring->events[head & (TRACE_RING_CAPACITY - 1)]);
+		}
+
+		/* Hands the slots back to the worker only after their events have been formatted */
+		atomic_store_explicit(&ring->head, head, memory_order_release);
+	}
+
+done:
+	pthread_mutex_unlock(&trace_lock);
+	return written;
+}
+
+static void *
+trace_writer_main(void *dummy)
+{
+	/* runtime_cleanup drains the rings from a signal handler, so it must not interrupt this thread mid-drain */
+	sigset_t set;
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	struct timespec interval = { .tv_sec  = TRACE_WRITER_INTERVAL_US / 1000000,
+		                     .tv_nsec = (TRACE_WRITER_INTERVAL_US % 1000000) * 1000 };
+
+	while (true) {
+		if (trace_drain() == 0) nanosleep(&interval, NULL);
+	}
+
+	panic("Trace writer unexpectedly exited\n");
+	return NULL;
+}
+
+/**
+ * Opens the trace named by SLEDGE_TRACE, names the processes and worker tracks, and allocates a ring per worker
+ * Must run after the processor speed and the worker count are known
+ */
+void
+trace_init(void)
+{
+	char *trace_path = getenv("SLEDGE_TRACE");
+	if (trace_path == NULL) {
+		printf("\tTrace: Disabled\n");
+		return;
+	}
+
+	printf("\tTrace: %s\n", trace_path);
+	trace_file = fopen(trace_path, "w");
+	if (trace_file == NULL) {
+		perror("trace_init\n");
+		return;
+	}
+	setvbuf(trace_file, NULL, _IOFBF, TRACE_BUFFER_SIZE);
+
+	trace_epoch = __getcycles();
+
+	/* Every event is written with a leading separator, so the array starts with a metadata event */
+	fprintf(trace_file, "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Workers\"}}",
+	        TRACE_PID_WORKERS);
+	fprintf(trace_file, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Requests\"}}",
+	        TRACE_PID_REQUESTS);
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		trace_print_thread_name(TRACE_PID_WORKERS, i, "%s %lu", "Worker", i);
+	}
+
+	size_t rings_size = runtime_worker_threads_count * sizeof(struct trace_ring);
+	trace_rings       = aligned_alloc(CACHE_LINE_SIZE, rings_size);
+	if (unlikely(trace_rings == NULL)) panic_err();
+	memset(trace_rings, 0, rings_size);
+}
+
+/**
+ * Starts the writer thread, sharing the listener's core so that it does not disturb workers
+ */
+void
+trace_writer_initialize(void)
+{
+	assert(trace_rings != NULL);
+
+	cpu_set_t cs;
+	CPU_ZERO(&cs);
+	CPU_SET(LISTENER_THREAD_CORE_ID, &cs);
+
+	int ret = pthread_create(&trace_writer_thread_id, NULL, trace_writer_main, NULL);
+	if (unlikely(ret != 0)) panic("Failed to start the trace writer: %s\n", strerror(ret));
+
+	ret = pthread_setaffinity_np(trace_writer_thread_id, sizeof(cpu_set_t), &cs);
+	assert(ret == 0);
+
+	printf("\tTrace writer thread: %lx\n", trace_writer_thread_id);
+}
+
+/**
+ * Writes the events still in the rings and closes the trace. Events committed afterwards are discarded
+ */
+void
+trace_cleanup(void)
+{
+	if (trace_file == NULL) return;
+
+	trace_drain();
+
+	pthread_mutex_lock(&trace_lock);
+	printf("Trace\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu dropped events\n", i,
+		       atomic_load_explicit(&trace_rings[i].dropped, memory_order_relaxed));
+	}
+	fflush(stdout);
+
+	fprintf(trace_file, "\n]\n");
+	fflush(trace_file);
+	fclose(trace_file);
+	trace_file = NULL;
+	pthread_mutex_unlock(&trace_lock);
+}
@@ -0,0 +1,164 @@
+#include <assert.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "debuglog.h"
+#include "likely.h"
+#include "uring.h"
+
+static inline int
+uring_setup(unsigned entries, struct io_uring_params *params)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static inline int
+uring_enter(int file_descriptor, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return (int)syscall(__NR_io_uring_enter, file_descriptor, to_submit, min_complete, flags, NULL, 0);
+}
+
+/**
+ * Creates an io_uring instance and maps its rings
+ * @param ring
+ * @param entries submission queue size. Rounded up to a power of 2 by the kernel
+ * @param flags IORING_SETUP_* flags
+ * @returns 0 on success, -1 on error with errno set
+ */
+int
+uring_initialize(struct uring *ring, unsigned entries, unsigned flags)
+{
+	assert(ring != NULL);
+	memset(ring, 0, sizeof(struct uring));
+
+	struct io_uring_params params = { .flags = flags };
+
+	ring->file_descriptor = uring_setup(entries, &params);
+	if (unlikely(ring->file_descriptor < 0)) goto err_setup;
+
+	ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqes_size    = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	/* Since 5.4, the submission and completion rings share a single mapping */
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_ring_size > ring->sq_ring_size) ring->sq_ring_size = ring->cq_ring_size;
+		ring->cq_ring_size = ring->sq_ring_size;
+	}
+
+	ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                     ring->file_descriptor, IORING_OFF_SQ_RING);
+	if (unlikely(ring->sq_ring == MAP_FAILED)) goto err_map_sq_ring;
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ring = ring->sq_ring;
+	} else {
+		ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		                     ring->file_descriptor, IORING_OFF_CQ_RING);
+		if (unlikely(ring->cq_ring == MAP_FAILED)) goto err_map_cq_ring;
+	}
+
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                  ring->file_descriptor, IORING_OFF_SQES);
+	if (unlikely(ring->sqes == MAP_FAILED)) goto err_map_sqes;
+
+	char *sq_ring        = ring->sq_ring;
+	ring->sq_head        = (unsigned *)(sq_ring + params.sq_off.head);
+	ring->sq_tail        = (unsigned *)(sq_ring + params.sq_off.tail);
+	ring->sq_mask        = (unsigned *)(sq_ring + params.sq_off.ring_mask);
+	ring->sq_flags       = (unsigned *)(sq_ring + params.sq_off.flags);
+	ring->sq_array       = (unsigned *)(sq_ring + params.sq_off.array);
+	ring->sq_entries     = params.sq_entries;
+	ring->sq_local_tail  = *ring->sq_tail;
+
+	char *cq_ring = ring->cq_ring;
+	ring->cq_head = (unsigned *)(cq_ring + params.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq_ring + params.cq_off.tail);
+	ring->cq_mask = (unsigned *)(cq_ring + params.cq_off.ring_mask);
+	ring->cqes    = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+
+	return 0;
+
+err_map_sqes:
+	if (ring->cq_ring != ring->sq_ring) munmap(ring->cq_ring, ring->cq_ring_size);
+err_map_cq_ring:
+	munmap(ring->sq_ring, ring->sq_ring_size);
+err_map_sq_ring:
+	close(ring->file_descriptor);
+err_setup:
+	ring->file_descriptor = -1;
+	return -1;
+}
+
+void
+uring_deinitialize(struct uring *ring)
+{
+	assert(ring != NULL);
+	if (ring->file_descriptor < 0) return;
+
+	munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ring != ring->sq_ring) munmap(ring->cq_ring, ring->cq_ring_size);
+	munmap(ring->sq_ring, ring->sq_ring_size);
+	close(ring->file_descriptor);
+	ring->file_descriptor = -1;
+}
+
+/**
+ * Reserves and zeroes the next submission queue entry. The entry is not visible to the kernel until uring_submit
+ * @returns sqe or NULL if the submission queue is full
+ */
+struct io_uring_sqe *
+uring_get_sqe(struct uring *ring)
+{
+	if (unlikely(uring_sq_space_left(ring) == 0)) return NULL;
+
+	unsigned             index = ring->sq_local_tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe   = &ring->sqes[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	ring->sq_array[index] = index;
+	ring->sq_local_tail++;
+	return sqe;
+}
+
+/**
+ * Publishes prepared entries to the kernel and optionally waits for completions
+ * Only enters the kernel if there is something to submit, wait for, or flush
+ * @param ring
+ * @param wait_count minimum number of completions to wait for
+ * @returns number of entries submitted, or -1 on error with errno set
+ */
+int
+uring_submit(struct uring *ring, unsigned wait_count)
+{
+	/* Counts from the kernel's head, so entries left unconsumed by an interrupted call are retried */
+	unsigned to_submit = ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+	__atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+	if (to_submit == 0 && wait_count == 0 && !uring_needs_enter(ring)) return 0;
+
+	unsigned flags = 0;
+	if (wait_count > 0 || uring_needs_enter(ring)) flags |= IORING_ENTER_GETEVENTS;
+
+	int rc;
+	do {
+		rc = uring_enter(ring->file_descriptor, to_submit, wait_count, flags);
+	} while (rc < 0 && errno == EINTR && wait_count == 0);
+
+	return rc;
+}
+
+/**
+ * Blocks until completions are available without submitting. Safe to call while another thread prepares and submits
+ * entries under its own synchronization
+ * @param ring
+ * @param wait_count minimum number of completions to wait for
+ * @returns 0 on success, or -1 on error with errno set
+ */
+int
+uring_wait(struct uring *ring, unsigned wait_count)
+{
+	int rc = uring_enter(ring->file_descriptor, 0, wait_count, IORING_ENTER_GETEVENTS);
+	return rc < 0 ? -1 : 0;
+}
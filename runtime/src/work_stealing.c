@@ -0,0 +1,103 @@
+#include <assert.h>
+#include <stdio.h>
+#include <threads.h>
+
+#include "local_runqueue.h"
+#include "work_stealing.h"
+#include "worker_thread.h"
+
+/* Response to a steal request from a victim with no eligible sandbox */
+#define WORK_STEALING_DECLINED ((struct sandbox *)1)
+
+struct work_stealing_worker work_stealing_workers[RUNTIME_MAX_WORKER_COUNT];
+
+/* Index of the worker this worker has an outstanding request to, or -1 */
+static thread_local int work_stealing_victim = -1;
+
+/**
+ * Assumption: Called by the main thread before workers start
+ */
+void
+work_stealing_initialize(void)
+{
+	for (int i = 0; i < RUNTIME_MAX_WORKER_COUNT; i++) {
+		atomic_init(&work_stealing_workers[i].thief, -1);
+		atomic_init(&work_stealing_workers[i].transfer, NULL);
+		work_stealing_workers[i].stolen  = 0;
+		work_stealing_workers[i].donated = 0;
+	}
+}
+
+/**
+ * Posts a steal request to the worker with the longest runqueue, unless a request is already outstanding
+ * A worker's runqueue includes its running sandbox, so only workers with at least two sandboxes are considered
+ */
+void
+work_stealing_request(void)
+{
+	if (work_stealing_victim >= 0) return;
+
+	int      victim        = -1;
+	uint32_t victim_length = 1;
+	for (int i = 1; i < runtime_worker_threads_count; i++) {
+		int      candidate = (worker_thread_idx + i) % runtime_worker_threads_count;
+		uint32_t length    = atomic_load_explicit(&local_runqueue_lengths[candidate].value, memory_order_relaxed);
+		if (length > victim_length) {
+			victim        = candidate;
+			victim_length = length;
+		}
+	}
+	if (victim < 0) return;
+
+	/* Another thief may have claimed the victim first */
+	int expected = -1;
+	if (atomic_compare_exchange_strong(&work_stealing_workers[victim].thief, &expected, worker_thread_idx))
+		work_stealing_victim = victim;
+}
+
+/**
+ * Answers a pending steal request from another worker and receives the response to this worker's own request
+ * Called at every scheduling decision, including from the SIGALRM handler
+ */
+void
+work_stealing_poll(void)
+{
+	struct work_stealing_worker *self = &work_stealing_workers[worker_thread_idx];
+
+	int thief = atomic_load(&self->thief);
+	if (thief >= 0) {
+		struct sandbox *sandbox = local_runqueue_steal();
+		if (sandbox != NULL) {
+			self->donated++;
+		} else {
+			sandbox = WORK_STEALING_DECLINED;
+		}
+
+		atomic_store(&work_stealing_workers[thief].transfer, sandbox);
+		atomic_store(&self->thief, -1);
+	}
+
+	if (work_stealing_victim < 0) return;
+
+	struct sandbox *sandbox = atomic_load(&self->transfer);
+	if (sandbox == NULL) return;
+
+	atomic_store(&self->transfer, NULL);
+	work_stealing_victim = -1;
+	if (sandbox == WORK_STEALING_DECLINED) return;
+
+	assert(sandbox->state == SANDBOX_RUNNABLE && !sandbox->has_run);
+	local_runqueue_add(sandbox);
+	self->stolen++;
+}
+
+void
+work_stealing_stats_print()
+{
+	printf("Work Stealing\n");
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		printf("Worker %d: %lu stolen, %lu donated\n", i, work_stealing_workers[i].stolen,
+		       work_stealing_workers[i].donated);
+	}
+	fflush(stdout);
+}
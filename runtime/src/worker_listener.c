@@ -0,0 +1,188 @@
+#include <assert.h>
+#include <errno.h>
+#include <linux/filter.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "admissions_control.h"
+#include "arch/getcycles.h"
+#include "client_socket.h"
+#include "current_sandbox.h"
+#include "debuglog.h"
+#include "panic.h"
+#include "sandbox_functions.h"
+#include "sandbox_request.h"
+#include "sandbox_set_as_runnable.h"
+#include "worker_listener.h"
+#include "worker_thread.h"
+
+extern uint32_t runtime_first_worker_processor;
+
+/* Epoll instances monitoring the per-worker module sockets. Indexed by worker_thread_idx */
+int worker_listener_epoll_file_descriptors[RUNTIME_MAX_WORKER_COUNT];
+
+/**
+ * Attaches a classic BPF program to a reuseport group that selects the socket at index (cpu - first worker core).
+ * Sockets are indexed in the order they were added to the group, which is worker order. If the packet was processed
+ * on a core without a worker, the index is out of range and the kernel falls back to hashing.
+ * @param socket_descriptor any socket in the reuseport group
+ * @returns 0 on success, -1 on error
+ */
+static inline int
+worker_listener_attach_steering(int socket_descriptor)
+{
+	struct sock_filter code[] = {
+		/* A = current cpu */
+		{ BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+		/* A = A - first worker core */
+		{ BPF_ALU | BPF_SUB | BPF_K, 0, 0, runtime_first_worker_processor },
+		/* return A */
+		{ BPF_RET | BPF_A, 0, 0, 0 },
+	};
+	struct sock_fprog program = { .len = sizeof(code) / sizeof(code[0]), .filter = code };
+
+	return setsockopt(socket_descriptor, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program));
+}
+
+/**
+ * Creates the per-worker accept epoll instances
+ * Assumption: Called by the main thread before modules are loaded
+ */
+void
+worker_listener_initialize(void)
+{
+	for (int i = 0; i < runtime_worker_threads_count; i++) {
+		worker_listener_epoll_file_descriptors[i] = epoll_create1(EPOLL_CLOEXEC);
+		if (unlikely(worker_listener_epoll_file_descriptors[i] < 0)) panic_err();
+	}
+}
+
+/**
+ * Creates a listening socket for each worker and registers it on that worker's accept epoll instance
+ * @param module
+ * @param create_socket function that creates, binds, and listens on a SO_REUSEPORT socket for the module
+ * @returns 0 on success, -1 on error
+ */
+int
+worker_listener_register_module(struct module *module, int (*create_socket)(struct module *module))
+{
+	assert(module != NULL);
+	assert(create_socket != NULL);
+
+	int rc = 0;
+	int i  = 0;
+
+	for (; i < runtime_worker_threads_count; i++) {
+		int socket_descriptor = create_socket(module);
+		if (unlikely(socket_descriptor < 0)) goto err;
+		module->worker_socket_descriptors[i] = socket_descriptor;
+
+		struct epoll_event accept_evt;
+		accept_evt.data.ptr = (void *)module;
+		accept_evt.events   = EPOLLIN;
+		rc = epoll_ctl(worker_listener_epoll_file_descriptors[i], EPOLL_CTL_ADD, socket_descriptor, &accept_evt);
+		if (unlikely(rc < 0)) {
+			i++;
+			goto err;
+		}
+	}
+
+	/* Steering is an optimization, so fall back to the kernel's hashing on failure */
+	if (unlikely(worker_listener_attach_steering(module->worker_socket_descriptors[0]) < 0)) {
+		debuglog("Failed to attach reuseport steering to %s: %s\n", module->name, strerror(errno));
+	}
+
+	rc = 0;
+done:
+	return rc;
+err:
+	while (i-- > 0) close(module->worker_socket_descriptors[i]);
+	rc = -1;
+	goto done;
+}
+
+/**
+ * Performs admissions control on a client request and places the resulting sandbox on the local runqueue, bypassing
+ * the global request scheduler. Rejected requests are answered with 503 and the connection is closed
+ * @param module
+ * @param client_socket nonblocking client socket
+ * @param client_address
+ * @param request_arrival_timestamp cycles
+ * @param connection_request_count requests previously served on the connection
+ */
+void
+worker_listener_dispatch(struct module *module, int client_socket, struct sockaddr *client_address,
+                         uint64_t request_arrival_timestamp, uint32_t connection_request_count)
+{
+	http_total_increment_request();
+
+	/*
+	 * Perform admissions control.
+	 * If 0, workload was rejected, so close with 503 and continue
+	 */
+	uint64_t work_admitted = admissions_control_decide(module->admissions_info.estimate);
+	if (work_admitted == 0) {
+		client_socket_send(client_socket, 503);
+		if (unlikely(close(client_socket) < 0)) debuglog("Error closing client socket - %s", strerror(errno));
+
+		return;
+	}
+
+	struct sandbox_request *sandbox_request = sandbox_request_allocate(module, client_socket, client_address,
+	                                                                   request_arrival_timestamp, work_admitted);
+	sandbox_request->connection_request_count = connection_request_count;
+
+	struct sandbox *sandbox = sandbox_allocate(sandbox_request);
+	if (unlikely(sandbox == NULL)) {
+		client_socket_send(client_socket, 503);
+		client_socket_close(client_socket, client_address);
+		free(sandbox_request);
+		return;
+	}
+
+	sandbox_set_as_runnable(sandbox, SANDBOX_INITIALIZED);
+}
+
+/**
+ * Accepts all pending client requests on the calling worker's sockets, performs admissions control, and places the
+ * resulting sandboxes on the local runqueue
+ */
+void
+worker_listener_accept(void)
+{
+	struct epoll_event epoll_events[RUNTIME_MAX_EPOLL_EVENTS];
+
+	int descriptor_count = epoll_wait(worker_listener_epoll_file_descriptors[worker_thread_idx], epoll_events,
+	                                  RUNTIME_MAX_EPOLL_EVENTS, 0);
+	if (descriptor_count < 0) {
+		if (errno == EINTR) return;
+		panic_err();
+	}
+
+	uint64_t request_arrival_timestamp = __getcycles();
+	for (int i = 0; i < descriptor_count; i++) {
+		/* Assumption: We have only registered EPOLLIN events, so we should see no others here */
+		assert((epoll_events[i].events & EPOLLIN) == EPOLLIN);
+
+		struct module *module = (struct module *)epoll_events[i].data.ptr;
+		assert(module);
+
+		struct sockaddr_in client_address;
+		socklen_t          address_length = sizeof(client_address);
+
+		/* Accept as many requests as possible, terminating when we would have blocked */
+		while (true) {
+			int client_socket = accept4(module->worker_socket_descriptors[worker_thread_idx],
+			                            (struct sockaddr *)&client_address, &address_length, SOCK_NONBLOCK);
+			if (unlikely(client_socket < 0)) {
+				if (errno == EWOULDBLOCK || errno == EAGAIN) break;
+
+				panic("accept4: %s", strerror(errno));
+			}
+
+			worker_listener_dispatch(module, client_socket, (struct sockaddr *)&client_address,
+			                         request_arrival_timestamp, 0);
+		}
+	}
+}
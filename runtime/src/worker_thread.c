@@ -6,7 +6,9 @@
 #include <stdlib.h>
 #include <threads.h>
 
+#include "connection_table.h"
 #include "current_sandbox.h"
+#include "io_engine.h"
 #include "local_completion_queue.h"
 #include "local_runqueue.h"
 #include "local_runqueue_list.h"
@@ -28,6 +30,9 @@ thread_local int worker_thread_epoll_file_descriptor;
 /* Used to index into global arguments and deadlines arrays */
 thread_local int worker_thread_idx;
 
+/* Sandboxes of this worker in the SANDBOX_ASLEEP state, awaiting I/O */
+thread_local uint32_t worker_thread_asleep_count = 0;
+
 /* Used for syncing switches. When thread returns to idle loop, set to true, such
  * that an alarm knows to coop sched it... */
 thread_local bool worker_waiting_for_alrm;
@@ -49,6 +54,7 @@ worker_thread_main(void *argument)
 
 	/* Index was passed via argument */
 	worker_thread_idx = *(int *)argument;
+	generic_thread_initialize(worker_thread_idx);
 
     worker_waiting_for_alrm = false;
 
@@ -66,10 +72,17 @@ worker_thread_main(void *argument)
 	printf("~~~~~~~~~~~~~~~Worker FD: %p \n", &worker_thread_epoll_file_descriptor);
 	if (unlikely(worker_thread_epoll_file_descriptor < 0)) panic_err();
 
+	/* Initialize I/O engine */
+	io_engine_thread_initialize();
+
+	/* Initialize table of idle keep-alive connections */
+	if (runtime_keepalive_enabled) connection_table_initialize();
+
 	/* Unmask signals, unless the runtime has disabled preemption */
 	if (runtime_preemption_enabled) {
 		software_interrupt_unmask_signal(SIGALRM);
 		software_interrupt_unmask_signal(SIGUSR1);
+		software_interrupt_arm_thread_timer();
 	}
 
 	/* Idle Loop */
@@ -0,0 +1,26 @@
+#include <stdio.h>
+
+#define WASM_PAGE_SIZE (1024 * 64)
+
+/*
+ * Grows linear memory by the number of WebAssembly pages read from stdin using a single memory.grow instruction, and
+ * then writes a byte to each new page. Used to benchmark the cost of linear memory growth against page count
+ */
+int
+main(int argc, char **argv)
+{
+	unsigned long pages = 0;
+	scanf("%lu", &pages);
+
+	long previous = __builtin_wasm_memory_grow(0, pages);
+	if (previous < 0) {
+		printf("grow failed\n");
+		return 0;
+	}
+
+	char *base = (char *)(previous * WASM_PAGE_SIZE);
+	for (unsigned long i = 0; i < pages; i++) base[i * WASM_PAGE_SIZE] = 1;
+
+	printf("%ld\n", previous);
+	return 0;
+}
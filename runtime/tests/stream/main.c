@@ -0,0 +1,23 @@
+#include <stdio.h>
+#include <unistd.h>
+
+/*
+ * Reads the request body from stdin until its end and writes the number of bytes read. Used to check that a module
+ * that streams request bodies receives bodies larger than its request buffer in full
+ */
+int
+main(int argc, char **argv)
+{
+	char    buffer[4096];
+	long    total = 0;
+	ssize_t bytes_read;
+
+	while ((bytes_read = read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) total += bytes_read;
+	if (bytes_read < 0) {
+		printf("read failed\n");
+		return 0;
+	}
+
+	printf("%ld\n", total);
+	return 0;
+}
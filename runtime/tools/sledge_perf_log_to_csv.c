@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sandbox_perf_log_record.h"
+
+/*
+ * Converts a binary sandbox perf log, as written by the runtime when SLEDGE_SANDBOX_PERF_LOG is set, into the CSV
+ * format consumed by the experiment scripts
+ *
+ * Usage: sledge_perf_log_to_csv <perf log> > perf.csv
+ */
+
+int
+main(int argc, char **argv)
+{
+	int                            rc  = 1;
+	FILE *                         log = NULL;
+	struct sandbox_perf_log_header header;
+	struct sandbox_perf_log_record record;
+	size_t                         bytes_read = 0;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <perf log>\n", argv[0]);
+		goto done;
+	}
+
+	log = fopen(argv[1], "rb");
+	if (log == NULL) {
+		perror(argv[1]);
+		goto done;
+	}
+
+	if (fread(&header, sizeof(header), 1, log) != 1
+	    || memcmp(header.magic, SANDBOX_PERF_LOG_MAGIC, sizeof(header.magic)) != 0) {
+		fprintf(stderr, "%s is not a sandbox perf log\n", argv[1]);
+		goto close_log;
+	}
+
+	if (header.version != SANDBOX_PERF_LOG_VERSION || header.record_size != sizeof(record)
+	    || header.state_count != SANDBOX_PERF_LOG_STATE_COUNT) {
+		fprintf(stderr, "%s has version %u with %u byte records, expected version %u with %zu byte records\n",
+		        argv[1], header.version, header.record_size, SANDBOX_PERF_LOG_VERSION, sizeof(record));
+		goto close_log;
+	}
+
+	printf("id,module,port,state,deadline,actual,queued,uninitialized,allocated,initialized,runnable,preempted,"
+	       "running_sys,running_user,asleep,returned,complete,error,proc_MHz,memory\n");
+
+	while ((bytes_read = fread(&record, 1, sizeof(record), log)) == sizeof(record)) {
+		printf("%lu,%.*s,%d,%.*s,%lu,%lu,%lu", record.id, (int)sizeof(record.module), record.module, record.port,
+		       (int)sizeof(record.state), record.state, record.relative_deadline, record.total_time,
+		       record.queued);
+		for (int i = 0; i < SANDBOX_PERF_LOG_STATE_COUNT; i++) printf(",%lu", record.duration_of_state[i]);
+		printf(",%u,%u\n", header.processor_speed_MHz, record.memory_size);
+	}
+
+	if (ferror(log)) {
+		perror(argv[1]);
+		goto close_log;
+	}
+
+	/* A trailing partial record means the runtime was killed mid-write. The complete records are still valid */
+	if (bytes_read > 0) fprintf(stderr, "%s ends with a partial record of %zu bytes\n", argv[1], bytes_read);
+
+	rc = 0;
+close_log:
+	fclose(log);
+done:
+	return rc;
+}